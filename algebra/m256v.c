@@ -7,6 +7,7 @@
 
 #include "gf256.h"
 #include "m256v.h"
+#include "m256v_kern.h"
 
 /* Shorten symbol names for simpler code */
 #define get_el_offs	m256v_get_el_offs
@@ -72,8 +73,7 @@ void m256v_swap_rows(m256v* M, int r1, int r2)
 
 void m256v_clear_row(m256v* M, int r)
 {
-	for (int i = 0; i < M->n_col; ++i)
-		set_el(M, r, i, 0);
+	memset(M->e + get_el_offs(M, r, 0), 0, M->n_col);
 }
 
 void m256v_mult_row(m256v* M, int r, uint8_t alpha)
@@ -85,13 +85,7 @@ void m256v_mult_row(m256v* M, int r, uint8_t alpha)
 	}
 
 	/* General case:  Nonzero alpha */
-	const uint8_t log_alpha = flog(alpha);
-	for (int j = 0; j < M->n_col; ++j) {
-		uint8_t v = get_el(M, r, j);
-		if (v != 0) {
-			set_el(M, r, j, fexp(flog(v) + log_alpha));
-		}
-	}
+	m256v_kern_active->mult(M->e + get_el_offs(M, r, 0), M->n_col, alpha);
 }
 
 void m256v_multadd_row(const m256v* M1,
@@ -114,31 +108,43 @@ void m256v_multadd_row_from(const m256v* M1,
 
 	if (alpha == 0)
 		return;
-	if (alpha == 1) {
-		uint8_t* s = M1->e + get_el_offs(M1, r1, offs);
-		uint8_t* t = Mt->e + get_el_offs(Mt, rt, offs);
-		uint8_t* end = M1->e + get_el_offs(M1, r1, M1->n_col);
-		while (s < end) {
-			*t++ ^= *s++;
-		}
-	} else {
-		const int log_alpha = flog(alpha);
-		uint8_t* s = M1->e + get_el_offs(M1, r1, offs);
-		uint8_t* t = Mt->e + get_el_offs(Mt, rt, offs);
-		uint8_t* end = M1->e + get_el_offs(M1, r1, M1->n_col);
-		while (s < end) {
-			/* Mt[rt, i] += exp(log_alpha + log(M1[r1, i]))
-			 * if said logarithm is defined.
-			 *
-			 * Otherwise, M[rt, i] is unchanged.
-			 */
-			const uint8_t ve = *s++;
-			if (ve != 0) {
-				*t ^= fexp(log_alpha + flog(ve));
-			}
-			++t;
+
+	const uint8_t* s = M1->e + get_el_offs(M1, r1, offs);
+	uint8_t* t = Mt->e + get_el_offs(Mt, rt, offs);
+	m256v_kern_active->multadd(t, s, M1->n_col - offs, alpha);
+}
+
+void m256v_multadd_rows(const m256v* M1,
+			const int* rows,
+			const uint8_t* alphas,
+			int n,
+			m256v* Mt,
+			int rt)
+{
+	assert (M1->n_col == Mt->n_col);
+
+	/* Pass the nonzero terms to the kernel in batches */
+	enum { batch = 32 };
+	const uint8_t* s[batch];
+	uint8_t a[batch];
+	uint8_t* t = Mt->e + get_el_offs(Mt, rt, 0);
+	int k = 0;
+	for (int j = 0; j < n; ++j) {
+		if (alphas[j] == 0)
+			continue;
+		assert (M1 != Mt || rows[j] != rt);
+		s[k] = M1->e + get_el_offs(M1, rows[j], 0);
+		a[k] = alphas[j];
+		if (++k == batch) {
+			m256v_kern_active->multadd_multi(t, s, a, k, Mt->n_col);
+			k = 0;
 		}
 	}
+	if (k == 1) {
+		m256v_kern_active->multadd(t, s[0], Mt->n_col, a[0]);
+	} else if (k > 0) {
+		m256v_kern_active->multadd_multi(t, s, a, k, Mt->n_col);
+	}
 }
 
 void m256v_copy_row(const m256v* M1,
@@ -148,9 +154,11 @@ void m256v_copy_row(const m256v* M1,
 {
 	assert (M1->n_col == Mt->n_col);
 
-	for (int i = 0; i < Mt->n_col; ++i) {
-		set_el(Mt, rt, i, get_el(M1, r1, i));
-	}
+	if (M1->e == Mt->e && r1 == rt)
+		return;
+	memcpy(Mt->e + get_el_offs(Mt, rt, 0),
+		M1->e + get_el_offs(M1, r1, 0),
+		Mt->n_col);
 }
 
 int m256v_row_iszero(const m256v* M, int r)
@@ -181,19 +189,22 @@ void m256v_swap_cols(m256v* M, int c1, int c2)
 
 void m256v_mult_col_from(m256v* M, int c, int offs, uint8_t alpha)
 {
-	if (alpha != 0) {
-		const int log_alpha = flog(alpha);
-		for (int j = offs; j < M->n_row; ++j) {
-			uint8_t val = get_el(M, j, c);
-			if (val != 0) {
-				val = fexp(flog(val) + log_alpha);
-				set_el(M, j, c, val);
-			}
-		}
-	} else {
-		for (int j = offs; j < M->n_row; ++j) {
-			set_el(M, j, c, 0);
-		}
+	if (alpha == 1)
+		return;
+
+	/* Gather the strided column into a contiguous buffer so the
+	 * row kernels can be used, then scatter it back.
+	 */
+	uint8_t buf[256];
+	for (int j0 = offs; j0 < M->n_row; j0 += (int)sizeof(buf)) {
+		int n = M->n_row - j0;
+		if (n > (int)sizeof(buf))
+			n = (int)sizeof(buf);
+		for (int j = 0; j < n; ++j)
+			buf[j] = get_el(M, j0 + j, c);
+		m256v_kern_active->mult(buf, n, alpha);
+		for (int j = 0; j < n; ++j)
+			set_el(M, j0 + j, c, buf[j]);
 	}
 }
 
@@ -209,8 +220,49 @@ void m256v_copy_col(const m256v* M1,
 	}
 }
 
+/* Blocking parameters of m256v_mul_add:  number of rows of B
+ * accumulated per kernel call, and width of the column tiles in bytes.
+ */
+#define MUL_KB		32
+#define MUL_TILE	4096
+
+void m256v_mul_add(const m256v* A, const m256v* B, m256v* C)
+{
+	assert(A->n_col == B->n_row);
+	assert(A->n_row == C->n_row);
+	assert(B->n_col == C->n_col);
+
+	int rows[MUL_KB];
+	uint8_t alphas[MUL_KB];
+	for (int i = 0; i < MUL_KB; ++i)
+		rows[i] = i;
+
+	for (int ct = 0; ct < C->n_col; ct += MUL_TILE) {
+		const int w = (C->n_col - ct < MUL_TILE) ? C->n_col - ct : MUL_TILE;
+		m256v Ct = m256v_get_subview(C, 0, ct, C->n_row, w);
+		for (int kb = 0; kb < A->n_col; kb += MUL_KB) {
+			const int nb = (A->n_col - kb < MUL_KB) ? A->n_col - kb : MUL_KB;
+			m256v Bt = m256v_get_subview(B, kb, ct, nb, w);
+			for (int i = 0; i < C->n_row; ++i) {
+				const uint8_t* a = A->e + get_el_offs(A, i, kb);
+				memcpy(alphas, a, nb);
+				m256v_multadd_rows(&Bt, rows, alphas, nb, &Ct, i);
+			}
+		}
+	}
+}
+
+void m256v_mul(const m256v* A, const m256v* B, m256v* AB_out)
+{
+	m256v_clear(AB_out);
+	m256v_mul_add(A, B, AB_out);
+}
+
 #define MV_GEN_TYPE	m256v
 #define MV_GEN_PREFIX	m256v
 #define MV_GEN_ELTYPE	uint8_t
 #define MV_GEN_DEFINITIONS
+#define MV_GEN_CUSTOM_MUL		/* see m256v_mul above */
+#define MV_GEN_CUSTOM_LU_DECOMP		/* see m256v_lu.c */
+#define MV_GEN_CUSTOM_COL_OPS		/* see m256v_transpose.c */
 #include "mv_generic.h"
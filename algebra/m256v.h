@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "par_run.h"
 
 typedef struct {
 	int n_row;		/* number of rows */
@@ -79,6 +80,20 @@ void m256v_multadd_row_from(const m256v* M1,
 			uint8_t alpha,
 			m256v* Mt,
 			int rt);
+
+/**	Add several scaled rows to a row.
+ *
+ *	Computes Mt[rt] += sum_j alphas[j] * M1[rows[j]] for 0 <= j < n.
+ *	This has the same effect as a sequence of m256v_multadd_row
+ *	calls, but each part of the target row is read and written only
+ *	once.  The source rows must not include the target row.
+ */
+void m256v_multadd_rows(const m256v* M1,
+			const int* rows,
+			const uint8_t* alphas,
+			int n,
+			m256v* Mt,
+			int rt);
 void m256v_copy_row(const m256v* M1,
 			int r1,
 			m256v* Mt,
@@ -97,6 +112,59 @@ void m256v_copy_col(const m256v* M1,
 			int ct);
 /*@}*/
 
+/** \defgroup MatrixMult		Matrix multiplication */
+/*@{*/
+
+/**	Compute C += A*B.
+ *
+ *	Each row of C accumulates the rows of B, scaled by the
+ *	corresponding entries of A, with the multi-row kernel.  The work
+ *	is blocked over the columns of B and C and the inner dimension
+ *	so that the active part of B stays in cache.  Zero entries of A
+ *	are skipped, which makes this efficient for sparse A as well.
+ *
+ *	C must not overlap with A or B.  (m256v_mul, the C = A*B
+ *	variant, is declared with the generic operations.)
+ */
+void m256v_mul_add(const m256v* A, const m256v* B, m256v* C);
+
+/*@}*/
+
+/** \defgroup LUMt		Multithreaded LU decomposition */
+/*@{*/
+
+/**	LU decomposition using up to n_threads threads.
+ *
+ *	Same contract and result as m256v_LU_decomp_inplace, which is
+ *	this function with n_threads = 1.  The trailing updates are split
+ *	into up to n_threads tasks (at most 256), which are run with run,
+ *	e.g., on a thread pool.  The panel factorizations stay on the
+ *	calling thread, which limits the speedup.  If run is NULL, all
+ *	of the work is done on the calling thread.
+ */
+int m256v_LU_decomp_inplace_mt(m256v* A, int* rowperm, int* colperm,
+				int n_threads, par_run_fn run);
+
+/**	Continue an LU decomposition after appending rows.
+ *
+ *	The first n_old rows of A hold an LU decomposition of rank
+ *	`rank', with the permutations rowperm and colperm, as computed
+ *	by m256v_LU_decomp_inplace; the rows from n_old on are new, in
+ *	the original column order.  They are eliminated against the
+ *	pivots found so far, and the decomposition is continued, which
+ *	costs O((n_row - n_old) * rank * n_col) plus the elimination of
+ *	the remaining columns.  rowperm is extended to A->n_row entries.
+ *
+ *	The result is an LU decomposition of the whole of A, but not
+ *	necessarily the one m256v_LU_decomp_inplace would compute.
+ *
+ *	@return	The rank of A.
+ */
+int m256v_LU_decomp_append(m256v* A, int n_old, int rank,
+				int* rowperm, int* colperm);
+
+/*@}*/
+
 /* Inline definitions */
 #ifndef PY_CFFI
 
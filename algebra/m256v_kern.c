@@ -0,0 +1,267 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gf256.h"
+#include "m256v_kern.h"
+
+uint8_t m256v_kern_nibtab[256][32] __attribute__((aligned(64)));
+uint64_t m256v_kern_affine[256];
+
+/* Scalar kernels
+ *
+ * These use the log/exp tables and work on any CPU.
+ */
+
+static void multadd_scalar(uint8_t* t, const uint8_t* s, size_t n, uint8_t alpha)
+{
+	if (alpha == 0)
+		return;
+	if (alpha == 1) {
+		for (size_t i = 0; i < n; ++i)
+			t[i] ^= s[i];
+		return;
+	}
+
+	const int log_alpha = gf256_log(alpha);
+	for (size_t i = 0; i < n; ++i) {
+		/* t[i] += exp(log_alpha + log(s[i])) if said logarithm
+		 * is defined.
+		 *
+		 * Otherwise, t[i] is unchanged.
+		 */
+		const uint8_t ve = s[i];
+		if (ve != 0) {
+			t[i] ^= gf256_exp(log_alpha + gf256_log(ve));
+		}
+	}
+}
+
+static void mult_scalar(uint8_t* t, size_t n, uint8_t alpha)
+{
+	if (alpha == 0) {
+		memset(t, 0, n);
+		return;
+	}
+	if (alpha == 1)
+		return;
+
+	const int log_alpha = gf256_log(alpha);
+	for (size_t i = 0; i < n; ++i) {
+		const uint8_t v = t[i];
+		if (v != 0) {
+			t[i] = gf256_exp(gf256_log(v) + log_alpha);
+		}
+	}
+}
+
+static void multadd_multi_scalar(uint8_t* t,
+				const uint8_t* const* s,
+				const uint8_t* alpha,
+				int k,
+				size_t n)
+{
+	/* Work on the target in blocks small enough to stay in L1
+	 * while all the sources are added in.
+	 */
+	const size_t blk = 256;
+	for (size_t i = 0; i < n; i += blk) {
+		const size_t m = (n - i < blk) ? n - i : blk;
+		for (int j = 0; j < k; ++j)
+			multadd_scalar(t + i, s[j] + i, m, alpha[j]);
+	}
+}
+
+const m256v_kern m256v_kern_scalar = {
+	.name = "scalar",
+	.multadd = multadd_scalar,
+	.mult = mult_scalar,
+	.multadd_multi = multadd_multi_scalar,
+};
+
+/* Kernel selection */
+
+typedef struct {
+	const m256v_kern* kern;
+	int (*supported)(void);
+} kern_entry;
+
+static int always(void)
+{
+	return 1;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#ifdef M256V_KERN_SSSE3
+static int have_ssse3(void)
+{
+	return __builtin_cpu_supports("ssse3");
+}
+#endif
+#ifdef M256V_KERN_AVX2
+static int have_avx2(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+#endif
+#ifdef M256V_KERN_AVX512
+static int have_avx512(void)
+{
+	return __builtin_cpu_supports("avx512f")
+		&& __builtin_cpu_supports("avx512bw");
+}
+#endif
+#ifdef M256V_KERN_GFNI
+static int have_gfni(void)
+{
+	return __builtin_cpu_supports("avx512f")
+		&& __builtin_cpu_supports("avx512bw")
+		&& __builtin_cpu_supports("gfni");
+}
+#endif
+#endif
+
+/* Kernel sets, in increasing order of preference */
+static const kern_entry kern_table[] = {
+	{ &m256v_kern_scalar,	always },
+#ifdef M256V_KERN_SSSE3
+	{ &m256v_kern_ssse3,	have_ssse3 },
+#endif
+#ifdef M256V_KERN_AVX2
+	{ &m256v_kern_avx2,	have_avx2 },
+#endif
+#ifdef M256V_KERN_AVX512
+	{ &m256v_kern_avx512,	have_avx512 },
+#endif
+#ifdef M256V_KERN_GFNI
+	{ &m256v_kern_gfni,	have_gfni },
+#endif
+};
+
+#define kern_table_sz	((int)(sizeof(kern_table) / sizeof(kern_table[0])))
+
+const m256v_kern* m256v_kern_active = &m256v_kern_scalar;
+
+const m256v_kern* m256v_kern_find(const char* name)
+{
+	for (int i = 0; i < kern_table_sz; ++i) {
+		if (strcmp(kern_table[i].kern->name, name) == 0) {
+			if (!kern_table[i].supported())
+				return NULL;
+			return kern_table[i].kern;
+		}
+	}
+	return NULL;
+}
+
+int m256v_kern_select(const char* name)
+{
+	const m256v_kern* k = m256v_kern_find(name);
+	if (k == NULL)
+		return -1;
+	m256v_kern_active = k;
+	return 0;
+}
+
+int m256v_kern_selftest(const m256v_kern* k)
+{
+	/* The buffers are offset by one byte from a 64 byte boundary
+	 * and have a ragged length, so that the vector loops as well as
+	 * the tail handling are checked.
+	 */
+	uint8_t buf[64 + 1 + 256 + 7] __attribute__((aligned(64)));
+	uint8_t* x = buf + 1;
+	const size_t n = 256 + 7;
+	for (int a = 0; a < 256; ++a) {
+		for (size_t i = 0; i < n; ++i)
+			x[i] = (uint8_t)i;
+		k->mult(x, n, a);
+		for (size_t i = 0; i < n; ++i) {
+			if (x[i] != gf256_mul(a, (uint8_t)i))
+				return 0;
+		}
+
+		uint8_t s[256 + 7];
+		for (size_t i = 0; i < n; ++i) {
+			s[i] = (uint8_t)(i * 7 + 3);
+			x[i] = (uint8_t)i;
+		}
+		k->multadd(x, s, n, a);
+		for (size_t i = 0; i < n; ++i) {
+			if (x[i] != ((uint8_t)i ^ gf256_mul(a, s[i])))
+				return 0;
+		}
+
+		/* Three sources: s, the identity and s again */
+		uint8_t id[256 + 7];
+		for (size_t i = 0; i < n; ++i) {
+			id[i] = (uint8_t)i;
+			x[i] = 0;
+		}
+		const uint8_t* srcs[3] = { s, id, s };
+		const uint8_t alphas[3] = { a, 1, a ^ 0x5b };
+		k->multadd_multi(x, srcs, alphas, 3, n);
+		for (size_t i = 0; i < n; ++i) {
+			if (x[i] != ((uint8_t)i ^ gf256_mul(0x5b, s[i])))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+const m256v_kern* m256v_kern_get_nth(int i)
+{
+	for (int j = 0; j < kern_table_sz; ++j) {
+		if (!kern_table[j].supported())
+			continue;
+		if (i-- == 0)
+			return kern_table[j].kern;
+	}
+	return NULL;
+}
+
+__attribute__((constructor))
+static void m256v_kern_init(void)
+{
+	/* Fill the split-nibble tables */
+	for (int a = 0; a < 256; ++a) {
+		for (int x = 0; x < 16; ++x) {
+			m256v_kern_nibtab[a][x] = gf256_mul(a, x);
+			m256v_kern_nibtab[a][16 + x] = gf256_mul(a, x << 4);
+		}
+	}
+
+	/* Fill the affine matrices.  Column k of the matrix for a is
+	 * the image a * 2^k of the k-th basis vector; row i collects
+	 * bit i of all the columns.
+	 */
+	for (int a = 0; a < 256; ++a) {
+		uint64_t A = 0;
+		for (int i = 0; i < 8; ++i) {
+			uint8_t row = 0;
+			for (int k = 0; k < 8; ++k) {
+				if ((gf256_mul(a, 1 << k) >> i) & 1)
+					row |= 1 << k;
+			}
+			A |= (uint64_t)row << (8 * (7 - i));
+		}
+		m256v_kern_affine[a] = A;
+	}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	/* This may run before libgcc has initialized its CPU model */
+	__builtin_cpu_init();
+#endif
+
+	/* Pick the most preferred supported kernel set that passes the
+	 * self test.
+	 */
+	for (int i = kern_table_sz - 1; i >= 0; --i) {
+		if (kern_table[i].supported()
+		  && (i == 0 || m256v_kern_selftest(kern_table[i].kern))) {
+			m256v_kern_active = kern_table[i].kern;
+			break;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef M256V_KERN_H
+#define M256V_KERN_H
+
+/**	@file m256v_kern.h
+ *
+ *	Byte-vector kernels for GF(256) row operations.
+ *
+ *	The m256v row operations reduce to a few primitives on
+ *	contiguous byte ranges.  These primitives are provided by
+ *	several backends (a portable scalar one and SIMD variants); the
+ *	fastest one supported by the CPU is selected when the library is
+ *	loaded.
+ *
+ *	All kernels accept arbitrary alignment and lengths.  The source
+ *	and target ranges must either be identical or not overlap.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**	Split-nibble multiplication tables.
+ *
+ *	m256v_kern_nibtab[a][x] is a * x for 0 <= x < 16, and
+ *	m256v_kern_nibtab[a][16 + x] is a * (x << 4).  Thus, for any
+ *	byte v, a * v = tab[a][v & 0xf] ^ tab[a][16 + (v >> 4)].
+ */
+extern uint8_t m256v_kern_nibtab[256][32];
+
+/**	Affine transformation matrices for gf2p8affineqb.
+ *
+ *	m256v_kern_affine[a] is the 8x8 bit matrix of the GF(2)-linear
+ *	map x |-> a * x, in the layout expected by gf2p8affineqb:  byte
+ *	7 - i holds the row computing output bit i.
+ */
+extern uint64_t m256v_kern_affine[256];
+
+typedef struct {
+	const char* name;
+
+	/** t[i] ^= alpha * s[i] for 0 <= i < n */
+	void (*multadd)(uint8_t* t, const uint8_t* s, size_t n, uint8_t alpha);
+
+	/** t[i] = alpha * t[i] for 0 <= i < n */
+	void (*mult)(uint8_t* t, size_t n, uint8_t alpha);
+
+	/** t[i] ^= sum_j alpha[j] * s[j][i] for 0 <= i < n, 0 <= j < k
+	 *
+	 *  The target is traversed once, in register sized chunks,
+	 *  with all the sources accumulated into each chunk before it
+	 *  is written back.  The sources must not overlap the target.
+	 */
+	void (*multadd_multi)(uint8_t* t,
+				const uint8_t* const* s,
+				const uint8_t* alpha,
+				int k,
+				size_t n);
+} m256v_kern;
+
+/**	The currently active kernel set. */
+extern const m256v_kern* m256v_kern_active;
+
+/**	Look up a kernel set by name.
+ *
+ *	@return		The kernel set, or NULL if the kernel set does not
+ *			exist or is not supported by this CPU.
+ */
+const m256v_kern* m256v_kern_find(const char* name);
+
+/**	Select the kernel set to use.
+ *
+ *	This is mostly useful for testing and benchmarking.
+ *
+ *	@return		0 on success, -1 if the kernel set is unavailable.
+ */
+int m256v_kern_select(const char* name);
+
+/**	Verify a kernel set against the log/exp table arithmetic.
+ *
+ *	Checks all the operations for all multipliers and all byte values.
+ *	This is run on the SIMD kernel sets before they are selected at
+ *	load time; a kernel set failing the check is never used
+ *	automatically.
+ *
+ *	@return		1 if the kernel set computes correct results, 0
+ *			otherwise.
+ */
+int m256v_kern_selftest(const m256v_kern* k);
+
+/**	Enumerate the kernel sets supported by this CPU.
+ *
+ *	@return		The i-th supported kernel set, or NULL if i is
+ *			out of range.
+ */
+const m256v_kern* m256v_kern_get_nth(int i);
+
+/* Backend kernel sets; only defined if compiled in. */
+extern const m256v_kern m256v_kern_scalar;
+extern const m256v_kern m256v_kern_ssse3;
+extern const m256v_kern m256v_kern_avx2;
+extern const m256v_kern m256v_kern_avx512;
+extern const m256v_kern m256v_kern_gfni;
+
+#endif /* M256V_KERN_H */
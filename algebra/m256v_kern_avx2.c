@@ -0,0 +1,144 @@
+/**	@file m256v_kern_avx2.c
+ *
+ *	AVX2 split-nibble kernels.  Needs to be compiled with -mavx2.
+ */
+
+#include <immintrin.h>
+
+#include "m256v_kern.h"
+
+static inline __m256i mul_avx2(__m256i v, __m256i tlo, __m256i thi, __m256i mask)
+{
+	const __m256i lo = _mm256_and_si256(v, mask);
+	const __m256i hi = _mm256_and_si256(_mm256_srli_epi64(v, 4), mask);
+	return _mm256_xor_si256(_mm256_shuffle_epi8(tlo, lo),
+				_mm256_shuffle_epi8(thi, hi));
+}
+
+static void multadd_avx2(uint8_t* t, const uint8_t* s, size_t n, uint8_t alpha)
+{
+	size_t i = 0;
+	if (alpha == 0)
+		return;
+	if (alpha == 1) {
+		for (; i + 32 <= n; i += 32) {
+			const __m256i vs = _mm256_loadu_si256((const __m256i*)(s + i));
+			const __m256i vt = _mm256_loadu_si256((const __m256i*)(t + i));
+			_mm256_storeu_si256((__m256i*)(t + i),
+					_mm256_xor_si256(vt, vs));
+		}
+		for (; i < n; ++i)
+			t[i] ^= s[i];
+		return;
+	}
+
+	const uint8_t* tab = m256v_kern_nibtab[alpha];
+	const __m256i tlo = _mm256_broadcastsi128_si256(
+				_mm_loadu_si128((const __m128i*)tab));
+	const __m256i thi = _mm256_broadcastsi128_si256(
+				_mm_loadu_si128((const __m128i*)(tab + 16)));
+	const __m256i mask = _mm256_set1_epi8(0x0f);
+	for (; i + 64 <= n; i += 64) {
+		const __m256i s0 = _mm256_loadu_si256((const __m256i*)(s + i));
+		const __m256i s1 = _mm256_loadu_si256((const __m256i*)(s + i + 32));
+		const __m256i t0 = _mm256_loadu_si256((const __m256i*)(t + i));
+		const __m256i t1 = _mm256_loadu_si256((const __m256i*)(t + i + 32));
+		_mm256_storeu_si256((__m256i*)(t + i),
+		  _mm256_xor_si256(t0, mul_avx2(s0, tlo, thi, mask)));
+		_mm256_storeu_si256((__m256i*)(t + i + 32),
+		  _mm256_xor_si256(t1, mul_avx2(s1, tlo, thi, mask)));
+	}
+	for (; i + 32 <= n; i += 32) {
+		const __m256i vs = _mm256_loadu_si256((const __m256i*)(s + i));
+		const __m256i vt = _mm256_loadu_si256((const __m256i*)(t + i));
+		_mm256_storeu_si256((__m256i*)(t + i),
+		  _mm256_xor_si256(vt, mul_avx2(vs, tlo, thi, mask)));
+	}
+
+	/* Tail */
+	for (; i < n; ++i)
+		t[i] ^= tab[s[i] & 0xf] ^ tab[16 + (s[i] >> 4)];
+}
+
+static void mult_avx2(uint8_t* t, size_t n, uint8_t alpha)
+{
+	size_t i = 0;
+	if (alpha == 1)
+		return;
+
+	const uint8_t* tab = m256v_kern_nibtab[alpha];
+	const __m256i tlo = _mm256_broadcastsi128_si256(
+				_mm_loadu_si128((const __m128i*)tab));
+	const __m256i thi = _mm256_broadcastsi128_si256(
+				_mm_loadu_si128((const __m128i*)(tab + 16)));
+	const __m256i mask = _mm256_set1_epi8(0x0f);
+	for (; i + 32 <= n; i += 32) {
+		const __m256i vt = _mm256_loadu_si256((const __m256i*)(t + i));
+		_mm256_storeu_si256((__m256i*)(t + i),
+				mul_avx2(vt, tlo, thi, mask));
+	}
+
+	/* Tail */
+	for (; i < n; ++i)
+		t[i] = tab[t[i] & 0xf] ^ tab[16 + (t[i] >> 4)];
+}
+
+static void multadd_multi_avx2(uint8_t* t,
+				const uint8_t* const* s,
+				const uint8_t* alpha,
+				int k,
+				size_t n)
+{
+	size_t i = 0;
+	const __m256i mask = _mm256_set1_epi8(0x0f);
+	for (; i + 64 <= n; i += 64) {
+		__m256i acc0 = _mm256_loadu_si256((const __m256i*)(t + i));
+		__m256i acc1 = _mm256_loadu_si256((const __m256i*)(t + i + 32));
+		for (int j = 0; j < k; ++j) {
+			const uint8_t* tab = m256v_kern_nibtab[alpha[j]];
+			const __m256i tlo = _mm256_broadcastsi128_si256(
+					_mm_loadu_si128((const __m128i*)tab));
+			const __m256i thi = _mm256_broadcastsi128_si256(
+					_mm_loadu_si128((const __m128i*)(tab + 16)));
+			const __m256i s0 = _mm256_loadu_si256(
+					(const __m256i*)(s[j] + i));
+			const __m256i s1 = _mm256_loadu_si256(
+					(const __m256i*)(s[j] + i + 32));
+			acc0 = _mm256_xor_si256(acc0, mul_avx2(s0, tlo, thi, mask));
+			acc1 = _mm256_xor_si256(acc1, mul_avx2(s1, tlo, thi, mask));
+		}
+		_mm256_storeu_si256((__m256i*)(t + i), acc0);
+		_mm256_storeu_si256((__m256i*)(t + i + 32), acc1);
+	}
+	for (; i + 32 <= n; i += 32) {
+		__m256i acc = _mm256_loadu_si256((const __m256i*)(t + i));
+		for (int j = 0; j < k; ++j) {
+			const uint8_t* tab = m256v_kern_nibtab[alpha[j]];
+			const __m256i tlo = _mm256_broadcastsi128_si256(
+					_mm_loadu_si128((const __m128i*)tab));
+			const __m256i thi = _mm256_broadcastsi128_si256(
+					_mm_loadu_si128((const __m128i*)(tab + 16)));
+			const __m256i vs = _mm256_loadu_si256(
+					(const __m256i*)(s[j] + i));
+			acc = _mm256_xor_si256(acc, mul_avx2(vs, tlo, thi, mask));
+		}
+		_mm256_storeu_si256((__m256i*)(t + i), acc);
+	}
+
+	/* Tail */
+	for (; i < n; ++i) {
+		uint8_t acc = t[i];
+		for (int j = 0; j < k; ++j) {
+			const uint8_t* tab = m256v_kern_nibtab[alpha[j]];
+			acc ^= tab[s[j][i] & 0xf] ^ tab[16 + (s[j][i] >> 4)];
+		}
+		t[i] = acc;
+	}
+}
+
+const m256v_kern m256v_kern_avx2 = {
+	.name = "avx2",
+	.multadd = multadd_avx2,
+	.mult = mult_avx2,
+	.multadd_multi = multadd_multi_avx2,
+};
@@ -0,0 +1,120 @@
+/**	@file m256v_kern_avx512.c
+ *
+ *	AVX-512BW split-nibble kernels.  Needs to be compiled with
+ *	-mavx512f -mavx512bw.
+ *
+ *	Tails are handled with masked loads and stores, so no scalar
+ *	cleanup loop is needed.
+ */
+
+#include <immintrin.h>
+
+#include "m256v_kern.h"
+
+static inline __m512i mul_avx512(__m512i v, __m512i tlo, __m512i thi, __m512i mask)
+{
+	const __m512i lo = _mm512_and_si512(v, mask);
+	const __m512i hi = _mm512_and_si512(_mm512_srli_epi64(v, 4), mask);
+	return _mm512_xor_si512(_mm512_shuffle_epi8(tlo, lo),
+				_mm512_shuffle_epi8(thi, hi));
+}
+
+static inline __mmask64 tail_mask(size_t n)
+{
+	return (n >= 64) ? ~(__mmask64)0 : (((__mmask64)1 << n) - 1);
+}
+
+static void multadd_avx512(uint8_t* t, const uint8_t* s, size_t n, uint8_t alpha)
+{
+	size_t i = 0;
+	if (alpha == 0)
+		return;
+	if (alpha == 1) {
+		for (; i + 64 <= n; i += 64) {
+			const __m512i vs = _mm512_loadu_si512(s + i);
+			const __m512i vt = _mm512_loadu_si512(t + i);
+			_mm512_storeu_si512(t + i, _mm512_xor_si512(vt, vs));
+		}
+		if (i < n) {
+			const __mmask64 m = tail_mask(n - i);
+			const __m512i vs = _mm512_maskz_loadu_epi8(m, s + i);
+			const __m512i vt = _mm512_maskz_loadu_epi8(m, t + i);
+			_mm512_mask_storeu_epi8(t + i, m, _mm512_xor_si512(vt, vs));
+		}
+		return;
+	}
+
+	const uint8_t* tab = m256v_kern_nibtab[alpha];
+	const __m512i tlo = _mm512_broadcast_i32x4(
+				_mm_loadu_si128((const __m128i*)tab));
+	const __m512i thi = _mm512_broadcast_i32x4(
+				_mm_loadu_si128((const __m128i*)(tab + 16)));
+	const __m512i mask = _mm512_set1_epi8(0x0f);
+	for (; i + 128 <= n; i += 128) {
+		const __m512i s0 = _mm512_loadu_si512(s + i);
+		const __m512i s1 = _mm512_loadu_si512(s + i + 64);
+		const __m512i t0 = _mm512_loadu_si512(t + i);
+		const __m512i t1 = _mm512_loadu_si512(t + i + 64);
+		_mm512_storeu_si512(t + i,
+		  _mm512_xor_si512(t0, mul_avx512(s0, tlo, thi, mask)));
+		_mm512_storeu_si512(t + i + 64,
+		  _mm512_xor_si512(t1, mul_avx512(s1, tlo, thi, mask)));
+	}
+	while (i < n) {
+		const __mmask64 m = tail_mask(n - i);
+		const __m512i vs = _mm512_maskz_loadu_epi8(m, s + i);
+		const __m512i vt = _mm512_maskz_loadu_epi8(m, t + i);
+		_mm512_mask_storeu_epi8(t + i, m,
+		  _mm512_xor_si512(vt, mul_avx512(vs, tlo, thi, mask)));
+		i += 64;
+	}
+}
+
+static void mult_avx512(uint8_t* t, size_t n, uint8_t alpha)
+{
+	if (alpha == 1)
+		return;
+
+	const uint8_t* tab = m256v_kern_nibtab[alpha];
+	const __m512i tlo = _mm512_broadcast_i32x4(
+				_mm_loadu_si128((const __m128i*)tab));
+	const __m512i thi = _mm512_broadcast_i32x4(
+				_mm_loadu_si128((const __m128i*)(tab + 16)));
+	const __m512i mask = _mm512_set1_epi8(0x0f);
+	for (size_t i = 0; i < n; i += 64) {
+		const __mmask64 m = tail_mask(n - i);
+		const __m512i vt = _mm512_maskz_loadu_epi8(m, t + i);
+		_mm512_mask_storeu_epi8(t + i, m,
+				mul_avx512(vt, tlo, thi, mask));
+	}
+}
+
+static void multadd_multi_avx512(uint8_t* t,
+				const uint8_t* const* s,
+				const uint8_t* alpha,
+				int k,
+				size_t n)
+{
+	const __m512i mask = _mm512_set1_epi8(0x0f);
+	for (size_t i = 0; i < n; i += 64) {
+		const __mmask64 m = tail_mask(n - i);
+		__m512i acc = _mm512_maskz_loadu_epi8(m, t + i);
+		for (int j = 0; j < k; ++j) {
+			const uint8_t* tab = m256v_kern_nibtab[alpha[j]];
+			const __m512i tlo = _mm512_broadcast_i32x4(
+					_mm_loadu_si128((const __m128i*)tab));
+			const __m512i thi = _mm512_broadcast_i32x4(
+					_mm_loadu_si128((const __m128i*)(tab + 16)));
+			const __m512i vs = _mm512_maskz_loadu_epi8(m, s[j] + i);
+			acc = _mm512_xor_si512(acc, mul_avx512(vs, tlo, thi, mask));
+		}
+		_mm512_mask_storeu_epi8(t + i, m, acc);
+	}
+}
+
+const m256v_kern m256v_kern_avx512 = {
+	.name = "avx512",
+	.multadd = multadd_avx512,
+	.mult = mult_avx512,
+	.multadd_multi = multadd_multi_avx512,
+};
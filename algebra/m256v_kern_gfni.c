@@ -0,0 +1,119 @@
+/**	@file m256v_kern_gfni.c
+ *
+ *	GFNI kernels using the gf2p8affineqb instruction on 512 bit
+ *	vectors.  Needs to be compiled with -mavx512f -mavx512bw -mgfni.
+ *
+ *	gf2p8affineqb computes an arbitrary GF(2)-linear map on each byte.
+ *	Multiplication by a constant is GF(2)-linear in any polynomial
+ *	basis, so this also works with the RFC 6330 field polynomial,
+ *	which differs from the one gf2p8mulb hardcodes.  The 8x8 bit
+ *	matrices for each multiplier are in m256v_kern_affine.
+ */
+
+#include <immintrin.h>
+
+#include "m256v_kern.h"
+
+static inline __mmask64 tail_mask(size_t n)
+{
+	return (n >= 64) ? ~(__mmask64)0 : (((__mmask64)1 << n) - 1);
+}
+
+static void multadd_gfni(uint8_t* t, const uint8_t* s, size_t n, uint8_t alpha)
+{
+	size_t i = 0;
+	if (alpha == 0)
+		return;
+	if (alpha == 1) {
+		for (; i + 64 <= n; i += 64) {
+			const __m512i vs = _mm512_loadu_si512(s + i);
+			const __m512i vt = _mm512_loadu_si512(t + i);
+			_mm512_storeu_si512(t + i, _mm512_xor_si512(vt, vs));
+		}
+		if (i < n) {
+			const __mmask64 m = tail_mask(n - i);
+			const __m512i vs = _mm512_maskz_loadu_epi8(m, s + i);
+			const __m512i vt = _mm512_maskz_loadu_epi8(m, t + i);
+			_mm512_mask_storeu_epi8(t + i, m, _mm512_xor_si512(vt, vs));
+		}
+		return;
+	}
+
+	const __m512i A = _mm512_set1_epi64(m256v_kern_affine[alpha]);
+	for (; i + 128 <= n; i += 128) {
+		const __m512i s0 = _mm512_loadu_si512(s + i);
+		const __m512i s1 = _mm512_loadu_si512(s + i + 64);
+		const __m512i t0 = _mm512_loadu_si512(t + i);
+		const __m512i t1 = _mm512_loadu_si512(t + i + 64);
+		_mm512_storeu_si512(t + i, _mm512_xor_si512(t0,
+				_mm512_gf2p8affine_epi64_epi8(s0, A, 0)));
+		_mm512_storeu_si512(t + i + 64, _mm512_xor_si512(t1,
+				_mm512_gf2p8affine_epi64_epi8(s1, A, 0)));
+	}
+	while (i < n) {
+		const __mmask64 m = tail_mask(n - i);
+		const __m512i vs = _mm512_maskz_loadu_epi8(m, s + i);
+		const __m512i vt = _mm512_maskz_loadu_epi8(m, t + i);
+		_mm512_mask_storeu_epi8(t + i, m, _mm512_xor_si512(vt,
+				_mm512_gf2p8affine_epi64_epi8(vs, A, 0)));
+		i += 64;
+	}
+}
+
+static void mult_gfni(uint8_t* t, size_t n, uint8_t alpha)
+{
+	if (alpha == 1)
+		return;
+
+	const __m512i A = _mm512_set1_epi64(m256v_kern_affine[alpha]);
+	for (size_t i = 0; i < n; i += 64) {
+		const __mmask64 m = tail_mask(n - i);
+		const __m512i vt = _mm512_maskz_loadu_epi8(m, t + i);
+		_mm512_mask_storeu_epi8(t + i, m,
+				_mm512_gf2p8affine_epi64_epi8(vt, A, 0));
+	}
+}
+
+static void multadd_multi_gfni(uint8_t* t,
+				const uint8_t* const* s,
+				const uint8_t* alpha,
+				int k,
+				size_t n)
+{
+	size_t i = 0;
+	for (; i + 128 <= n; i += 128) {
+		__m512i acc0 = _mm512_loadu_si512(t + i);
+		__m512i acc1 = _mm512_loadu_si512(t + i + 64);
+		for (int j = 0; j < k; ++j) {
+			const __m512i A = _mm512_set1_epi64(
+					m256v_kern_affine[alpha[j]]);
+			const __m512i s0 = _mm512_loadu_si512(s[j] + i);
+			const __m512i s1 = _mm512_loadu_si512(s[j] + i + 64);
+			acc0 = _mm512_xor_si512(acc0,
+					_mm512_gf2p8affine_epi64_epi8(s0, A, 0));
+			acc1 = _mm512_xor_si512(acc1,
+					_mm512_gf2p8affine_epi64_epi8(s1, A, 0));
+		}
+		_mm512_storeu_si512(t + i, acc0);
+		_mm512_storeu_si512(t + i + 64, acc1);
+	}
+	for (; i < n; i += 64) {
+		const __mmask64 m = tail_mask(n - i);
+		__m512i acc = _mm512_maskz_loadu_epi8(m, t + i);
+		for (int j = 0; j < k; ++j) {
+			const __m512i A = _mm512_set1_epi64(
+					m256v_kern_affine[alpha[j]]);
+			const __m512i vs = _mm512_maskz_loadu_epi8(m, s[j] + i);
+			acc = _mm512_xor_si512(acc,
+					_mm512_gf2p8affine_epi64_epi8(vs, A, 0));
+		}
+		_mm512_mask_storeu_epi8(t + i, m, acc);
+	}
+}
+
+const m256v_kern m256v_kern_gfni = {
+	.name = "gfni",
+	.multadd = multadd_gfni,
+	.mult = mult_gfni,
+	.multadd_multi = multadd_multi_gfni,
+};
@@ -0,0 +1,109 @@
+/**	@file m256v_kern_ssse3.c
+ *
+ *	SSSE3 split-nibble kernels.  Needs to be compiled with -mssse3.
+ */
+
+#include <immintrin.h>
+
+#include "m256v_kern.h"
+
+static void multadd_ssse3(uint8_t* t, const uint8_t* s, size_t n, uint8_t alpha)
+{
+	size_t i = 0;
+	if (alpha == 0)
+		return;
+	if (alpha == 1) {
+		for (; i + 16 <= n; i += 16) {
+			const __m128i vs = _mm_loadu_si128((const __m128i*)(s + i));
+			const __m128i vt = _mm_loadu_si128((const __m128i*)(t + i));
+			_mm_storeu_si128((__m128i*)(t + i), _mm_xor_si128(vt, vs));
+		}
+		for (; i < n; ++i)
+			t[i] ^= s[i];
+		return;
+	}
+
+	const uint8_t* tab = m256v_kern_nibtab[alpha];
+	const __m128i tlo = _mm_loadu_si128((const __m128i*)tab);
+	const __m128i thi = _mm_loadu_si128((const __m128i*)(tab + 16));
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i vs = _mm_loadu_si128((const __m128i*)(s + i));
+		const __m128i lo = _mm_and_si128(vs, mask);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi64(vs, 4), mask);
+		const __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, lo),
+						_mm_shuffle_epi8(thi, hi));
+		const __m128i vt = _mm_loadu_si128((const __m128i*)(t + i));
+		_mm_storeu_si128((__m128i*)(t + i), _mm_xor_si128(vt, p));
+	}
+
+	/* Tail */
+	for (; i < n; ++i)
+		t[i] ^= tab[s[i] & 0xf] ^ tab[16 + (s[i] >> 4)];
+}
+
+static void mult_ssse3(uint8_t* t, size_t n, uint8_t alpha)
+{
+	size_t i = 0;
+	if (alpha == 1)
+		return;
+
+	const uint8_t* tab = m256v_kern_nibtab[alpha];
+	const __m128i tlo = _mm_loadu_si128((const __m128i*)tab);
+	const __m128i thi = _mm_loadu_si128((const __m128i*)(tab + 16));
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i vt = _mm_loadu_si128((const __m128i*)(t + i));
+		const __m128i lo = _mm_and_si128(vt, mask);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi64(vt, 4), mask);
+		const __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, lo),
+						_mm_shuffle_epi8(thi, hi));
+		_mm_storeu_si128((__m128i*)(t + i), p);
+	}
+
+	/* Tail */
+	for (; i < n; ++i)
+		t[i] = tab[t[i] & 0xf] ^ tab[16 + (t[i] >> 4)];
+}
+
+static void multadd_multi_ssse3(uint8_t* t,
+				const uint8_t* const* s,
+				const uint8_t* alpha,
+				int k,
+				size_t n)
+{
+	size_t i = 0;
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	for (; i + 16 <= n; i += 16) {
+		__m128i acc = _mm_loadu_si128((const __m128i*)(t + i));
+		for (int j = 0; j < k; ++j) {
+			const uint8_t* tab = m256v_kern_nibtab[alpha[j]];
+			const __m128i tlo = _mm_loadu_si128((const __m128i*)tab);
+			const __m128i thi = _mm_loadu_si128((const __m128i*)(tab + 16));
+			const __m128i vs = _mm_loadu_si128((const __m128i*)(s[j] + i));
+			const __m128i lo = _mm_and_si128(vs, mask);
+			const __m128i hi = _mm_and_si128(_mm_srli_epi64(vs, 4), mask);
+			acc = _mm_xor_si128(acc, _mm_xor_si128(
+					_mm_shuffle_epi8(tlo, lo),
+					_mm_shuffle_epi8(thi, hi)));
+		}
+		_mm_storeu_si128((__m128i*)(t + i), acc);
+	}
+
+	/* Tail */
+	for (; i < n; ++i) {
+		uint8_t acc = t[i];
+		for (int j = 0; j < k; ++j) {
+			const uint8_t* tab = m256v_kern_nibtab[alpha[j]];
+			acc ^= tab[s[j][i] & 0xf] ^ tab[16 + (s[j][i] >> 4)];
+		}
+		t[i] = acc;
+	}
+}
+
+const m256v_kern m256v_kern_ssse3 = {
+	.name = "ssse3",
+	.multadd = multadd_ssse3,
+	.mult = mult_ssse3,
+	.multadd_multi = multadd_multi_ssse3,
+};
@@ -0,0 +1,327 @@
+/**	@file m256v_lu.c
+ *
+ *	Blocked LU decomposition for GF(256) matrices.
+ *
+ *	The matrix is processed in panels of LU_NB columns.  Within a
+ *	panel, the elimination is only carried out on the panel columns;
+ *	the updates to the columns right of the panel are deferred and
+ *	then applied together:  first the rows of U belonging to the
+ *	panel are computed by a triangular solve, and then the trailing
+ *	matrix receives the rank-LU_NB update A22 -= L21 * U12.  The
+ *	latter is done with m256v_multadd_rows, so that each trailing
+ *	row is read and written once per panel rather than once per
+ *	pivot, and it is tiled by columns so that the U12 block stays
+ *	in cache.
+ *
+ *	Since the field arithmetic is exact, the order in which the
+ *	updates are applied does not matter.  With the pivot search
+ *	below, the result (LU factors, rowperm, colperm, rank) is
+ *	identical to the one of m256v_LU_decomp_inplace_basic.
+ *
+ *	The trailing updates of the different rows are independent, so
+ *	m256v_LU_decomp_inplace_mt splits each of them into tasks, which
+ *	the caller's runner may run in parallel.  The panel
+ *	factorization stays on the calling thread.  The pivot choice,
+ *	and thus the result, does not depend on the number of tasks.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gf256.h"
+#include "m256v.h"
+
+/* Panel width.  Should not exceed the batch size in
+ * m256v_multadd_rows, so that each trailing row update results in a
+ * single kernel call.
+ */
+#define LU_NB		32
+
+/* Width of the column tiles of the trailing update, in bytes */
+#define LU_TILE		4096
+
+/* The rows of the trailing update are dealt to the tasks in chunks
+ * of LU_ROW_CHUNK rows, round robin.
+ */
+#define LU_ROW_CHUNK	16
+
+/* Maximum number of tasks a trailing update is split into */
+#define LU_MAX_TASKS	256
+
+#define get_el		m256v_get_el
+
+#define SwapInt(a, b) \
+	do { \
+		const int SwapInt__swval = (b); \
+		(b) = (a); \
+		(a) = SwapInt__swval; \
+	} while(0)
+
+/* Mask with bit j set iff L[r][k0 + j] is nonzero, for k0 <= k0 + j
+ * < k1.
+ */
+static uint32_t l_mask(const m256v* A, int r, int k0, int k1)
+{
+	const uint8_t* L = A->e + m256v_get_el_offs(A, r, k0);
+	uint32_t m = 0;
+	int j = 0;
+	for (; j + 8 <= k1 - k0; j += 8) {
+		/* Most words are zero in sparse matrices */
+		uint64_t w;
+		memcpy(&w, L + j, sizeof(w));
+		if (w == 0)
+			continue;
+		for (int b = 0; b < 8; ++b)
+			m |= (uint32_t)(L[j + b] != 0) << (j + b);
+	}
+	for (; j < k1 - k0; ++j)
+		m |= (uint32_t)(L[j] != 0) << j;
+	return m;
+}
+
+/* Apply the deferred updates of the pivots k0, ..., kend - 1 to the
+ * columns from c0 on, for the rows in [r_beg, r_end) that are in the
+ * row chunks t, t + n_tasks, ... (see LU_ROW_CHUNK) of the range.
+ *
+ * The rows k0 + 1, ..., kend - 1 (the rows of U12) depend on the
+ * preceding ones, and need to be updated in order before the rows
+ * from kend on, which are independent.
+ *
+ * The L entries of a chunk are looked at once, up front, so that the
+ * many rows of sparse matrices that need no update are skipped in
+ * the column tiles.
+ */
+static void update_trailing(m256v* A, int k0, int kend, int c0,
+				int r_beg, int r_end, int t, int n_tasks)
+{
+	if (kend == k0 || c0 >= A->n_col)
+		return;
+
+	int rows[LU_NB];
+	uint8_t alphas[LU_NB];
+	uint32_t nz[LU_ROW_CHUNK];
+	const int stride = LU_ROW_CHUNK * n_tasks;
+	for (int r0 = r_beg + t * LU_ROW_CHUNK; r0 < r_end; r0 += stride) {
+		const int r1 = (r_end - r0 < LU_ROW_CHUNK)
+				? r_end : r0 + LU_ROW_CHUNK;
+		uint32_t any = 0;
+		for (int r = r0; r < r1; ++r) {
+			nz[r - r0] = l_mask(A, r, k0, (r < kend) ? r : kend);
+			any |= nz[r - r0];
+		}
+		if (any == 0)
+			continue;
+
+		/* U12 := L11^(-1) * A12, then A22 -= L21 * U12 */
+		for (int ct = c0; ct < A->n_col; ct += LU_TILE) {
+			const int w = (A->n_col - ct < LU_TILE)
+					? A->n_col - ct : LU_TILE;
+			m256v T = m256v_get_subview(A, 0, ct, A->n_row, w);
+			for (int r = r0; r < r1; ++r) {
+				uint32_t m = nz[r - r0];
+				int k = 0;
+				while (m != 0) {
+					const int j = __builtin_ctz(m);
+					m &= m - 1;
+					rows[k] = k0 + j;
+					alphas[k] = get_el(A, r, k0 + j);
+					++k;
+				}
+				if (k > 0)
+					m256v_multadd_rows(&T, rows, alphas, k,
+								&T, r);
+			}
+		}
+	}
+}
+
+/* Arguments of the tasks of a trailing update */
+typedef struct {
+	m256v* A;
+	int k0, kend, c0;
+	int n_tasks;
+} trailing_job;
+
+static void trailing_task(void* arg, int t)
+{
+	const trailing_job* job = arg;
+	update_trailing(job->A, job->k0, job->kend, job->c0,
+			job->kend, job->A->n_row, t, job->n_tasks);
+}
+
+/* Apply the deferred updates, in up to n_threads tasks run with run.
+ * The rows of U12 are done by the calling thread up front.
+ */
+static void trailing(m256v* A, int k0, int kend, int c0,
+			int n_threads, par_run_fn run)
+{
+	update_trailing(A, k0, kend, c0, k0 + 1, kend, 0, 1);
+
+	/* Give every task at least one chunk of rows */
+	const int n_chunks = (A->n_row - kend + LU_ROW_CHUNK - 1)
+				/ LU_ROW_CHUNK;
+	trailing_job job = {
+		.A = A,
+		.k0 = k0,
+		.kend = kend,
+		.c0 = c0,
+		.n_tasks = (n_threads < n_chunks) ? n_threads : n_chunks,
+	};
+	if (run == NULL || job.n_tasks <= 1) {
+		update_trailing(A, k0, kend, c0, kend, A->n_row, 0, 1);
+		return;
+	}
+	run(job.n_tasks, trailing_task, &job);
+}
+
+/* Bring the pivot at (prow, pcol) to (i, i), compute column i of L,
+ * and eliminate below the pivot within the columns of M.
+ */
+static void pivot_step(m256v* A, m256v* M, int* rp, int* cp,
+			int i, int prow, int pcol)
+{
+	if (prow != i) {
+		SwapInt(rp[i], rp[prow]);
+		m256v_swap_rows(A, i, prow);
+	}
+	if (pcol != i) {
+		SwapInt(cp[i], cp[pcol]);
+		m256v_swap_cols(A, pcol, i);
+	}
+
+	const uint8_t Uii_inv = gf256_inv(get_el(A, i, i));
+	m256v_mult_col_from(A, i, i + 1, Uii_inv);
+
+	for (int j = i + 1; j < A->n_row; ++j) {
+		const uint8_t Lji = get_el(A, j, i);
+		if (Lji == 0)
+			continue;
+		m256v_multadd_row_from(M, i, i + 1, Lji, M, j);
+	}
+}
+
+/* Find the first nonzero in column-major order in the columns
+ * [c0, c1), rows from r0 on.  Returns 0 if there is none.
+ */
+static int find_pivot(const m256v* A, int r0, int c0, int c1,
+			int* prow, int* pcol)
+{
+	for (int c = c0; c < c1; ++c) {
+		for (int r = r0; r < A->n_row; ++r) {
+			if (get_el(A, r, c) != 0) {
+				*prow = r;
+				*pcol = c;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Blocked decomposition, with the trailing updates split into up to
+ * n_threads tasks run with run
+ */
+static int lu_blocked(m256v* A, int* rp, int* cp, int n_threads,
+			par_run_fn run)
+{
+	const int n = (A->n_row < A->n_col) ? A->n_row : A->n_col;
+
+	/* Initialize permutations */
+	for (int i = 0; i < A->n_row; ++i)
+		rp[i] = i;
+	for (int i = 0; i < A->n_col; ++i)
+		cp[i] = i;
+
+	int i = 0;
+	while (i < n) {
+		/* Factor the panel */
+		const int k0 = i;
+		const int k1 = (k0 + LU_NB < A->n_col) ? k0 + LU_NB : A->n_col;
+		m256v P = m256v_get_subview(A, 0, 0, A->n_row, k1);
+		int prow, pcol;
+		int stuck = 0;
+		for (; i < k1 && i < A->n_row; ++i) {
+			if (!find_pivot(A, i, i, k1, &prow, &pcol)) {
+				stuck = 1;
+				break;
+			}
+			pivot_step(A, &P, rp, cp, i, prow, pcol);
+		}
+
+		/* Apply the deferred updates */
+		trailing(A, k0, i, k1, n_threads, run);
+		if (!stuck)
+			continue;
+
+		/* The panel columns ran out of pivots.  The columns right
+		 * of the panel are up to date now, so continue the
+		 * search there, as the basic algorithm would, and
+		 * eliminate with a full width update.
+		 */
+		if (!find_pivot(A, i, k1, A->n_col, &prow, &pcol))
+			break;
+		pivot_step(A, A, rp, cp, i, prow, pcol);
+		++i;
+	}
+
+	/* At this point, i is the rank of the matrix */
+	return i;
+}
+
+int m256v_LU_decomp_inplace(m256v* A, int* rp, int* cp)
+{
+	return m256v_LU_decomp_inplace_mt(A, rp, cp, 1, NULL);
+}
+
+int m256v_LU_decomp_inplace_mt(m256v* A, int* rp, int* cp, int n_threads,
+				par_run_fn run)
+{
+	const int n = (A->n_row < A->n_col) ? A->n_row : A->n_col;
+	if (n < 2 * LU_NB)
+		return m256v_LU_decomp_inplace_basic(A, rp, cp);
+
+	if (n_threads > LU_MAX_TASKS)
+		n_threads = LU_MAX_TASKS;
+	if (n_threads < 1)
+		n_threads = 1;
+	return lu_blocked(A, rp, cp, n_threads, run);
+}
+
+int m256v_LU_decomp_append(m256v* A, int n_old, int rank, int* rp, int* cp)
+{
+	const int n = (A->n_row < A->n_col) ? A->n_row : A->n_col;
+
+	/* Bring the new rows into the column order of the decomposition,
+	 * and eliminate them against the pivots found so far.
+	 */
+	uint8_t tmp[A->n_col];
+	for (int j = n_old; j < A->n_row; ++j) {
+		rp[j] = j;
+		for (int c = 0; c < A->n_col; ++c)
+			tmp[c] = get_el(A, j, cp[c]);
+		for (int c = 0; c < A->n_col; ++c)
+			m256v_set_el(A, j, c, tmp[c]);
+		for (int k = 0; k < rank; ++k) {
+			const uint8_t a = get_el(A, j, k);
+			if (a == 0)
+				continue;
+			const uint8_t Ljk = gf256_mul(a,
+					gf256_inv(get_el(A, k, k)));
+			m256v_set_el(A, j, k, Ljk);
+			m256v_multadd_row_from(A, k, k + 1, Ljk, A, j);
+		}
+	}
+
+	/* The old rows are zero right of the pivots; continue the
+	 * decomposition there.
+	 */
+	int i = rank;
+	for (; i < n; ++i) {
+		int prow, pcol;
+		if (!find_pivot(A, i, i, A->n_col, &prow, &pcol))
+			break;
+		pivot_step(A, A, rp, cp, i, prow, pcol);
+	}
+	return i;
+}
@@ -0,0 +1,156 @@
+/**	@file m256v_transpose.c
+ *
+ *	Blocked transpose, and the column operations built on it.
+ *
+ *	Walking down a column touches one cache line per element.  The
+ *	operations on many columns here work on strips of TILE rows
+ *	instead:  a strip is transposed in TILE x TILE tiles, so that its
+ *	columns become contiguous rows of TILE bytes, which are then
+ *	worked on with row operations and transposed back.
+ *
+ *	The tiles are transposed with SSE2 (which every x86-64 CPU has),
+ *	or element by element otherwise.
+ *
+ *	The column permutation keeps a transposed strip on the stack, up
+ *	to PERM_BUF bytes; wider matrices are permuted column by column.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "m256v.h"
+#include "m256v_kern.h"
+
+#define TILE		16
+
+/* Size of the buffer for the transposed strip (64 KiB, like the M4R
+ * tables), enough for 4096 columns
+ */
+#define PERM_BUF	(1 << 16)
+
+#ifdef __SSE2__
+/* Transpose a full 16 x 16 tile.
+ *
+ * Each round interleaves rows i and i + 8; with the element index
+ * written as the bits of its row and column, r3 r2 r1 r0 c3 c2 c1 c0,
+ * this rotates the index left by one bit.  After four rounds, row and
+ * column bits are exchanged.
+ */
+static void transpose_tile(uint8_t* t, size_t ts, const uint8_t* s, size_t ss)
+{
+	__m128i a[TILE], b[TILE];
+	for (int i = 0; i < TILE; ++i)
+		a[i] = _mm_loadu_si128((const __m128i*)(s + i*ss));
+	for (int round = 0; round < 2; ++round) {
+		for (int i = 0; i < TILE/2; ++i) {
+			b[2*i] = _mm_unpacklo_epi8(a[i], a[i + TILE/2]);
+			b[2*i + 1] = _mm_unpackhi_epi8(a[i], a[i + TILE/2]);
+		}
+		for (int i = 0; i < TILE/2; ++i) {
+			a[2*i] = _mm_unpacklo_epi8(b[i], b[i + TILE/2]);
+			a[2*i + 1] = _mm_unpackhi_epi8(b[i], b[i + TILE/2]);
+		}
+	}
+	for (int i = 0; i < TILE; ++i)
+		_mm_storeu_si128((__m128i*)(t + i*ts), a[i]);
+}
+#else
+static void transpose_tile(uint8_t* t, size_t ts, const uint8_t* s, size_t ss)
+{
+	for (int i = 0; i < TILE; ++i) {
+		for (int j = 0; j < TILE; ++j)
+			t[j*ts + i] = s[i*ss + j];
+	}
+}
+#endif
+
+/* Transpose the n_row x n_col block at s into t */
+static void transpose_block(uint8_t* t, size_t ts,
+				const uint8_t* s, size_t ss,
+				int n_row, int n_col)
+{
+	for (int i0 = 0; i0 < n_row; i0 += TILE) {
+		for (int j0 = 0; j0 < n_col; j0 += TILE) {
+			uint8_t* tt = t + j0*ts + i0;
+			const uint8_t* st = s + i0*ss + j0;
+			if (i0 + TILE <= n_row && j0 + TILE <= n_col) {
+				transpose_tile(tt, ts, st, ss);
+				continue;
+			}
+
+			/* Partial tile at the border */
+			const int h = (n_row - i0 < TILE) ? n_row - i0 : TILE;
+			const int w = (n_col - j0 < TILE) ? n_col - j0 : TILE;
+			for (int i = 0; i < h; ++i) {
+				for (int j = 0; j < w; ++j)
+					tt[j*ts + i] = st[i*ss + j];
+			}
+		}
+	}
+}
+
+void m256v_transpose(const m256v* A, m256v* At_out)
+{
+	assert(A->n_row == At_out->n_col);
+	assert(A->n_col == At_out->n_row);
+
+	transpose_block(At_out->e, At_out->rstride, A->e, A->rstride,
+			A->n_row, A->n_col);
+}
+
+void m256v_permute_cols(m256v* M, const int* colperm)
+{
+	if (M->n_row == 0 || M->n_col == 0)
+		return;
+	if ((size_t)M->n_col * TILE > PERM_BUF) {
+		m256v_permute_cols_basic(M, colperm);
+		return;
+	}
+
+	/* The columns of a strip, as rows of T */
+	uint8_t T[PERM_BUF];
+	uint8_t G[TILE * TILE];
+	for (int r0 = 0; r0 < M->n_row; r0 += TILE) {
+		const int h = (M->n_row - r0 < TILE) ? M->n_row - r0 : TILE;
+		uint8_t* strip = M->e + m256v_get_el_offs(M, r0, 0);
+		transpose_block(T, TILE, strip, M->rstride, h, M->n_col);
+
+		/* Gather the source columns of each tile of the target
+		 * strip, and transpose them into place.
+		 */
+		for (int c0 = 0; c0 < M->n_col; c0 += TILE) {
+			const int w = (M->n_col - c0 < TILE) ? M->n_col - c0 : TILE;
+			for (int j = 0; j < w; ++j) {
+				memcpy(G + j*TILE, T + (size_t)colperm[c0 + j] * TILE,
+					TILE);
+			}
+			transpose_block(strip + c0, M->rstride, G, TILE, w, h);
+		}
+	}
+}
+
+void m256v_mult_cols(m256v* M, const uint8_t* alphas)
+{
+	uint8_t G[TILE * TILE];
+	for (int c0 = 0; c0 < M->n_col; c0 += TILE) {
+		const int w = (M->n_col - c0 < TILE) ? M->n_col - c0 : TILE;
+		int j;
+		for (j = 0; j < w && alphas[c0 + j] == 1; ++j)
+			;
+		if (j == w)
+			continue;
+
+		for (int r0 = 0; r0 < M->n_row; r0 += TILE) {
+			const int h = (M->n_row - r0 < TILE) ? M->n_row - r0 : TILE;
+			uint8_t* tile = M->e + m256v_get_el_offs(M, r0, c0);
+			transpose_block(G, TILE, tile, M->rstride, h, w);
+			for (j = 0; j < w; ++j)
+				m256v_kern_active->mult(G + j*TILE, h, alphas[c0 + j]);
+			transpose_block(tile, M->rstride, G, TILE, w, h);
+		}
+	}
+}
@@ -1,4 +1,7 @@
+#include <string.h>
+
 #include "m2v.h"
+#include "m2v_kern.h"
 
 extern inline int m2v__get_word(const m2v* M, int r, int c);
 extern inline int m2v__get_bit(const m2v* M, int c);
@@ -52,23 +55,18 @@ void m2v_swap_rows(m2v* M, int r1, int r2)
 	assert(0 <= r1 && r1 < M->n_row);
 	assert(0 <= r2 && r2 < M->n_row);
 
-	const int o1 = get_word(M, r1, 0);
-	const int o2 = get_word(M, r2, 0);
-	for (int i = 0; i < M->row_stride; ++i) {
-		const m2v_base sw = M->e[o1 + i];
-		M->e[o1 + i] = M->e[o2 + i];
-		M->e[o2 + i] = sw;
-	}
+	if (r1 == r2)
+		return;
+	m2v_kern_active->swap(M->e + get_word(M, r1, 0),
+				M->e + get_word(M, r2, 0),
+				M->row_stride);
 }
 
 void m2v_clear_row(m2v* M, int r)
 {
 	assert(0 <= r && r < M->n_row);
 
-	const int o1 = get_word(M, r, 0);
-	for (int i = 0; i < M->row_stride; ++i) {
-		M->e[o1 + i] = 0;
-	}
+	memset(M->e + get_word(M, r, 0), 0, M->row_stride * sizeof(m2v_base));
 }
 
 void m2v_mult_row(m2v* M, int r, int alpha)
@@ -90,11 +88,9 @@ void m2v_multadd_row(const m2v* M1,
 	if (alpha == 0)
 		return;
 
-	const int o1 = get_word(M1, r1, 0);
-	const int ot = get_word(Mt, rt, 0);
-	for (int i = 0; i < Mt->row_stride; ++i) {
-		Mt->e[ot + i] ^= M1->e[o1 + i];
-	}
+	m2v_kern_active->add(Mt->e + get_word(Mt, rt, 0),
+				M1->e + get_word(M1, r1, 0),
+				Mt->row_stride);
 }
 
 void m2v_multadd_row_from(const m2v* M1,
@@ -118,11 +114,34 @@ void m2v_multadd_row_from(const m2v* M1,
 		Mt->e[ot++] ^= M1->e[o1++] & m;
 	}
 
-	/* loop over remaining complete words */
-	const int oe = get_word(Mt, rt + 1, 0);
-	while (ot < oe) {
-		Mt->e[ot++] ^= M1->e[o1++];
+	/* remaining complete words */
+	const int oe = get_word(Mt, rt, 0) + Mt->row_stride;
+	m2v_kern_active->add(Mt->e + ot, M1->e + o1, oe - ot);
+}
+
+void m2v_multadd_rows(const m2v* M1,
+			const int* rows,
+			const int* alphas,
+			int n,
+			m2v* Mt,
+			int rt)
+{
+	assert(M1->n_col == Mt->n_col);
+	assert(0 <= rt && rt < Mt->n_row);
+
+	/* Collect the rows with nonzero coefficient, then do a single
+	 * pass over the target words.
+	 */
+	const m2v_base* src[n > 0 ? n : 1];
+	int k = 0;
+	for (int j = 0; j < n; ++j) {
+		assert(0 <= rows[j] && rows[j] < M1->n_row);
+		if (alphas[j] != 0)
+			src[k++] = M1->e + get_word(M1, rows[j], 0);
 	}
+
+	m2v_kern_active->add_multi(Mt->e + get_word(Mt, rt, 0), src, k,
+					Mt->row_stride);
 }
 
 void m2v_copy_row(const m2v* M1, int r1, m2v* Mt, int rt)
@@ -131,25 +150,24 @@ void m2v_copy_row(const m2v* M1, int r1, m2v* Mt, int rt)
 	assert(0 <= r1 && r1 < M1->n_row);
 	assert(0 <= rt && rt < Mt->n_row);
 
-	const int o1 = get_word(M1, r1, 0);
-	const int ot = get_word(Mt, rt, 0);
-	for (int i = 0; i < Mt->row_stride; ++i) {
-		Mt->e[ot + i] = M1->e[o1 + i];
-	}
+	if (M1->e + get_word(M1, r1, 0) == Mt->e + get_word(Mt, rt, 0))
+		return;
+	memcpy(Mt->e + get_word(Mt, rt, 0), M1->e + get_word(M1, r1, 0),
+		Mt->row_stride * sizeof(m2v_base));
 }
 
 int m2v_row_iszero(const m2v* M, int r)
 {
 	assert(0 <= r && r < M->n_row);
 
-	int o = get_word(M, r, 0);
+	if (M->n_col == 0)
+		return 1;
+	const int o = get_word(M, r, 0);
 	const int oe = get_word(M, r, M->n_col - 1);
 
 	/* Check all sections but the last */
-	while (o < oe) {
-		if (M->e[o++] != 0)
-			return 0;
-	}
+	if (!m2v_kern_active->iszero(M->e + o, oe - o))
+		return 0;
 
 	/* Check last section, using correct masking */
 	const m2v_base m = (get_mask(get_bit(M, M->n_col - 1)) << 1) - 1;
@@ -158,6 +176,21 @@ int m2v_row_iszero(const m2v* M, int r)
 	return 1;
 }
 
+int m2v_row_weight(const m2v* M, int r)
+{
+	assert(0 <= r && r < M->n_row);
+
+	if (M->n_col == 0)
+		return 0;
+	const int o = get_word(M, r, 0);
+	const int oe = get_word(M, r, M->n_col - 1);
+
+	/* Count all sections but the last, then the masked last one */
+	const m2v_base m = (get_mask(get_bit(M, M->n_col - 1)) << 1) - 1;
+	return (int)m2v_kern_active->weight(M->e + o, oe - o)
+		+ __builtin_popcountll(M->e[oe] & m);
+}
+
 void m2v_swap_cols(m2v* M, int c1, int c2)
 {
 	assert(0 <= c1 && c1 < M->n_col);
@@ -258,4 +291,7 @@ void m2v_copy_col(const m2v* M1,
 #define MV_GEN_PREFIX	m2v
 #define MV_GEN_ELTYPE	int
 #define MV_GEN_DEFINITIONS
+#define MV_GEN_CUSTOM_MUL		/* see m2v_m4r.c */
+#define MV_GEN_CUSTOM_LU_DECOMP		/* see m2v_m4r.c */
+#define MV_GEN_CUSTOM_COL_OPS		/* see m2v_transpose.c */
 #include "mv_generic.h"
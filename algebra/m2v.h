@@ -4,19 +4,25 @@
 /**	@file m2v.h
  *
  *	Matrix views over GF2.
+ *
+ *	Rows are stored as bit vectors in 64-bit words, padded to a whole
+ *	word only; the row operations of m2v_kern.h handle the tails of
+ *	rows that are not a multiple of the vector width.  The padding
+ *	bits carry no meaning; they may be changed by row operations.
  */
 
 #include <assert.h>
 #include <limits.h>
 #include <stddef.h>
+#include <stdint.h>
 
-typedef unsigned int m2v_base;
+typedef uint64_t m2v_base;
 
 typedef struct {
 	int n_row;		/* number of rows */
 	int n_col;		/* number of columns */
 
-	int row_stride;		/* number of m2v_base used per row */
+	int row_stride;		/* number of m2v_base per row, padded */
 
 	m2v_base* e;
 } m2v;
@@ -48,11 +54,18 @@ void m2v_multadd_row_from(const m2v* M1,
 			int alpha,
 			m2v* Mt,
 			int rt);
+void m2v_multadd_rows(const m2v* M1,
+			const int* rows,
+			const int* alphas,
+			int n,
+			m2v* Mt,
+			int rt);
 void m2v_copy_row(const m2v* M1,
 			int r1,
 			m2v* Mt,
 			int rt);
 int m2v_row_iszero(const m2v* M, int r);
+int m2v_row_weight(const m2v* M, int r);	/* number of ones in row r */
 
 void m2v_swap_cols(m2v* M, int c1, int c2);
 void m2v_mult_col_from(m2v* M, int c, int offs, int alpha);
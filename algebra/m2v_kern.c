@@ -0,0 +1,218 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "m2v_kern.h"
+
+/* Scalar kernels */
+
+static void add_scalar(m2v_base* t, const m2v_base* s, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		t[i] ^= s[i];
+}
+
+static void add_multi_scalar(m2v_base* t,
+				const m2v_base* const* s,
+				int k,
+				size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		m2v_base w = t[i];
+		for (int j = 0; j < k; ++j)
+			w ^= s[j][i];
+		t[i] = w;
+	}
+}
+
+static void swap_scalar(m2v_base* a, m2v_base* b, size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		const m2v_base sw = a[i];
+		a[i] = b[i];
+		b[i] = sw;
+	}
+}
+
+static int iszero_scalar(const m2v_base* t, size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		if (t[i] != 0)
+			return 0;
+	}
+	return 1;
+}
+
+static size_t weight_scalar(const m2v_base* t, size_t n)
+{
+	size_t w = 0;
+	for (size_t i = 0; i < n; ++i)
+		w += __builtin_popcountll(t[i]);
+	return w;
+}
+
+const m2v_kern m2v_kern_scalar = {
+	.name = "scalar",
+	.add = add_scalar,
+	.add_multi = add_multi_scalar,
+	.swap = swap_scalar,
+	.iszero = iszero_scalar,
+	.weight = weight_scalar,
+};
+
+/* Kernel selection */
+
+typedef struct {
+	const m2v_kern* kern;
+	int (*supported)(void);
+} kern_entry;
+
+static int always(void)
+{
+	return 1;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#ifdef M2V_KERN_AVX2
+static int have_avx2(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+#endif
+#ifdef M2V_KERN_AVX512
+static int have_avx512(void)
+{
+	return __builtin_cpu_supports("avx512f")
+		&& __builtin_cpu_supports("avx512bw");
+}
+#endif
+#endif
+
+/* Kernel sets, in increasing order of preference */
+static const kern_entry kern_table[] = {
+	{ &m2v_kern_scalar,	always },
+#ifdef M2V_KERN_AVX2
+	{ &m2v_kern_avx2,	have_avx2 },
+#endif
+#ifdef M2V_KERN_AVX512
+	{ &m2v_kern_avx512,	have_avx512 },
+#endif
+};
+
+#define kern_table_sz	((int)(sizeof(kern_table) / sizeof(kern_table[0])))
+
+const m2v_kern* m2v_kern_active = &m2v_kern_scalar;
+
+const m2v_kern* m2v_kern_find(const char* name)
+{
+	for (int i = 0; i < kern_table_sz; ++i) {
+		if (strcmp(kern_table[i].kern->name, name) == 0) {
+			if (!kern_table[i].supported())
+				return NULL;
+			return kern_table[i].kern;
+		}
+	}
+	return NULL;
+}
+
+int m2v_kern_select(const char* name)
+{
+	const m2v_kern* k = m2v_kern_find(name);
+	if (k == NULL)
+		return -1;
+	m2v_kern_active = k;
+	return 0;
+}
+
+int m2v_kern_selftest(const m2v_kern* k)
+{
+	/* All lengths up to a few vectors are checked, starting one word
+	 * off a 64 byte boundary, so that the vector loops as well as
+	 * the tail handling are exercised.
+	 */
+	enum { max_n = 40 };
+	m2v_base buf[8 + 1 + max_n] __attribute__((aligned(64)));
+	m2v_base s[3][max_n], ref[max_n];
+	m2v_base* x = buf + 1;
+	m2v_base v = 0x9e3779b97f4a7c15ull;
+	for (int i = 0; i < max_n; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			v = v * 6364136223846793005ull + 1442695040888963407ull;
+			s[j][i] = v;
+		}
+	}
+
+	for (size_t n = 0; n <= max_n; ++n) {
+		/* add */
+		memcpy(x, s[0], n * sizeof(m2v_base));
+		k->add(x, s[1], n);
+		for (size_t i = 0; i < n; ++i) {
+			ref[i] = s[0][i] ^ s[1][i];
+			if (x[i] != ref[i])
+				return 0;
+		}
+
+		/* add_multi, with a repeated source */
+		const m2v_base* srcs[3] = { s[1], s[2], s[2] };
+		memcpy(x, s[0], n * sizeof(m2v_base));
+		k->add_multi(x, srcs, 3, n);
+		if (memcmp(x, ref, n * sizeof(m2v_base)) != 0)
+			return 0;
+
+		/* swap */
+		m2v_base y[max_n];
+		memcpy(y, s[2], n * sizeof(m2v_base));
+		k->swap(x, y, n);
+		if (memcmp(x, s[2], n * sizeof(m2v_base)) != 0
+		  || memcmp(y, ref, n * sizeof(m2v_base)) != 0)
+			return 0;
+
+		/* weight and iszero, with a single bit set anywhere */
+		size_t w = 0;
+		for (size_t i = 0; i < n; ++i)
+			w += __builtin_popcountll(s[0][i]);
+		if (k->weight(s[0], n) != w)
+			return 0;
+		memset(x, 0, n * sizeof(m2v_base));
+		if (!k->iszero(x, n) || k->weight(x, n) != 0)
+			return 0;
+		for (size_t i = 0; i < n; ++i) {
+			x[i] = (m2v_base)1 << (i % m2v__Bits_per_base);
+			if (k->iszero(x, n) || k->weight(x, n) != 1)
+				return 0;
+			x[i] = 0;
+		}
+	}
+
+	return 1;
+}
+
+const m2v_kern* m2v_kern_get_nth(int i)
+{
+	for (int j = 0; j < kern_table_sz; ++j) {
+		if (!kern_table[j].supported())
+			continue;
+		if (i-- == 0)
+			return kern_table[j].kern;
+	}
+	return NULL;
+}
+
+__attribute__((constructor))
+static void m2v_kern_init(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	/* This may run before libgcc has initialized its CPU model */
+	__builtin_cpu_init();
+#endif
+
+	/* Pick the most preferred supported kernel set that passes the
+	 * self test.
+	 */
+	for (int i = kern_table_sz - 1; i >= 0; --i) {
+		if (kern_table[i].supported()
+		  && (i == 0 || m2v_kern_selftest(kern_table[i].kern))) {
+			m2v_kern_active = kern_table[i].kern;
+			break;
+		}
+	}
+}
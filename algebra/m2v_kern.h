@@ -0,0 +1,86 @@
+#ifndef M2V_KERN_H
+#define M2V_KERN_H
+
+/**	@file m2v_kern.h
+ *
+ *	Word-vector kernels for GF(2) row operations.
+ *
+ *	The m2v row operations reduce to a few primitives on contiguous
+ *	ranges of m2v_base words.  As for m256v_kern.h, these are
+ *	provided by a portable scalar backend and SIMD variants, and the
+ *	fastest one supported by the CPU is selected when the library is
+ *	loaded.
+ *
+ *	All kernels accept arbitrary alignment and lengths.  The source
+ *	and target ranges must either be identical or not overlap.
+ */
+
+#include <stddef.h>
+
+#include "m2v.h"
+
+typedef struct {
+	const char* name;
+
+	/** t[i] ^= s[i] for 0 <= i < n */
+	void (*add)(m2v_base* t, const m2v_base* s, size_t n);
+
+	/** t[i] ^= sum_j s[j][i] for 0 <= i < n, 0 <= j < k
+	 *
+	 *  The target is traversed once; the sources must not overlap
+	 *  the target.
+	 */
+	void (*add_multi)(m2v_base* t,
+				const m2v_base* const* s,
+				int k,
+				size_t n);
+
+	/** Exchange a[i] and b[i] for 0 <= i < n */
+	void (*swap)(m2v_base* a, m2v_base* b, size_t n);
+
+	/** 1 if t[i] == 0 for all 0 <= i < n, 0 otherwise */
+	int (*iszero)(const m2v_base* t, size_t n);
+
+	/** Number of bits set in t[0], ..., t[n - 1] */
+	size_t (*weight)(const m2v_base* t, size_t n);
+} m2v_kern;
+
+/**	The currently active kernel set. */
+extern const m2v_kern* m2v_kern_active;
+
+/**	Look up a kernel set by name.
+ *
+ *	@return		The kernel set, or NULL if the kernel set does not
+ *			exist or is not supported by this CPU.
+ */
+const m2v_kern* m2v_kern_find(const char* name);
+
+/**	Select the kernel set to use.
+ *
+ *	@return		0 on success, -1 if the kernel set is unavailable.
+ */
+int m2v_kern_select(const char* name);
+
+/**	Verify a kernel set against word-by-word computation.
+ *
+ *	The SIMD kernel sets are checked before they are selected at
+ *	load time.
+ *
+ *	@return		1 if the kernel set computes correct results, 0
+ *			otherwise.
+ */
+int m2v_kern_selftest(const m2v_kern* k);
+
+/**	Enumerate the kernel sets supported by this CPU.
+ *
+ *	@return		The i-th supported kernel set, or NULL if i is
+ *			out of range.
+ */
+const m2v_kern* m2v_kern_get_nth(int i);
+
+/* Backend kernel sets; only defined if compiled in. */
+extern const m2v_kern m2v_kern_scalar;
+extern const m2v_kern m2v_kern_avx2;
+extern const m2v_kern m2v_kern_avx512;
+
+#endif /* M2V_KERN_H */
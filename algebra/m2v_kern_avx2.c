@@ -0,0 +1,124 @@
+/**	@file m2v_kern_avx2.c
+ *
+ *	AVX2 word kernels.  Needs to be compiled with -mavx2.
+ *
+ *	The population count uses the nibble lookup with vpshufb, and
+ *	vpsadbw to sum up the byte counts, so that no popcnt support is
+ *	required.
+ */
+
+#include <immintrin.h>
+
+#include "m2v_kern.h"
+
+/* Words per vector */
+#define VW	(sizeof(__m256i) / sizeof(m2v_base))
+
+static inline __m256i load(const m2v_base* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+static inline void store(m2v_base* p, __m256i v)
+{
+	_mm256_storeu_si256((__m256i*)p, v);
+}
+
+static void add_avx2(m2v_base* t, const m2v_base* s, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2*VW <= n; i += 2*VW) {
+		store(t + i, _mm256_xor_si256(load(t + i), load(s + i)));
+		store(t + i + VW, _mm256_xor_si256(load(t + i + VW),
+					load(s + i + VW)));
+	}
+	for (; i + VW <= n; i += VW)
+		store(t + i, _mm256_xor_si256(load(t + i), load(s + i)));
+	for (; i < n; ++i)
+		t[i] ^= s[i];
+}
+
+static void add_multi_avx2(m2v_base* t,
+				const m2v_base* const* s,
+				int k,
+				size_t n)
+{
+	size_t i = 0;
+	for (; i + VW <= n; i += VW) {
+		__m256i acc = load(t + i);
+		for (int j = 0; j < k; ++j)
+			acc = _mm256_xor_si256(acc, load(s[j] + i));
+		store(t + i, acc);
+	}
+	for (; i < n; ++i) {
+		m2v_base w = t[i];
+		for (int j = 0; j < k; ++j)
+			w ^= s[j][i];
+		t[i] = w;
+	}
+}
+
+static void swap_avx2(m2v_base* a, m2v_base* b, size_t n)
+{
+	size_t i = 0;
+	for (; i + VW <= n; i += VW) {
+		const __m256i va = load(a + i);
+		store(a + i, load(b + i));
+		store(b + i, va);
+	}
+	for (; i < n; ++i) {
+		const m2v_base sw = a[i];
+		a[i] = b[i];
+		b[i] = sw;
+	}
+}
+
+static int iszero_avx2(const m2v_base* t, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2*VW <= n; i += 2*VW) {
+		const __m256i v = _mm256_or_si256(load(t + i), load(t + i + VW));
+		if (!_mm256_testz_si256(v, v))
+			return 0;
+	}
+	for (; i < n; ++i) {
+		if (t[i] != 0)
+			return 0;
+	}
+	return 1;
+}
+
+static size_t weight_avx2(const m2v_base* t, size_t n)
+{
+	const __m256i lookup = _mm256_setr_epi8(
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i mask = _mm256_set1_epi8(0x0f);
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + VW <= n; i += VW) {
+		const __m256i v = load(t + i);
+		const __m256i lo = _mm256_and_si256(v, mask);
+		const __m256i hi = _mm256_and_si256(_mm256_srli_epi64(v, 4), mask);
+		const __m256i c = _mm256_add_epi8(
+					_mm256_shuffle_epi8(lookup, lo),
+					_mm256_shuffle_epi8(lookup, hi));
+		acc = _mm256_add_epi64(acc,
+				_mm256_sad_epu8(c, _mm256_setzero_si256()));
+	}
+
+	size_t w = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+		+ _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+	for (; i < n; ++i)
+		w += __builtin_popcountll(t[i]);
+	return w;
+}
+
+const m2v_kern m2v_kern_avx2 = {
+	.name = "avx2",
+	.add = add_avx2,
+	.add_multi = add_multi_avx2,
+	.swap = swap_avx2,
+	.iszero = iszero_avx2,
+	.weight = weight_avx2,
+};
@@ -0,0 +1,112 @@
+/**	@file m2v_kern_avx512.c
+ *
+ *	AVX-512 word kernels.  Needs to be compiled with -mavx512f
+ *	-mavx512bw.
+ *
+ *	Tails are handled with masked loads and stores.  The population
+ *	count is done as in m2v_kern_avx2.c, since vpopcntq
+ *	(AVX512_VPOPCNTDQ) is not available on all AVX-512 CPUs.
+ */
+
+#include <immintrin.h>
+
+#include "m2v_kern.h"
+
+/* Words per vector */
+#define VW	(sizeof(__m512i) / sizeof(m2v_base))
+
+static inline __m512i load(const m2v_base* p)
+{
+	return _mm512_loadu_si512(p);
+}
+
+static inline void store(m2v_base* p, __m512i v)
+{
+	_mm512_storeu_si512(p, v);
+}
+
+static inline __mmask8 tail_mask(size_t n)
+{
+	return (__mmask8)((1u << n) - 1);
+}
+
+static void add_avx512(m2v_base* t, const m2v_base* s, size_t n)
+{
+	size_t i = 0;
+	for (; i + VW <= n; i += VW)
+		store(t + i, _mm512_xor_si512(load(t + i), load(s + i)));
+	if (i < n) {
+		const __mmask8 m = tail_mask(n - i);
+		const __m512i v = _mm512_xor_si512(
+					_mm512_maskz_loadu_epi64(m, t + i),
+					_mm512_maskz_loadu_epi64(m, s + i));
+		_mm512_mask_storeu_epi64(t + i, m, v);
+	}
+}
+
+static void add_multi_avx512(m2v_base* t,
+				const m2v_base* const* s,
+				int k,
+				size_t n)
+{
+	for (size_t i = 0; i < n; i += VW) {
+		const __mmask8 m = (n - i < VW) ? tail_mask(n - i) : 0xff;
+		__m512i acc = _mm512_maskz_loadu_epi64(m, t + i);
+		for (int j = 0; j < k; ++j) {
+			acc = _mm512_xor_si512(acc,
+					_mm512_maskz_loadu_epi64(m, s[j] + i));
+		}
+		_mm512_mask_storeu_epi64(t + i, m, acc);
+	}
+}
+
+static void swap_avx512(m2v_base* a, m2v_base* b, size_t n)
+{
+	for (size_t i = 0; i < n; i += VW) {
+		const __mmask8 m = (n - i < VW) ? tail_mask(n - i) : 0xff;
+		const __m512i va = _mm512_maskz_loadu_epi64(m, a + i);
+		const __m512i vb = _mm512_maskz_loadu_epi64(m, b + i);
+		_mm512_mask_storeu_epi64(a + i, m, vb);
+		_mm512_mask_storeu_epi64(b + i, m, va);
+	}
+}
+
+static int iszero_avx512(const m2v_base* t, size_t n)
+{
+	for (size_t i = 0; i < n; i += VW) {
+		const __mmask8 m = (n - i < VW) ? tail_mask(n - i) : 0xff;
+		const __m512i v = _mm512_maskz_loadu_epi64(m, t + i);
+		if (_mm512_test_epi64_mask(v, v) != 0)
+			return 0;
+	}
+	return 1;
+}
+
+static size_t weight_avx512(const m2v_base* t, size_t n)
+{
+	const __m512i lookup = _mm512_broadcast_i32x4(_mm_setr_epi8(
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+	const __m512i mask = _mm512_set1_epi8(0x0f);
+	__m512i acc = _mm512_setzero_si512();
+	for (size_t i = 0; i < n; i += VW) {
+		const __mmask8 m = (n - i < VW) ? tail_mask(n - i) : 0xff;
+		const __m512i v = _mm512_maskz_loadu_epi64(m, t + i);
+		const __m512i lo = _mm512_and_si512(v, mask);
+		const __m512i hi = _mm512_and_si512(_mm512_srli_epi64(v, 4), mask);
+		const __m512i c = _mm512_add_epi8(
+					_mm512_shuffle_epi8(lookup, lo),
+					_mm512_shuffle_epi8(lookup, hi));
+		acc = _mm512_add_epi64(acc,
+				_mm512_sad_epu8(c, _mm512_setzero_si512()));
+	}
+	return _mm512_reduce_add_epi64(acc);
+}
+
+const m2v_kern m2v_kern_avx512 = {
+	.name = "avx512",
+	.add = add_avx512,
+	.add_multi = add_multi_avx512,
+	.swap = swap_avx512,
+	.iszero = iszero_avx512,
+	.weight = weight_avx512,
+};
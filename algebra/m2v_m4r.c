@@ -0,0 +1,343 @@
+/**	@file m2v_m4r.c
+ *
+ *	Multiplication and LU decomposition of GF(2) matrices with the
+ *	method of the Four Russians.
+ *
+ *	Both work on groups of up to M4R_K rows:  all sums of subsets of
+ *	the rows of a group are tabulated, in Gray code order so that
+ *	each table entry costs a single row addition.  A target row then
+ *	receives the sum selected by its bits in the other factor with
+ *	one row addition, instead of up to M4R_K.
+ *
+ *	The multiplication (M4RM) groups the rows of the right factor.
+ *	The LU decomposition (M4RI) is blocked like m256v_lu.c:  Panels
+ *	of M4R_K columns are factored with the elimination restricted to
+ *	the panel columns.  The panel's rows of U are then completed by
+ *	a triangular solve, and the rows below receive their updates to
+ *	the trailing columns from the table of the U rows.  The pivot
+ *	search is the one of m2v_LU_decomp_inplace_basic, and so is the
+ *	result.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "m2v.h"
+#include "m2v_kern.h"
+
+/* Number of rows tabulated together.  With 8, the table of sums has
+ * 256 rows, and the trailing update of a row takes one row addition
+ * per 8 pivots.
+ */
+#define M4R_K		8
+
+/* Maximum size of a table in words (64 KiB).  Wider matrices use
+ * fewer rows per table, and rows too wide even for a table of two
+ * rows are tabulated in strips of columns.
+ */
+#define M4R_TABLE_WORDS	(1 << 13)
+
+/* Matrices with fewer rows or columns than M4R_LU_MIN, or more rows
+ * than M4R_LU_MAX_ROWS, are decomposed with
+ * m2v_LU_decomp_inplace_basic.  The limit keeps the panel bits, one
+ * byte per row, at 64 KiB of stack.
+ */
+#define M4R_LU_MIN	64
+#define M4R_LU_MAX_ROWS	(1 << 16)
+
+#define bpb		((int)m2v__Bits_per_base)
+
+#define SwapInt(a, b) \
+	do { \
+		const int SwapInt__swval = (b); \
+		(b) = (a); \
+		(a) = SwapInt__swval; \
+	} while(0)
+
+static m2v_base* row_of(const m2v* M, int r)
+{
+	return M->e + (size_t)r * M->row_stride;
+}
+
+/* Number of rows per table for rows of n_words words; the table is
+ * to be made in strips of M4R_TABLE_WORDS >> k words.
+ */
+static int table_k(int n_words)
+{
+	int k = M4R_K;
+	while (k > 1 && ((size_t)n_words << k) > M4R_TABLE_WORDS)
+		--k;
+	return k;
+}
+
+/* The n <= bpb bits of row from column c0 on */
+static int get_bits(const m2v_base* row, int c0, int n)
+{
+	const int w = c0 / bpb;
+	const int b = c0 % bpb;
+	m2v_base x = row[w] >> b;
+	if (b + n > bpb)
+		x |= row[w + 1] << (bpb - b);
+	return (int)(x & ((((m2v_base)1) << n) - 1));
+}
+
+/* Set the n <= bpb bits of row from column c0 on to x */
+static void set_bits(m2v_base* row, int c0, int n, int x)
+{
+	const int w = c0 / bpb;
+	const int b = c0 % bpb;
+	const m2v_base m = (((m2v_base)1) << n) - 1;
+	row[w] = (row[w] & ~(m << b)) | ((m2v_base)x << b);
+	if (b + n > bpb) {
+		row[w + 1] = (row[w + 1] & ~(m >> (bpb - b)))
+				| ((m2v_base)x >> (bpb - b));
+	}
+}
+
+/* Tabulate the sums of the k rows src[] in the words [w0, w1):  T[g]
+ * is the sum of the rows src[i] with bit i set in g.
+ */
+static void make_table(m2v_base* T, const m2v_base* const* src, int k,
+			int w0, int w1)
+{
+	const int n = w1 - w0;
+	memset(T, 0, n * sizeof(m2v_base));
+	int g_prev = 0;
+	for (int i = 1; i < (1 << k); ++i) {
+		const int g = i ^ (i >> 1);
+		const m2v_base* s = src[__builtin_ctz(i)] + w0;
+		const m2v_base* tp = T + (size_t)g_prev * n;
+		m2v_base* t = T + (size_t)g * n;
+		for (int w = 0; w < n; ++w)
+			t[w] = tp[w] ^ s[w];
+		g_prev = g;
+	}
+}
+
+void m2v_mul(const m2v* A, const m2v* B, m2v* AB_out)
+{
+	assert(A->n_col == B->n_row);
+	assert(A->n_row == AB_out->n_row);
+	assert(B->n_col == AB_out->n_col);
+
+	const int n_words = m2v_get_row_size(B->n_col);
+	const int k = table_k(n_words);
+	const int strip = M4R_TABLE_WORDS >> k;
+	m2v_base T[M4R_TABLE_WORDS];
+	const m2v_base* src[M4R_K];
+
+	for (int i = 0; i < AB_out->n_row; ++i)
+		m2v_clear_row(AB_out, i);
+	for (int kb = 0; kb < A->n_col; kb += k) {
+		const int nb = (A->n_col - kb < k) ? A->n_col - kb : k;
+		for (int j = 0; j < nb; ++j)
+			src[j] = row_of(B, kb + j);
+		for (int w0 = 0; w0 < n_words; w0 += strip) {
+			const int w1 = (n_words - w0 < strip)
+					? n_words : w0 + strip;
+			const int n = w1 - w0;
+			make_table(T, src, nb, w0, w1);
+			for (int i = 0; i < A->n_row; ++i) {
+				const int g = get_bits(row_of(A, i), kb, nb);
+				if (g == 0)
+					continue;
+				m2v_kern_active->add(row_of(AB_out, i) + w0,
+						T + (size_t)g * n, n);
+			}
+		}
+	}
+}
+
+/* Row rt += row r1 in the columns [c0, c1) */
+static void add_row_range(m2v* A, int r1, int rt, int c0, int c1)
+{
+	if (c0 >= c1)
+		return;
+	const m2v_base* s = row_of(A, r1);
+	m2v_base* t = row_of(A, rt);
+	const int w0 = c0 / bpb;
+	const int w1 = (c1 - 1) / bpb;
+	for (int w = w0; w <= w1; ++w) {
+		m2v_base m = ~(m2v_base)0;
+		if (w == w0)
+			m &= ~(m2v_base)0 << (c0 % bpb);
+		if (w == w1 && c1 % bpb != 0)
+			m &= (((m2v_base)1) << (c1 % bpb)) - 1;
+		t[w] ^= s[w] & m;
+	}
+}
+
+/* Find the first nonzero in column-major order in the columns
+ * [c0, c1), rows from r0 on.  Returns 0 if there is none.
+ */
+static int find_pivot(const m2v* A, int r0, int c0, int c1,
+			int* prow, int* pcol)
+{
+	for (int c = c0; c < c1; ++c) {
+		for (int r = r0; r < A->n_row; ++r) {
+			if (m2v_get_el(A, r, c)) {
+				*prow = r;
+				*pcol = c;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Bring the pivot at (prow, pcol) to (i, i), and eliminate below it */
+static void pivot_step(m2v* A, int* rp, int* cp, int i, int prow, int pcol)
+{
+	if (prow != i) {
+		SwapInt(rp[i], rp[prow]);
+		m2v_swap_rows(A, i, prow);
+	}
+	if (pcol != i) {
+		SwapInt(cp[i], cp[pcol]);
+		m2v_swap_cols(A, pcol, i);
+	}
+
+	for (int j = i + 1; j < A->n_row; ++j) {
+		if (m2v_get_el(A, j, i))
+			add_row_range(A, i, j, i + 1, A->n_col);
+	}
+}
+
+/* Factor the panel of the columns [k0, k1), k1 - k0 <= M4R_K, with
+ * the elimination restricted to the panel.  The panel bits of the
+ * rows from k0 on are worked on in pb[].  Returns the end of the
+ * pivots found.
+ */
+static int factor_panel(m2v* A, int* rp, int* cp, int k0, int k1)
+{
+	const int nb = k1 - k0;
+	uint8_t pb[A->n_row];
+	for (int r = k0; r < A->n_row; ++r)
+		pb[r] = get_bits(row_of(A, r), k0, nb);
+
+	int i = k0;
+	for (; i < k1 && i < A->n_row; ++i) {
+		/* Find the pivot in column-major order */
+		int prow = -1, pcol;
+		for (pcol = i; pcol < k1 && prow < 0; ++pcol) {
+			for (int r = i; r < A->n_row; ++r) {
+				if (pb[r] >> (pcol - k0) & 1) {
+					prow = r;
+					break;
+				}
+			}
+		}
+		if (prow < 0)
+			break;
+		--pcol;
+
+		if (prow != i) {
+			SwapInt(rp[i], rp[prow]);
+			SwapInt(pb[i], pb[prow]);
+			m2v_swap_rows(A, i, prow);
+		}
+		if (pcol != i) {
+			SwapInt(cp[i], cp[pcol]);
+			m2v_swap_cols(A, pcol, i);
+			const int b1 = i - k0, b2 = pcol - k0;
+			for (int r = k0; r < A->n_row; ++r) {
+				const int x = (pb[r] >> b1 ^ pb[r] >> b2) & 1;
+				pb[r] ^= (x << b1) | (x << b2);
+			}
+		}
+
+		const int bit = i - k0;
+		const int u = pb[i] & ~((2 << bit) - 1);
+		for (int j = i + 1; j < A->n_row; ++j) {
+			if (pb[j] >> bit & 1)
+				pb[j] ^= u;
+		}
+	}
+
+	for (int r = k0; r < A->n_row; ++r)
+		set_bits(row_of(A, r), k0, nb, pb[r]);
+	return i;
+}
+
+/* Apply the updates of the pivots [k0, k1) to the columns from c1 on */
+static void update_trailing(m2v* A, int k0, int k1, int c1)
+{
+	const int np = k1 - k0;
+	if (np == 0 || c1 >= A->n_col)
+		return;
+
+	/* Rows of U:  triangular solve within the panel */
+	for (int j = k0 + 1; j < k1; ++j) {
+		for (int l = k0; l < j; ++l) {
+			if (m2v_get_el(A, j, l))
+				add_row_range(A, l, j, c1, A->n_col);
+		}
+	}
+
+	/* Rows below:  one table lookup per row and strip.  The tables
+	 * cover the words from the one containing c1; the bits left of
+	 * c1 are cleared.
+	 */
+	const int strip = M4R_TABLE_WORDS >> np;
+	const int n_words = m2v_get_row_size(A->n_col);
+	m2v_base T[M4R_TABLE_WORDS];
+	const m2v_base* src[M4R_K];
+	for (int l = 0; l < np; ++l)
+		src[l] = row_of(A, k0 + l);
+	for (int w0 = c1 / bpb; w0 < n_words; w0 += strip) {
+		const int w1 = (n_words - w0 < strip) ? n_words : w0 + strip;
+		const int n = w1 - w0;
+		make_table(T, src, np, w0, w1);
+		if (w0 == c1 / bpb) {
+			const m2v_base m = ~(m2v_base)0 << (c1 % bpb);
+			for (int g = 0; g < (1 << np); ++g)
+				T[(size_t)g * n] &= m;
+		}
+
+		for (int j = k1; j < A->n_row; ++j) {
+			const int g = get_bits(row_of(A, j), k0, np);
+			if (g == 0)
+				continue;
+			m2v_kern_active->add(row_of(A, j) + w0,
+						T + (size_t)g * n, n);
+		}
+	}
+}
+
+int m2v_LU_decomp_inplace(m2v* A, int* rp, int* cp)
+{
+	const int n = (A->n_row < A->n_col) ? A->n_row : A->n_col;
+	if (n < M4R_LU_MIN || A->n_row > M4R_LU_MAX_ROWS)
+		return m2v_LU_decomp_inplace_basic(A, rp, cp);
+
+	/* Initialize permutations */
+	for (int i = 0; i < A->n_row; ++i)
+		rp[i] = i;
+	for (int i = 0; i < A->n_col; ++i)
+		cp[i] = i;
+
+	const int k = table_k(m2v_get_row_size(A->n_col));
+	int i = 0;
+	while (i < n) {
+		/* Factor the panel, and apply the deferred updates */
+		const int k0 = i;
+		const int k1 = (k0 + k < A->n_col) ? k0 + k : A->n_col;
+		i = factor_panel(A, rp, cp, k0, k1);
+		update_trailing(A, k0, i, k1);
+		if (i == k1 || i == A->n_row)
+			continue;
+
+		/* The panel columns ran out of pivots; continue the search
+		 * right of the panel, and eliminate with a full width
+		 * update.
+		 */
+		int prow, pcol;
+		if (!find_pivot(A, i, k1, A->n_col, &prow, &pcol))
+			break;
+		pivot_step(A, rp, cp, i, prow, pcol);
+		++i;
+	}
+
+	/* At this point, i is the rank of the matrix */
+	return i;
+}
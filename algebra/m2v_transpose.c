@@ -0,0 +1,152 @@
+/**	@file m2v_transpose.c
+ *
+ *	Blocked transpose, and the column operations built on it.
+ *
+ *	The matrix is worked on in 64 x 64 bit blocks, one m2v_base word
+ *	per row of a block.  A block is transposed in place in six rounds
+ *	of masked word swaps; after that, each of its columns is a single
+ *	word.  Permuting the columns of a strip of 64 rows then moves a
+ *	word per column instead of a bit per element.
+ *
+ *	The column permutation keeps a transposed strip on the stack, up
+ *	to PERM_WORDS words; wider matrices are permuted column by
+ *	column.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "m2v.h"
+
+/* Block size; the bits of an m2v_base */
+#define BLK		64
+
+/* Size of the buffer for the transposed strip in words (64 KiB, like
+ * the M4R tables), enough for 8192 columns
+ */
+#define PERM_WORDS	(1 << 13)
+
+/* Words of column masks m2v_mult_cols computes at a time */
+#define MASK_WORDS	64
+
+/* Transpose the 64 x 64 block a[] in place:  bit j of a[i] is element
+ * (i, j).  Round j exchanges the upper right and lower left j x j
+ * sub-blocks of each 2j x 2j block on the diagonal.
+ */
+static void transpose64(m2v_base a[BLK])
+{
+	m2v_base m = 0x00000000ffffffffull;
+	for (int j = BLK/2; j != 0; j >>= 1, m ^= m << j) {
+		for (int k = 0; k < BLK; k = ((k | j) + 1) & ~j) {
+			const m2v_base t = ((a[k] >> j) ^ a[k | j]) & m;
+			a[k] ^= t << j;
+			a[k | j] ^= t;
+		}
+	}
+}
+
+/* Words per row holding columns */
+static int n_words(const m2v* M)
+{
+	return (M->n_col + BLK - 1) / BLK;
+}
+
+/* Load the block of the rows [r0, r0 + 64) in word column w; rows past
+ * the end of M are zero.
+ */
+static void load_block(m2v_base a[BLK], const m2v* M, int r0, int w)
+{
+	const int h = (M->n_row - r0 < BLK) ? M->n_row - r0 : BLK;
+	const m2v_base* p = M->e + (size_t)r0 * M->row_stride + w;
+	for (int i = 0; i < h; ++i)
+		a[i] = p[(size_t)i * M->row_stride];
+	for (int i = h; i < BLK; ++i)
+		a[i] = 0;
+}
+
+static void store_block(const m2v_base a[BLK], m2v* M, int r0, int w)
+{
+	const int h = (M->n_row - r0 < BLK) ? M->n_row - r0 : BLK;
+	m2v_base* p = M->e + (size_t)r0 * M->row_stride + w;
+	for (int i = 0; i < h; ++i)
+		p[(size_t)i * M->row_stride] = a[i];
+}
+
+void m2v_transpose(const m2v* A, m2v* At_out)
+{
+	assert(A->n_row == At_out->n_col);
+	assert(A->n_col == At_out->n_row);
+
+	/* Bits past the last column of A end up in rows past the end of
+	 * At_out, and are not stored.
+	 */
+	m2v_base a[BLK];
+	for (int r0 = 0; r0 < A->n_row; r0 += BLK) {
+		for (int w = 0; w < n_words(A); ++w) {
+			load_block(a, A, r0, w);
+			transpose64(a);
+			store_block(a, At_out, w * BLK, r0 / BLK);
+		}
+	}
+}
+
+void m2v_permute_cols(m2v* M, const int* colperm)
+{
+	if (M->n_row == 0 || M->n_col == 0)
+		return;
+	const int nw = n_words(M);
+	if ((size_t)nw * BLK > PERM_WORDS) {
+		m2v_permute_cols_basic(M, colperm);
+		return;
+	}
+
+	/* T[c] is column c of the current strip of 64 rows */
+	m2v_base T[PERM_WORDS];
+	m2v_base a[BLK];
+	for (int r0 = 0; r0 < M->n_row; r0 += BLK) {
+		for (int w = 0; w < nw; ++w) {
+			load_block(T + w * BLK, M, r0, w);
+			transpose64(T + w * BLK);
+		}
+		for (int w = 0; w < nw; ++w) {
+			const int c0 = w * BLK;
+			const int n = (M->n_col - c0 < BLK) ? M->n_col - c0 : BLK;
+			for (int j = 0; j < n; ++j)
+				a[j] = T[colperm[c0 + j]];
+			for (int j = n; j < BLK; ++j)
+				a[j] = 0;
+			transpose64(a);
+			store_block(a, M, r0, w);
+		}
+	}
+}
+
+void m2v_mult_cols(m2v* M, const int* alphas)
+{
+	/* Over GF(2), this is masking out the columns with alpha 0; the
+	 * masks are made for MASK_WORDS words at a time.
+	 */
+	const int nw = n_words(M);
+	m2v_base mask[MASK_WORDS];
+	for (int w0 = 0; w0 < nw; w0 += MASK_WORDS) {
+		const int n = (nw - w0 < MASK_WORDS) ? nw - w0 : MASK_WORDS;
+		const int c_end = (M->n_col < (w0 + n) * BLK)
+					? M->n_col : (w0 + n) * BLK;
+		int all_ones = 1;
+		memset(mask, 0xff, sizeof(mask));
+		for (int c = w0 * BLK; c < c_end; ++c) {
+			if (alphas[c] == 0) {
+				mask[c / BLK - w0] &= ~((m2v_base)1 << (c % BLK));
+				all_ones = 0;
+			}
+		}
+		if (all_ones)
+			continue;
+
+		for (int r = 0; r < M->n_row; ++r) {
+			m2v_base* p = M->e + (size_t)r * M->row_stride + w0;
+			for (int w = 0; w < n; ++w)
+				p[w] &= mask[w];
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#include <assert.h>
+#include <string.h>
+
+#include "mhyb.h"
+
+mhyb mhyb_make(int n_sp_max, int nnz_max, int n_dense, int n_col,
+		int* row_ptr, int* row_cols, uint8_t* dense)
+{
+	mhyb M = {
+		.n_col = n_col,
+		.n_sp = 0,
+		.n_sp_max = n_sp_max,
+		.nnz_max = nnz_max,
+		.row_ptr = row_ptr,
+		.row_cols = row_cols,
+		.D = m256v_make(n_dense, n_col, dense),
+	};
+	row_ptr[0] = 0;
+	return M;
+}
+
+int mhyb_n_row(const mhyb* M)
+{
+	return M->n_sp + M->D.n_row;
+}
+
+int mhyb_nnz(const mhyb* M)
+{
+	return M->row_ptr[M->n_sp];
+}
+
+void mhyb_append_row(mhyb* M, const int* cols, int n)
+{
+	assert(M->n_sp < M->n_sp_max);
+	const int p = M->row_ptr[M->n_sp];
+	assert(p + n <= M->nnz_max);
+	memcpy(M->row_cols + p, cols, n * sizeof(int));
+	M->row_ptr[++M->n_sp] = p + n;
+}
+
+int* mhyb_reserve_rows(mhyb* M, int n, const int* nnz)
+{
+	assert(M->n_sp + n <= M->n_sp_max);
+	for (int i = 0; i < n; ++i) {
+		M->row_ptr[M->n_sp + 1] = M->row_ptr[M->n_sp] + nnz[i];
+		++M->n_sp;
+	}
+	assert(M->row_ptr[M->n_sp] <= M->nnz_max);
+	return M->row_cols;
+}
+
+uint8_t mhyb_get_el(const mhyb* M, int r, int c)
+{
+	if (r >= M->n_sp)
+		return m256v_get_el(&M->D, r - M->n_sp, c);
+	for (int j = M->row_ptr[r]; j < M->row_ptr[r + 1]; ++j) {
+		if (M->row_cols[j] == c)
+			return 1;
+	}
+	return 0;
+}
+
+void mhyb_to_dense(const mhyb* M, m256v* A)
+{
+	assert(A->n_row == mhyb_n_row(M));
+	assert(A->n_col == M->n_col);
+
+	m256v S = m256v_get_subview(A, 0, 0, M->n_sp, M->n_col);
+	m256v_clear(&S);
+	for (int r = 0; r < M->n_sp; ++r) {
+		for (int j = M->row_ptr[r]; j < M->row_ptr[r + 1]; ++j)
+			m256v_set_el(A, r, M->row_cols[j], 1);
+	}
+	m256v Ad = m256v_get_subview(A, M->n_sp, 0, M->D.n_row, M->n_col);
+	m256v_copy(&M->D, &Ad);
+}
@@ -0,0 +1,73 @@
+#ifndef MHYB_H
+#define MHYB_H
+
+/**	@file mhyb.h
+ *
+ *	Hybrid matrices over GF256.
+ *
+ *	The first rows of a hybrid matrix are sparse binary rows, stored
+ *	as lists of the columns of their nonzero entries (which are all
+ *	1); the remaining rows are a dense m256v block.  This suits the
+ *	RQ matrix, whose LT and LDPC rows have a few nonzeros each, and
+ *	whose HDPC rows are dense.
+ *
+ *	Sparse rows are appended in order, with mhyb_append_row, or
+ *	with mhyb_reserve_rows and then filling in the columns.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "m256v.h"
+
+typedef struct {
+	int n_col;		/* number of cols */
+
+	int n_sp;		/* sparse rows so far */
+	int n_sp_max;		/* capacity for sparse rows */
+	int nnz_max;		/* capacity for nonzeros */
+	int* row_ptr;		/* n_sp_max + 1:  row r has the columns */
+	int* row_cols;		/* row_cols[row_ptr[r] .. row_ptr[r+1]-1] */
+
+	m256v D;		/* dense rows */
+} mhyb;
+
+/**	Initialize a hybrid matrix without any sparse rows.
+ *
+ *	As with m256v_make, the memory is provided by the user.
+ *
+ *	@param	row_ptr
+ *		Memory for n_sp_max + 1 ints.
+ *
+ *	@param	row_cols
+ *		Memory for nnz_max ints.
+ *
+ *	@param	dense
+ *		Memory for n_dense x n_col bytes.
+ */
+mhyb mhyb_make(int n_sp_max, int nnz_max, int n_dense, int n_col,
+		int* row_ptr, int* row_cols, uint8_t* dense);
+
+/**	Number of rows, sparse and dense. */
+int mhyb_n_row(const mhyb* M);
+
+/**	Number of nonzeros in the sparse rows. */
+int mhyb_nnz(const mhyb* M);
+
+/**	Append a sparse row with nonzeros in the n given columns. */
+void mhyb_append_row(mhyb* M, const int* cols, int n);
+
+/**	Append n sparse rows with the given numbers of nonzeros.
+ *
+ *	@return	The column array; the columns of row M->n_sp - n + i
+ *		go to positions M->row_ptr[M->n_sp - n + i] onwards,
+ *		and need to be filled in by the caller.
+ */
+int* mhyb_reserve_rows(mhyb* M, int n, const int* nnz);
+
+uint8_t mhyb_get_el(const mhyb* M, int r, int c);
+
+/**	Expand into a dense matrix of the same size. */
+void mhyb_to_dense(const mhyb* M, m256v* A);
+
+#endif /* MHYB_H */
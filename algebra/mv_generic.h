@@ -112,6 +112,32 @@ void MV_GEN_N(_permute_rows)(MV_GEN_TYPE* M, const int* rowperm);
  */
 void MV_GEN_N(_permute_cols)(MV_GEN_TYPE* M, const int* colperm);
 
+/** Column by column version of _permute_cols.
+ *
+ *  Specialized matrix types may implement _permute_cols differently
+ *  (see _mult_cols); this version then remains available for
+ *  matrices too wide for their scratch space.
+ */
+void MV_GEN_N(_permute_cols_basic)(MV_GEN_TYPE* M, const int* colperm);
+
+/** Transpose a matrix.
+ *
+ *  Stores the transpose of A in At_out, which needs to have n_col rows
+ *  and n_row columns, and must not overlap A.
+ */
+void MV_GEN_N(_transpose)(const MV_GEN_TYPE* A, MV_GEN_TYPE* At_out);
+
+/** Scale the columns of M in-place.
+ *
+ *  Multiplies column c of M by alphas[c], for 0 <= c < n_col.
+ *
+ *  The generic versions of this, _transpose and _permute_cols work
+ *  column by column.  Specialized matrix types provide blocked
+ *  versions (defining MV_GEN_CUSTOM_COL_OPS) that work on transposed
+ *  tiles instead.
+ */
+void MV_GEN_N(_mult_cols)(MV_GEN_TYPE* M, const MV_GEN_ELTYPE* alphas);
+
 void MV_GEN_N(_add)(const MV_GEN_TYPE* A, const MV_GEN_TYPE* B, MV_GEN_TYPE* AplusB_out);
 void MV_GEN_N(_add_inplace)(const MV_GEN_TYPE *A, MV_GEN_TYPE* B_inout);
 void MV_GEN_N(_mul)(const MV_GEN_TYPE* A, const MV_GEN_TYPE* B, MV_GEN_TYPE* AB_out);
@@ -165,6 +191,18 @@ int MV_GEN_N(_LU_decomp_inplace)(MV_GEN_TYPE* A,
 			int* rowperm,
 			int* colperm);
 
+/** Reference LU decomposition.
+ *
+ *  Plain right-looking elimination, with the same contract and the
+ *  same pivot choice as _LU_decomp_inplace.  Specialized matrix types
+ *  may implement _LU_decomp_inplace differently (by defining
+ *  MV_GEN_CUSTOM_LU_DECOMP); this version then remains available as
+ *  reference, and for small matrices.
+ */
+int MV_GEN_N(_LU_decomp_inplace_basic)(MV_GEN_TYPE* A,
+			int* rowperm,
+			int* colperm);
+
 /** Compute the determinant of a square LU decomposed matrix.
  *
  *  This computes the determinant of the LU decomposition (which is the
@@ -289,6 +327,13 @@ void MV_GEN_N(_U_invmult_inplace_p)(const MV_GEN_TYPE* LU,
 #error field arithmetic operation macros flog and fexp must be defined.
 #endif
 
+/* Number of terms accumulated per _multadd_rows call in the
+ * triangular solvers.
+ */
+#ifndef MV_GEN_MULTI_BATCH
+#define MV_GEN_MULTI_BATCH	16
+#endif
+
 /* Helpful macros */
 #define SwapInt(a, b) SwapInt_(a, b, SwapInt__swval)
 #define SwapInt_(a, b,			s) \
@@ -390,7 +435,7 @@ void MV_GEN_N(_permute_rows)(MV_GEN_TYPE* M, const int* rowperm)
 	}
 }
 
-void MV_GEN_N(_permute_cols)(MV_GEN_TYPE* M, const int* colperm)
+void MV_GEN_N(_permute_cols_basic)(MV_GEN_TYPE* M, const int* colperm)
 {
 	char visited[M->n_col];
 	for (int i = 0; i < M->n_col; ++i)
@@ -423,6 +468,32 @@ void MV_GEN_N(_permute_cols)(MV_GEN_TYPE* M, const int* colperm)
 	}
 }
 
+#ifndef MV_GEN_CUSTOM_COL_OPS
+void MV_GEN_N(_permute_cols)(MV_GEN_TYPE* M, const int* colperm)
+{
+	MV_GEN_N(_permute_cols_basic)(M, colperm);
+}
+
+void MV_GEN_N(_transpose)(const MV_GEN_TYPE* A, MV_GEN_TYPE* At_out)
+{
+	assert(A->n_row == At_out->n_col);
+	assert(A->n_col == At_out->n_row);
+
+	for (int i = 0; i < A->n_row; ++i) {
+		for (int j = 0; j < A->n_col; ++j) {
+			MV_GEN_N(_set_el)(At_out, j, i,
+					MV_GEN_N(_get_el)(A, i, j));
+		}
+	}
+}
+
+void MV_GEN_N(_mult_cols)(MV_GEN_TYPE* M, const MV_GEN_ELTYPE* alphas)
+{
+	for (int c = 0; c < M->n_col; ++c)
+		MV_GEN_N(_mult_col_from)(M, c, 0, alphas[c]);
+}
+#endif
+
 void MV_GEN_N(_add)(const MV_GEN_TYPE* A, const MV_GEN_TYPE* B, MV_GEN_TYPE* out)
 {
 	assert(A->n_row == B->n_row);
@@ -446,6 +517,7 @@ void MV_GEN_N(_add_inplace)(const MV_GEN_TYPE* A, MV_GEN_TYPE* B_inout)
 	}
 }
 
+#ifndef MV_GEN_CUSTOM_MUL
 void MV_GEN_N(_mul)(const MV_GEN_TYPE* A, const MV_GEN_TYPE* B, MV_GEN_TYPE* AB_out)
 {
 	assert(A->n_col == B->n_row);
@@ -464,8 +536,9 @@ void MV_GEN_N(_mul)(const MV_GEN_TYPE* A, const MV_GEN_TYPE* B, MV_GEN_TYPE* AB_
 		}
 	}
 }
+#endif
 
-int MV_GEN_N(_LU_decomp_inplace)(MV_GEN_TYPE* A,
+int MV_GEN_N(_LU_decomp_inplace_basic)(MV_GEN_TYPE* A,
 				int* rp,
 				int* cp)
 {
@@ -535,6 +608,15 @@ pivot_found:
 	return i;
 }
 
+#ifndef MV_GEN_CUSTOM_LU_DECOMP
+int MV_GEN_N(_LU_decomp_inplace)(MV_GEN_TYPE* A,
+				int* rp,
+				int* cp)
+{
+	return MV_GEN_N(_LU_decomp_inplace_basic)(A, rp, cp);
+}
+#endif
+
 MV_GEN_ELTYPE MV_GEN_N(_LU_det)(const MV_GEN_TYPE* LU)
 {
 	assert(LU->n_row == LU->n_col);
@@ -750,14 +832,32 @@ void MV_GEN_N(_L_invmult_inplace_p)(const MV_GEN_TYPE* LU,
 				MV_GEN_TYPE* X_inout,
 				const int* placements)
 {
-	/* Apply L^(-1) */
+	/* Apply L^(-1)
+	 *
+	 * The contributions to each row are collected in batches and
+	 * then applied in one go with _multadd_rows, so that the target
+	 * row is traversed once per batch instead of once per term.
+	 */
+	int rows[MV_GEN_MULTI_BATCH];
+	MV_GEN_ELTYPE alphas[MV_GEN_MULTI_BATCH];
 	for (int i = 0; i < rank; ++i) {
 		const int pi = (placements ? placements[i] : i);
+		int k = 0;
 		for (int j = 0; j < i; ++j) {
-			const int pj = (placements ? placements[j] : j);
-			MV_GEN_N(_multadd_row)(X_inout, pj,
-					MV_GEN_N(_get_el)(LU, i, j),
-					X_inout, pi);
+			const MV_GEN_ELTYPE Lij = MV_GEN_N(_get_el)(LU, i, j);
+			if (Lij == 0)
+				continue;
+			rows[k] = (placements ? placements[j] : j);
+			alphas[k] = Lij;
+			if (++k == MV_GEN_MULTI_BATCH) {
+				MV_GEN_N(_multadd_rows)(X_inout, rows, alphas,
+						k, X_inout, pi);
+				k = 0;
+			}
+		}
+		if (k > 0) {
+			MV_GEN_N(_multadd_rows)(X_inout, rows, alphas,
+					k, X_inout, pi);
 		}
 	}
 }
@@ -767,14 +867,27 @@ void MV_GEN_N(_U_invmult_inplace_p)(const MV_GEN_TYPE* LU,
 				MV_GEN_TYPE* X_inout,
 				const int* placements)
 {
-	/* Apply U^(-1) */
+	/* Apply U^(-1); batched like L^(-1) above */
+	int rows[MV_GEN_MULTI_BATCH];
+	MV_GEN_ELTYPE alphas[MV_GEN_MULTI_BATCH];
 	for (int i = rank - 1; i >= 0; --i) {
 		const int pi = (placements ? placements[i] : i);
+		int k = 0;
 		for (int j = i + 1; j < LU->n_col; ++j) {
-			const int pj = (placements ? placements[j] : j);
-			MV_GEN_N(_multadd_row)(X_inout, pj,
-			  MV_GEN_N(_get_el)(LU, i, j),
-			  X_inout, pi);
+			const MV_GEN_ELTYPE Uij = MV_GEN_N(_get_el)(LU, i, j);
+			if (Uij == 0)
+				continue;
+			rows[k] = (placements ? placements[j] : j);
+			alphas[k] = Uij;
+			if (++k == MV_GEN_MULTI_BATCH) {
+				MV_GEN_N(_multadd_rows)(X_inout, rows, alphas,
+						k, X_inout, pi);
+				k = 0;
+			}
+		}
+		if (k > 0) {
+			MV_GEN_N(_multadd_rows)(X_inout, rows, alphas,
+					k, X_inout, pi);
 		}
 		MV_GEN_N(_mult_row)(X_inout, pi,
 				finv(MV_GEN_N(_get_el)(LU, i, i)));
@@ -0,0 +1,21 @@
+#ifndef PAR_RUN_H
+#define PAR_RUN_H
+
+/**	@file par_run.h
+ *
+ *	Hook for running independent tasks in parallel.
+ *
+ *	The algebra routines do not manage threads themselves; those
+ *	that can use several take a runner from the caller, such as the
+ *	thread pool of the API library.
+ */
+
+typedef void (*par_task_fn)(void* arg, int i);
+
+/**	Run fn(arg, i) for i = 0, ..., n_tasks - 1, possibly at the same
+ *	time, and return when all of them are done.  The tasks must not
+ *	wait for each other.
+ */
+typedef void (*par_run_fn)(int n_tasks, par_task_fn fn, void* arg);
+
+#endif /* PAR_RUN_H */
@@ -15,6 +15,18 @@ extern "C" {
 
 // Intermediate Block API functions
 
+// The work memory holds the ESIs and the scratch memory of the
+// compilation, sized for K' + nMaxExtra ESIs.  With inactivation
+// decoding, the default, the scratch memory is dominated by a bit
+// matrix of L bits per row, about L^2 / 8 bytes in all (440 MB for
+// K = 56403).
+//
+// With inactivation decoding, the program memory size allows for the
+// programs of ESIs received at random, with a wide margin; programs
+// for unusual ESI sets can be larger (see RqInterGetProgMemNeeded).
+// With RQ_INTER_DENSE, it allows for the worst case, of order L^2
+// operations.  The programs compiled are often much smaller; see
+// RqInterGetProgramSize.
 RQAPI
 int RqInterGetMemSizes(int nMaxK,
 		       int nMaxExtra,
@@ -22,6 +34,14 @@ int RqInterGetMemSizes(int nMaxK,
 		       size_t* pInterProgMemSize,
 		       size_t* pInterSymNum);
 
+RQAPI
+int RqInterGetMemSizesEx(int nMaxK,
+			 int nMaxExtra,
+			 int nFlags,
+			 size_t* pInterWorkMemSize,
+			 size_t* pInterProgMemSize,
+			 size_t* pInterSymNum);
+
 struct RqInterWorkMem_;
 
 typedef struct RqInterWorkMem_ RqInterWorkMem;
@@ -32,6 +52,13 @@ int RqInterInit(int nK,
 		RqInterWorkMem* pInterWorkMem,
 		size_t nInterWorkMemSize);
 
+RQAPI
+int RqInterInitEx(int nK,
+		  int nMaxExtra,
+		  int nFlags,
+		  RqInterWorkMem* pInterWorkMem,
+		  size_t nInterWorkMemSize);
+
 RQAPI
 int RqInterAddIds(RqInterWorkMem* pInterWorkMem,
 		  int32_t nInSymIdBeg,
@@ -46,6 +73,73 @@ int RqInterCompile(RqInterWorkMem* pInterWorkMem,
 		   RqInterProgram* pInterProgMem,
 		   size_t nInterProgMemSize);
 
+// Like RqInterCompile, but with RQ_INTER_DENSE, the LU decomposition
+// of the system is spread over up to nThreads threads (at most 256) of
+// the library's worker pool.  Only the trailing updates run in
+// parallel, the panel factorizations do not, so the speedup stays
+// below nThreads; it has not been measured on multi-core machines
+// yet.  The inactivation backend always runs on the calling thread:
+// its dense part is only a few hundred columns wide, which takes a
+// fraction of a millisecond.  The resulting program does not depend
+// on nThreads.
+RQAPI
+int RqInterCompileEx(RqInterWorkMem* pInterWorkMem,
+		     RqInterProgram* pInterProgMem,
+		     size_t nInterProgMemSize,
+		     int nThreads);
+
+// After RqInterCompile failed with RQ_ERR_INSUFF_IDS, add more ESIs
+// with RqInterAddIds and call this to continue the compilation:  The
+// rows of the new ESIs are eliminated against the partial
+// factorization kept in the work memory, rather than starting over.
+// The resulting program computes the same as the one RqInterCompile
+// compiles for all the ESIs.  Without a
+// failed compilation to continue, and with RQ_INTER_DENSE, this is
+// RqInterCompile.
+RQAPI
+int RqInterCompileResume(RqInterWorkMem* pInterWorkMem,
+			 RqInterProgram* pInterProgMem,
+			 size_t nInterProgMemSize);
+
+// Number of additional linearly independent symbols the last
+// compilation needed, 0 if it succeeded.  If fewer than K' ESIs were
+// given, this is a lower bound.
+RQAPI
+int RqInterGetRankDeficit(const RqInterWorkMem* pcInterWorkMem,
+			  int* pnNeeded);
+
+// After a compilation failed with RQ_ERR_ENOMEM, the program memory
+// size it needed, or 0 if it failed before finding out.  ESI sets that
+// leave many more columns inactive than random ones, such as repair
+// symbols of high LT degree only, can need more than what
+// RqInterGetMemSizes reports; compile again with this size.
+RQAPI
+int RqInterGetProgMemNeeded(const RqInterWorkMem* pcInterWorkMem,
+			    size_t* pnNeeded);
+
+// Partial decoding
+//
+// When most source symbols were received, only the missing ones need
+// to be recovered.  RqInterCompilePartial compiles a program that
+// only computes the intermediate symbols the missing source symbols
+// are made of; the other intermediate symbols are left undefined by
+// RqInterExecute.  The missing source symbols are then generated with
+// an RqOutProgram for the ESIs from RqInterGetMissingIds.  If all the
+// source symbols were received, the program is empty, and nothing is
+// solved.
+RQAPI
+int RqInterCompilePartial(RqInterWorkMem* pInterWorkMem,
+			  RqInterProgram* pInterProgMem,
+			  size_t nInterProgMemSize);
+
+// The source ESIs missing from the ESIs added so far, in increasing
+// order.  pMissingIds needs room for K ESIs, or can be NULL to only
+// get their number.
+RQAPI
+int RqInterGetMissingIds(const RqInterWorkMem* pcInterWorkMem,
+			 uint32_t* pMissingIds,
+			 int* pnMissing);
+
 RQAPI
 int RqInterExecute(const RqInterProgram* pcInterProgMem,
 		   size_t nSymSize,
@@ -54,6 +148,184 @@ int RqInterExecute(const RqInterProgram* pcInterProgMem,
 		   void* pInterSymMem,
 		   size_t nInterSymMemSize);
 
+// Like RqInterExecute, but the symbols are processed in strips of
+// nStripSize bytes, the whole program being run on one strip after
+// the other.  This keeps the working set in cache for large symbols.
+// With nStripSize 0, the strip size is chosen automatically, such that
+// the rows the program keeps coming back to fit into the L2 cache;
+// this is what RqInterExecute does.  With nStripSize
+// >= nSymSize, the symbols are processed in one piece.
+//
+// With nThreads > 1, the symbols are split into up to nThreads byte
+// ranges, which are processed in parallel by the worker threads of
+// the library.  The workers are created on first use and persist.
+RQAPI
+int RqInterExecuteEx(const RqInterProgram* pcInterProgMem,
+		     size_t nSymSize,
+		     const void* pcInSymMem,
+		     size_t nInSymMemSize,
+		     void* pInterSymMem,
+		     size_t nInterSymMemSize,
+		     size_t nStripSize,
+		     int nThreads);
+
+// Number of row operations of a compiled program:  as compiled, and as
+// dispatched by RqInterExecute after the schedule optimization, which
+// fuses accumulations into the same row.
+RQAPI
+int RqInterGetOpCounts(const RqInterProgram* pcInterProgMem,
+		       size_t* pnOpsCompiled,
+		       size_t* pnOpsOptimized);
+
+// Stored programs
+//
+// A compiled program contains no pointers, so it can be copied,
+// written to a file, or shared between processes.  It takes
+// RqInterGetProgramSize bytes, which can be less than the memory it
+// was compiled into.  Stored programs carry a version, and only
+// programs of the version of the library are accepted.
+RQAPI
+size_t RqInterGetProgramSize(const RqInterProgram* pcInterProgMem);
+
+// Check a program stored in memory, and return it in *ppInterProgMem
+// without copying it.  The memory must be 8 byte aligned; memory
+// from malloc or mmap is.  Fails with RQ_ERR_EFORMAT if the memory
+// does not contain a valid program.
+RQAPI
+int RqInterProgramFromMem(const void* pcMem,
+			  size_t nMemSize,
+			  const RqInterProgram** ppInterProgMem);
+
+// Write a program to a file.
+RQAPI
+int RqInterSaveProgram(const RqInterProgram* pcInterProgMem,
+		       const char* sPath);
+
+// Map a program file read-only into memory, check it, and return the
+// program in *ppInterProgMem.  The program can be used right away,
+// and must be unmapped with RqInterUnmapProgram.
+RQAPI
+int RqInterMapProgram(const char* sPath,
+		      const RqInterProgram** ppInterProgMem);
+
+RQAPI
+int RqInterUnmapProgram(const RqInterProgram* pcInterProgMem);
+
+// Bundles of systematic programs
+//
+// A bundle file holds the programs for systematic encoding, i.e., for
+// the ESIs 0, ..., K-1, of a range of K values, in compressed form.
+// Loading a program from a mapped bundle takes a fraction of the time
+// compiling it does.  Only one program per K' is stored; the program
+// for K is derived from the one for the K' of K by treating the
+// padding symbols as zero, as RqInterCompile does.
+struct RqBundle_;
+typedef struct RqBundle_ RqBundle;
+
+// Compile the systematic programs for all K from nKmin to nKmax, and
+// write them to a bundle file.  nThreads is passed to
+// RqInterCompileEx.  Use 1 and RQ_MAX_K for the bundle of all
+// programs.
+RQAPI
+int RqBundleWrite(const char* sPath, int nKmin, int nKmax, int nThreads);
+
+// Map a bundle file read-only into memory, and check its index.  The
+// bundle must be unmapped with RqBundleUnmap.
+RQAPI
+int RqBundleMap(const char* sPath, const RqBundle** ppBundle);
+
+RQAPI
+int RqBundleUnmap(const RqBundle* pcBundle);
+
+// Memory needed for the program of nK.  Fails with RQ_ERR_EDOM if the
+// bundle does not contain it.
+RQAPI
+int RqBundleGetProgramSize(const RqBundle* pcBundle,
+			   int nK,
+			   size_t* pnProgMemSize);
+
+// Decompress the program of nK into pInterProgMem.  The result is a
+// program as from RqInterCompile for the ESIs 0, ..., nK-1, and fails
+// with RQ_ERR_EFORMAT if the bundle is corrupt.
+RQAPI
+int RqBundleLoadProgram(const RqBundle* pcBundle,
+			int nK,
+			RqInterProgram* pInterProgMem,
+			size_t nInterProgMemSize);
+
+// Program cache
+//
+// RqInterCompileCached looks up the program for the K, flags and ESI
+// list of pInterWorkMem in a cache shared by all threads, or compiles
+// and caches it.  The lookup does not take any locks.  The program
+// is read-only, and must be released with RqInterReleaseCached when
+// no longer used; it remains valid until then even if evicted.
+//
+// The cache evicts the least recently used programs to stay within
+// its memory budget, which is 0 (nothing is cached) until set with
+// RqCacheSetBudget.
+RQAPI
+int RqInterCompileCached(RqInterWorkMem* pInterWorkMem,
+			 const RqInterProgram** ppInterProgMem);
+
+RQAPI
+void RqInterReleaseCached(const RqInterProgram* pcInterProgMem);
+
+RQAPI
+int RqCacheSetBudget(size_t nBytes);
+
+// Number of cache hits and misses of RqInterCompileCached so far, and
+// the memory currently used by the cache.
+RQAPI
+int RqCacheGetStats(size_t* pnHits, size_t* pnMisses, size_t* pnBytes);
+
+// Streaming decoder
+//
+// An alternative to compiling and executing a program at a receiver:
+// RqStreamAddSymbol eliminates each received symbol against the ones
+// received before right away, so that the work is done while the
+// symbols arrive, and the intermediate block is available as soon as
+// enough symbols have been received.  Symbols that turn out to be
+// linearly dependent on the earlier ones are dropped.
+//
+// The elimination is dense:  The decoder takes about L * (L + nSymSize)
+// bytes, and every symbol costs up to O(L (L + nSymSize)) operations,
+// so it suits moderate K only.  RqStreamGetMemSize and RqStreamInit
+// fail with RQ_ERR_EDOM for nK above RQ_STREAM_MAX_K; compile a
+// program with RqInterCompile for those instead.
+struct RqStreamDec_;
+typedef struct RqStreamDec_ RqStreamDec;
+
+RQAPI
+int RqStreamGetMemSize(int nK, size_t nSymSize, size_t* pStreamDecMemSize);
+
+RQAPI
+int RqStreamInit(int nK,
+		 size_t nSymSize,
+		 RqStreamDec* pStreamDec,
+		 size_t nStreamDecMemSize);
+
+// Add the received symbol with ESI nESI, of nSymSize bytes.  Symbols
+// received after the rank reached L are ignored.
+RQAPI
+int RqStreamAddSymbol(RqStreamDec* pStreamDec,
+		      uint32_t nESI,
+		      const void* pcSym);
+
+// Rank of the system so far, and the rank needed to decode, L.
+RQAPI
+int RqStreamGetRank(const RqStreamDec* pStreamDec,
+		    int* pnRank,
+		    int* pnRankNeeded);
+
+// Copy the intermediate block out; the L intermediate symbols can be
+// used with RqOutExecute like those from RqInterExecute.  Fails with
+// RQ_ERR_INSUFF_IDS while the rank is below L.
+RQAPI
+int RqStreamGetInter(const RqStreamDec* pStreamDec,
+		     void* pInterSymMem,
+		     size_t nInterSymMemSize);
+
 // Output Symbol API functions
 struct RqOutWorkMem_;
 typedef struct RqOutWorkMem_ RqOutWorkMem;
@@ -76,6 +348,9 @@ int RqOutAddIds(	RqOutWorkMem* pOutWorkMem,
 struct RqOutProgram_;
 typedef struct RqOutProgram_ RqOutProgram;
 
+// The program lists the intermediate symbols making up each output
+// symbol, so that executing it does not generate any tuples.  It can
+// be executed on any number of intermediate blocks of the same K.
 RQAPI
 int RqOutCompile(       RqOutWorkMem* pOutWorkMem,
 			RqOutProgram* pOutProgMem,
@@ -88,17 +363,41 @@ int RqOutExecute(	const RqOutProgram* pcOutProgMem,
 			void* pOutSymMem,
 			size_t nOutSymMemSize);
 
+// Like RqOutExecute, but using up to nThreads threads, in the same way
+// as RqInterExecuteEx.
+RQAPI
+int RqOutExecuteEx(	const RqOutProgram* pcOutProgMem,
+			size_t nSymSize,
+			const void* pcInterSymMem,
+			void* pOutSymMem,
+			size_t nOutSymMemSize,
+			int nThreads);
+
 
 // Constants
 
 #define RQ_MAX_K			56403
 #define RQ_DEFAULT_MAX_EXTRA		30
+#define RQ_STREAM_MAX_K			8192
+
+// Flags for RqInterGetMemSizesEx and RqInterInitEx
+
+// Without flags, the RQ matrix is factored by inactivation decoding
+// (RFC 6330 Sect 5.4).
+
+// Factor the RQ matrix with a dense LU decomposition rather than by
+// inactivation decoding.  This was the default before inactivation
+// decoding was added.  It needs O(L^2) work memory and time; it is
+// mostly useful as a reference.
+#define RQ_INTER_DENSE			(1<<1)
 
 // Error Codes
 #define RQ_ERR_ENOMEM			(-1)
 #define RQ_ERR_EDOM			(-2)
 #define RQ_ERR_MAX_IDS_REACHED		(-3)
 #define RQ_ERR_INSUFF_IDS		(-4)
+#define RQ_ERR_EFORMAT			(-5)
+#define RQ_ERR_EIO			(-6)
 
 #ifdef __cplusplus
 }
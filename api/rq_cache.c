@@ -0,0 +1,338 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rq_cache.h"
+
+/* Number of hash buckets */
+#define RQ_CACHE_BUCKETS	1024
+
+/* Number of shards of the counters updated by the lookups */
+#define RQ_CACHE_SHARDS		16
+
+typedef struct entry_ {
+	struct entry_* next;	// Bucket chain; accessed atomically
+	struct entry_* lru_prev;	// LRU list, most recent first
+	struct entry_* lru_next;
+	struct entry_* evict_next;	// List of entries being evicted
+	uint64_t hash;
+	int K;
+	int flags;
+	int n_ESIs;
+	const uint32_t* ESIs;	// Stored after the blob
+	size_t size;		// Size of the whole allocation
+	uint64_t stamp;		// Generation of the last use; atomic
+	uint64_t queued;	// Generation when put at the LRU list head
+	long refs;		// Reference count; atomic
+	alignas(max_align_t) unsigned char blob[];
+} entry;
+
+#define entry_of(blob) \
+	((entry*)((unsigned char*)(blob) - offsetof(entry, blob)))
+
+static entry* buckets[RQ_CACHE_BUCKETS];
+
+/* Serializes the modifications; protects the variables below */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t budget;
+static size_t total;
+static entry* lru_head;
+static entry* lru_tail;
+
+/* The generation advances whenever entries are put at the head of the
+ * LRU list.  The lookups only store it into the entries they find, so
+ * that the entries used since are known when it comes to evicting.
+ */
+static uint64_t generation;
+
+/* Counters the lookups update, one set per shard of the threads, so
+ * that the threads don't fight over the same cache lines.
+ *
+ * The lookups announce themselves in readers[epoch & 1] of their
+ * shard.  To free an unlinked entry, the epoch is advanced, and the
+ * lookups of the previous epoch are waited for; those of the new one
+ * cannot see the entry anymore.
+ */
+typedef struct {
+	alignas(64) long readers[2];
+	size_t n_hit;
+	size_t n_miss;
+} shard;
+
+static shard shards[RQ_CACHE_SHARDS];
+static unsigned n_threads;
+static __thread shard* my_shard;
+static unsigned epoch;
+
+static shard* get_shard()
+{
+	if (my_shard == NULL) {
+		const unsigned i = __atomic_fetch_add(&n_threads, 1,
+							__ATOMIC_RELAXED);
+		my_shard = &shards[i % RQ_CACHE_SHARDS];
+	}
+	return my_shard;
+}
+
+static unsigned read_begin(shard* sh)
+{
+	for (;;) {
+		const unsigned e = __atomic_load_n(&epoch, __ATOMIC_SEQ_CST);
+		__atomic_fetch_add(&sh->readers[e & 1], 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&epoch, __ATOMIC_SEQ_CST) == e)
+			return e;
+
+		/* The epoch changed in between, and the writer might
+		 * not have seen us.
+		 */
+		__atomic_fetch_sub(&sh->readers[e & 1], 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+static void read_end(shard* sh, unsigned e)
+{
+	__atomic_fetch_sub(&sh->readers[e & 1], 1, __ATOMIC_RELEASE);
+}
+
+/* Wait until no lookup can see the entries unlinked so far.  Once a
+ * shard has been seen without readers of the old epoch, any lookup
+ * announcing itself there later sees the new epoch and backs off.
+ */
+static void wait_readers()
+{
+	const unsigned e = __atomic_fetch_add(&epoch, 1, __ATOMIC_SEQ_CST);
+	for (int i = 0; i < RQ_CACHE_SHARDS; ++i) {
+		while (__atomic_load_n(&shards[i].readers[e & 1],
+						__ATOMIC_ACQUIRE) != 0)
+			sched_yield();
+	}
+}
+
+static uint64_t hash_key(const rq_cache_key* key)
+{
+	/* FNV-1a, on 32 bit words rather than bytes */
+	uint64_t h = 14695981039346656037ULL;
+#define HASH_WORD(w)	(h = (h ^ (uint32_t)(w)) * 1099511628211ULL)
+	HASH_WORD(key->K);
+	HASH_WORD(key->flags);
+	HASH_WORD(key->n_ESIs);
+	for (int i = 0; i < key->n_ESIs; ++i)
+		HASH_WORD(key->ESIs[i]);
+#undef HASH_WORD
+	return h ^ (h >> 32);
+}
+
+static int matches(const entry* e, const rq_cache_key* key, uint64_t h)
+{
+	return e->hash == h
+		&& e->K == key->K
+		&& e->flags == key->flags
+		&& e->n_ESIs == key->n_ESIs
+		&& memcmp(e->ESIs, key->ESIs,
+				key->n_ESIs * sizeof(uint32_t)) == 0;
+}
+
+static entry** bucket_of(uint64_t h)
+{
+	return &buckets[h % RQ_CACHE_BUCKETS];
+}
+
+/* Mark e as used; only stores when the entry has not been marked in
+ * this generation yet.
+ */
+static void touch(entry* e)
+{
+	const uint64_t g = __atomic_load_n(&generation, __ATOMIC_RELAXED);
+	if (__atomic_load_n(&e->stamp, __ATOMIC_RELAXED) != g)
+		__atomic_store_n(&e->stamp, g, __ATOMIC_RELAXED);
+}
+
+static void unref(entry* e)
+{
+	if (__atomic_fetch_sub(&e->refs, 1, __ATOMIC_ACQ_REL) == 1)
+		free(e);
+}
+
+/* LRU list operations; called with the lock held */
+static void lru_unlink(entry* e)
+{
+	*(e->lru_prev != NULL ? &e->lru_prev->lru_next : &lru_head)
+		= e->lru_next;
+	*(e->lru_next != NULL ? &e->lru_next->lru_prev : &lru_tail)
+		= e->lru_prev;
+}
+
+static void lru_push_front(entry* e)
+{
+	e->queued = generation;
+	e->lru_prev = NULL;
+	e->lru_next = lru_head;
+	*(lru_head != NULL ? &lru_head->lru_prev : &lru_tail) = e;
+	lru_head = e;
+}
+
+/* Start a new generation, after entries were put at the list head */
+static void next_generation()
+{
+	__atomic_store_n(&generation, generation + 1, __ATOMIC_RELAXED);
+}
+
+/* Evict the least recently used entries other than keep until the
+ * budget is met.  Called with the lock held.
+ *
+ * The entries are taken from the tail of the LRU list.  Those used
+ * since they were put at the head get put there again instead; each
+ * entry is passed over at most once more than it was used.
+ */
+static void evict(const entry* keep)
+{
+	entry* evicted = NULL;
+	int requeued = 0;
+	while (total > budget && lru_tail != NULL) {
+		entry* e = lru_tail;
+		if (e == keep && e == lru_head)
+			break;
+		lru_unlink(e);
+		if (e == keep) {
+			lru_push_front(e);
+			continue;
+		}
+		if (__atomic_load_n(&e->stamp, __ATOMIC_RELAXED)
+							> e->queued) {
+			lru_push_front(e);
+			requeued = 1;
+			continue;
+		}
+
+		/* Unlink it; lookups at the entry can still go on */
+		entry** pp = bucket_of(e->hash);
+		while (*pp != e)
+			pp = &(*pp)->next;
+		__atomic_store_n(pp, e->next, __ATOMIC_RELEASE);
+		total -= e->size;
+		e->evict_next = evicted;
+		evicted = e;
+	}
+	if (requeued)
+		next_generation();
+	if (evicted == NULL)
+		return;
+
+	wait_readers();
+	while (evicted != NULL) {
+		entry* e = evicted;
+		evicted = e->evict_next;
+		unref(e);
+	}
+}
+
+const void* rq_cache_get(const rq_cache_key* key)
+{
+	const uint64_t h = hash_key(key);
+	shard* sh = get_shard();
+	const unsigned e = read_begin(sh);
+	entry* p = __atomic_load_n(bucket_of(h), __ATOMIC_ACQUIRE);
+	while (p != NULL && !matches(p, key, h))
+		p = __atomic_load_n(&p->next, __ATOMIC_ACQUIRE);
+	if (p != NULL) {
+		/* The cache's reference is only dropped after all the
+		 * lookups seeing the entry are done.
+		 */
+		__atomic_fetch_add(&p->refs, 1, __ATOMIC_RELAXED);
+		touch(p);
+	}
+	read_end(sh, e);
+
+	__atomic_fetch_add(p != NULL ? &sh->n_hit : &sh->n_miss, 1,
+						__ATOMIC_RELAXED);
+	return (p != NULL) ? p->blob : NULL;
+}
+
+const void* rq_cache_put(const rq_cache_key* key, const void* blob,
+				size_t size)
+{
+	/* The entry with the blob, followed by the ESIs */
+	const size_t offs = offsetof(entry, blob)
+		+ ((size + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1));
+	const size_t alloc = offs + key->n_ESIs * sizeof(uint32_t);
+	entry* e = malloc(alloc);
+	if (e == NULL)
+		return NULL;
+	uint32_t* ESIs = (uint32_t*)((unsigned char*)e + offs);
+	memcpy(ESIs, key->ESIs, key->n_ESIs * sizeof(uint32_t));
+	memcpy(e->blob, blob, size);
+	e->next = NULL;
+	e->hash = hash_key(key);
+	e->K = key->K;
+	e->flags = key->flags;
+	e->n_ESIs = key->n_ESIs;
+	e->ESIs = ESIs;
+	e->size = alloc;
+	e->refs = 1;
+
+	pthread_mutex_lock(&lock);
+	if (alloc > budget) {
+		/* Too large, hand out the copy without caching */
+		pthread_mutex_unlock(&lock);
+		return e->blob;
+	}
+
+	/* Someone might have been faster */
+	entry** head = bucket_of(e->hash);
+	for (entry* p = *head; p != NULL; p = p->next) {
+		if (matches(p, key, e->hash)) {
+			__atomic_fetch_add(&p->refs, 1, __ATOMIC_RELAXED);
+			touch(p);
+			pthread_mutex_unlock(&lock);
+			free(e);
+			return p->blob;
+		}
+	}
+
+	/* Publish, with a reference held by the cache */
+	e->refs = 2;
+	e->stamp = generation;
+	e->next = *head;
+	__atomic_store_n(head, e, __ATOMIC_RELEASE);
+	lru_push_front(e);
+	next_generation();
+	total += alloc;
+	evict(e);
+	pthread_mutex_unlock(&lock);
+	return e->blob;
+}
+
+void rq_cache_release(const void* blob)
+{
+	unref(entry_of(blob));
+}
+
+void rq_cache_set_budget(size_t n_bytes)
+{
+	pthread_mutex_lock(&lock);
+	budget = n_bytes;
+	evict(NULL);
+	pthread_mutex_unlock(&lock);
+}
+
+void rq_cache_stats(size_t* n_hits, size_t* n_misses, size_t* n_bytes)
+{
+	size_t hits = 0, misses = 0;
+	for (int i = 0; i < RQ_CACHE_SHARDS; ++i) {
+		hits += __atomic_load_n(&shards[i].n_hit, __ATOMIC_RELAXED);
+		misses += __atomic_load_n(&shards[i].n_miss,
+							__ATOMIC_RELAXED);
+	}
+	if (n_hits != NULL)
+		*n_hits = hits;
+	if (n_misses != NULL)
+		*n_misses = misses;
+	if (n_bytes != NULL) {
+		pthread_mutex_lock(&lock);
+		*n_bytes = total;
+		pthread_mutex_unlock(&lock);
+	}
+}
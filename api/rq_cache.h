@@ -0,0 +1,66 @@
+#ifndef RQ_CACHE_H
+#define RQ_CACHE_H
+
+/**	@file rq_cache.h
+ *
+ *	Cache of compiled programs.
+ *
+ *	The cache maps a key, consisting of K, the compilation flags and
+ *	the ESI list, to an opaque blob (the program).  Lookups are lock
+ *	free; insertions and evictions are serialized by a mutex, and an
+ *	evicted entry is only freed once no lookup can still be looking
+ *	at it, and once the last reference to it has been released.
+ *
+ *	The blobs handed out are reference counted:  Every blob returned
+ *	by rq_cache_get or rq_cache_put must be released with
+ *	rq_cache_release.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+	int K;
+	int flags;
+	int n_ESIs;
+	const uint32_t* ESIs;
+} rq_cache_key;
+
+/**	Look up a blob.
+ *
+ *	@return	The blob, or NULL if it is not in the cache.
+ */
+const void* rq_cache_get(const rq_cache_key* key);
+
+/**	Insert a copy of a blob.
+ *
+ *	If the blob does not fit into the memory budget, it is not
+ *	inserted, but a copy is still returned.  If a blob with the same
+ *	key has been inserted in the meantime, that one is returned
+ *	instead.
+ *
+ *	@return	The blob in the cache, or NULL if out of memory.
+ */
+const void* rq_cache_put(const rq_cache_key* key, const void* blob,
+				size_t size);
+
+/**	Release a blob obtained from rq_cache_get or rq_cache_put. */
+void rq_cache_release(const void* blob);
+
+/**	Set the memory budget.
+ *
+ *	The least recently used entries are evicted until the entries
+ *	in the cache take at most n_bytes in total.  The order is that of
+ *	the insertions, except that entries used since they were last
+ *	passed over get another round (the "second chance" variant of
+ *	LRU).  The budget is 0,
+ *	i.e., nothing is cached, initially.
+ */
+void rq_cache_set_budget(size_t n_bytes);
+
+/**	Get the number of hits and misses of rq_cache_get so far, and
+ *	the memory taken by the cached entries.
+ */
+void rq_cache_stats(size_t* n_hits, size_t* n_misses, size_t* n_bytes);
+
+#endif /* RQ_CACHE_H */
@@ -0,0 +1,130 @@
+#include <pthread.h>
+
+#include "rq_pool.h"
+
+/* A job posted by rq_pool_run; it lives on the caller's stack */
+typedef struct pool_job {
+	rq_pool_fn fn;
+	void* arg;
+	int n_tasks;
+	int next;		// Next task to hand out
+	int n_done;		// Tasks finished
+	pthread_cond_t done_cond;
+	struct pool_job* link;	// Next job in the queue
+} pool_job;
+
+/* Protects everything below, and the counters of the jobs */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t workers[RQ_POOL_MAX_THREADS - 1];
+static int n_workers;
+static int n_wanted;		// Workers asked for by the running jobs
+static int stopping;
+
+/* The jobs with tasks left to hand out, oldest first */
+static pool_job* queue_head;
+static pool_job* queue_tail;
+
+static void dequeue(pool_job* j)
+{
+	pool_job** pp = &queue_head;
+	pool_job* prev = NULL;
+	while (*pp != j) {
+		prev = *pp;
+		pp = &(*pp)->link;
+	}
+	*pp = j->link;
+	if (queue_tail == j)
+		queue_tail = prev;
+}
+
+/* Take the next task of job j and run it.  Must be called with the
+ * lock held, which is released while the task runs.  j must have a
+ * task left to hand out.
+ */
+static void run_one(pool_job* j)
+{
+	const int i = j->next++;
+	if (j->next == j->n_tasks)
+		dequeue(j);
+	pthread_mutex_unlock(&lock);
+	j->fn(j->arg, i);
+	pthread_mutex_lock(&lock);
+	if (++j->n_done == j->n_tasks)
+		pthread_cond_signal(&j->done_cond);
+}
+
+static void* worker_main(void* unused)
+{
+	(void)unused;
+	pthread_mutex_lock(&lock);
+	while (!stopping) {
+		if (queue_head != NULL)
+			run_one(queue_head);
+		else
+			pthread_cond_wait(&work_cond, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+void rq_pool_run(int n_tasks, rq_pool_fn fn, void* arg)
+{
+	if (n_tasks <= 1) {
+		if (n_tasks == 1)
+			fn(arg, 0);
+		return;
+	}
+
+	pool_job j = {
+		.fn = fn,
+		.arg = arg,
+		.n_tasks = n_tasks,
+		.next = 0,
+		.n_done = 0,
+		.link = NULL,
+	};
+	pthread_cond_init(&j.done_cond, NULL);
+	pthread_mutex_lock(&lock);
+
+	/* Grow the pool as needed by all the running jobs */
+	n_wanted += n_tasks - 1;
+	const int n_want = (n_wanted < RQ_POOL_MAX_THREADS - 1)
+				? n_wanted : RQ_POOL_MAX_THREADS - 1;
+	while (n_workers < n_want) {
+		if (pthread_create(&workers[n_workers], NULL,
+						worker_main, NULL) != 0)
+			break;
+		++n_workers;
+	}
+
+	/* Post the job, and help running it */
+	if (queue_tail != NULL)
+		queue_tail->link = &j;
+	else
+		queue_head = &j;
+	queue_tail = &j;
+	pthread_cond_broadcast(&work_cond);
+	while (j.next < j.n_tasks)
+		run_one(&j);
+	while (j.n_done < j.n_tasks)
+		pthread_cond_wait(&j.done_cond, &lock);
+	n_wanted -= n_tasks - 1;
+
+	pthread_mutex_unlock(&lock);
+	pthread_cond_destroy(&j.done_cond);
+}
+
+/* Stop the workers when the library is unloaded */
+__attribute__((destructor))
+static void rq_pool_stop()
+{
+	pthread_mutex_lock(&lock);
+	stopping = 1;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&lock);
+	for (int i = 0; i < n_workers; ++i)
+		pthread_join(workers[i], NULL);
+	n_workers = 0;
+}
@@ -0,0 +1,31 @@
+#ifndef RQ_POOL_H
+#define RQ_POOL_H
+
+/**	@file rq_pool.h
+ *
+ *	Worker thread pool of the API library.
+ *
+ *	The worker threads are created on first use, as many as the jobs
+ *	running at the same time ask for, and are kept around until the
+ *	library is unloaded.  Jobs of concurrent callers run side by
+ *	side:  The workers take the tasks of the oldest job with tasks
+ *	left, and each caller runs tasks of its own job.
+ */
+
+/**	Largest number of threads a job can run on. */
+#define RQ_POOL_MAX_THREADS	256
+
+typedef void (*rq_pool_fn)(void* arg, int i);
+
+/**	Run fn(arg, i) for i = 0, ..., n_tasks - 1.
+ *
+ *	The tasks are run by the calling thread and by the pool workers,
+ *	each picking up tasks until none are left.  The pool has n_tasks
+ *	- 1 workers for each of the jobs running at the same time (at
+ *	most RQ_POOL_MAX_THREADS - 1 in all).  Returns when all the tasks
+ *	are done.  If worker threads cannot be created, the tasks are run
+ *	on the threads that are available, possibly only the caller.
+ */
+void rq_pool_run(int n_tasks, rq_pool_fn fn, void* arg);
+
+#endif /* RQ_POOL_H */
@@ -1,12 +1,25 @@
 #include <assert.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lt.h"
 #include "m256v.h"
 #include "parameters.h"
 #include "rq_api.h"
+#include "rq_cache.h"
+#include "rq_inact.h"
 #include "rq_matrix.h"
+#include "rq_ops.h"
+#include "rq_ops_pack.h"
+#include "rq_pool.h"
+#include "rq_stream.h"
 #include "tuple.h"
 
 #define errmsg(x)	fprintf(stderr, "Error:%s:%d: %s\n", \
@@ -14,18 +27,67 @@
 
 struct RqInterWorkMem_ {
 	parameters params;
+	int nFlags;
 	int nESI_max;
 	int nESI;
+	int bResumable;		// Scratch holds a failed compilation
+	int nDeficit;		// Rank deficit of the last compilation
+	size_t nProgMemNeeded;	// Program memory the last compilation needed
 	uint32_t ESIs[];
 };
 
+/* The program is a schedule of row operations, see rq_ops.h.
+ *
+ * It contains no pointers, and only fixed size fields, so that it can
+ * be copied, stored, and used from memory mapped files.  The magic
+ * number also tells the byte order; the version needs to be bumped on
+ * any change of the layout or of the meaning of the operations.
+ */
+#define RQ_PROG_MAGIC		0x51527654	// "TvRQ"
+#define RQ_PROG_VERSION		1
+
 struct RqInterProgram_ {
-	m256v LU;
-	uint8_t* lu_storage;
-	int nESI;
-	int rowperm[];
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nESI;
+	uint32_t nCols;
+	uint64_t nOpsCompiled;	// Schedule length before optimization
+	uint64_t nUnits;	// Units dispatched by the executor
+	uint64_t nOps;
+	rq_op ops[];
 };
 
+_Static_assert(sizeof(RqInterProgram) == 40 && sizeof(rq_op) == 8,
+		"RqInterProgram layout changed; bump RQ_PROG_VERSION.");
+
+/* The scratch memory for the compilation follows the ESI array in the
+ * work memory.
+ */
+static size_t inter_scratch_offs(int nESI_max)
+{
+	const size_t offs = sizeof(RqInterWorkMem) + nESI_max * sizeof(uint32_t);
+	return (offs + 15) & ~(size_t)15;
+}
+
+static size_t inter_scratch_size(const parameters* P, int nESI_max, int nFlags)
+{
+	if (nFlags & RQ_INTER_DENSE) {
+		/* Matrix, row and column permutations */
+		int n_rows, n_cols;
+		rq_matrix_get_dim(P, nESI_max, &n_rows, &n_cols);
+		return (size_t)n_rows * n_cols
+			+ sizeof(int) * (n_rows + n_cols);
+	}
+	return rq_inact_scratch_size(P, nESI_max);
+}
+
+static size_t inter_ops_max(const parameters* P, int nESI_max, int nFlags)
+{
+	if (nFlags & RQ_INTER_DENSE)
+		return rq_ops_from_lu_max(P->L);
+	return rq_inact_ops_max(P, nESI_max);
+}
+
 struct RqOutWorkMem_ {
 	parameters params;
 	int nESI_max;
@@ -33,18 +95,37 @@ struct RqOutWorkMem_ {
 	uint32_t ESIs[];
 };
 
+/* The output program lists the intermediate symbols making up each
+ * output symbol:  Those of output symbol i are rows[offs[i]], ...,
+ * rows[offs[i+1]-1], where the rows array follows the offsets.
+ */
 struct RqOutProgram_ {
 	parameters params;
-	int unused; // To keep RqOutProgram_ identical to RqOutWorkMem_
 	int nESI;
-	uint32_t ESIs[];
+	uint32_t offs[];
 };
 
+static int* out_rows(const RqOutProgram* prog)
+{
+	return (int*)(prog->offs + prog->nESI + 1);
+}
+
 int RqInterGetMemSizes(int nMaxK,
 		       int nMaxExtra,
 		       size_t* pInterWorkMemSize,
 		       size_t* pInterProgMemSize,
 		       size_t* pInterSymNum)
+{
+	return RqInterGetMemSizesEx(nMaxK, nMaxExtra, 0,
+			pInterWorkMemSize, pInterProgMemSize, pInterSymNum);
+}
+
+int RqInterGetMemSizesEx(int nMaxK,
+			 int nMaxExtra,
+			 int nFlags,
+			 size_t* pInterWorkMemSize,
+			 size_t* pInterProgMemSize,
+			 size_t* pInterSymNum)
 {
 	/* Compute scheduler size */
 	parameters params = parameters_get(nMaxK);
@@ -54,18 +135,15 @@ int RqInterGetMemSizes(int nMaxK,
 	}
 	const int maxISIcount = nMaxExtra + params.Kprime;
 	if (pInterWorkMemSize != NULL) {
-		*pInterWorkMemSize = sizeof(RqInterWorkMem)
-					+ maxISIcount * sizeof(uint32_t);
+		*pInterWorkMemSize = inter_scratch_offs(maxISIcount)
+			+ inter_scratch_size(&params, maxISIcount, nFlags);
 	}
 
 	/* Compute the program size */
-	int n_rows = maxISIcount + params.S + params.H;
-	int n_cols = params.L;
 	if (pInterProgMemSize != NULL) {
-		*pInterProgMemSize =
-		  sizeof(RqInterProgram)
-		  + sizeof(int) * n_rows
-		  + n_rows * n_cols;
+		*pInterProgMemSize = sizeof(RqInterProgram)
+			+ sizeof(rq_op)
+			  * inter_ops_max(&params, maxISIcount, nFlags);
 	}
 
 	/* Intermediate Block Size */
@@ -80,6 +158,16 @@ int RqInterInit(int nK,
 		   int nMaxExtra,
 		   RqInterWorkMem* pInterWorkMem,
 		   size_t nInterWorkMemSize)
+{
+	return RqInterInitEx(nK, nMaxExtra, 0,
+			pInterWorkMem, nInterWorkMemSize);
+}
+
+int RqInterInitEx(int nK,
+		  int nMaxExtra,
+		  int nFlags,
+		  RqInterWorkMem* pInterWorkMem,
+		  size_t nInterWorkMemSize)
 {
 	if (nInterWorkMemSize < sizeof(RqInterWorkMem)) {
 		errmsg("Insufficient inter work memory size.");
@@ -91,14 +179,24 @@ int RqInterInit(int nK,
 		return RQ_ERR_EDOM;
 	}
 	assert(pInterWorkMem->params.K == nK);
-	pInterWorkMem->nESI_max
-	  = (nInterWorkMemSize - sizeof(RqInterWorkMem)) / sizeof(uint32_t);
-	if (pInterWorkMem->nESI_max < nK + nMaxExtra) {
+	pInterWorkMem->nFlags = nFlags;
+
+	/* The ESI array is followed by the scratch memory, which is
+	 * sized for the number of ESIs.
+	 */
+	pInterWorkMem->nESI_max = pInterWorkMem->params.Kprime + nMaxExtra;
+	const size_t need = inter_scratch_offs(pInterWorkMem->nESI_max)
+		+ inter_scratch_size(&pInterWorkMem->params,
+				pInterWorkMem->nESI_max, nFlags);
+	if (nInterWorkMemSize < need) {
 		errmsg("Insufficient inter work memory size.");
 		return RQ_ERR_ENOMEM;
 	}
 
 	pInterWorkMem->nESI = 0;
+	pInterWorkMem->bResumable = 0;
+	pInterWorkMem->nDeficit = 0;
+	pInterWorkMem->nProgMemNeeded = 0;
 	return 0;
 }
 
@@ -121,42 +219,25 @@ int RqInterAddIds(RqInterWorkMem* pInterWorkMem,
 	return ret;
 }
 
-int RqInterCompile(RqInterWorkMem* pInterWorkMem,
-		   RqInterProgram* pInterProgMem,
-		   size_t nInterProgMemSize)
+/* Compile with a dense LU decomposition of the RQ matrix */
+static int compile_dense(RqInterWorkMem* pInterWorkMem,
+			 void* scratch,
+			 rq_ops_buf* b,
+			 int nThreads)
 {
-	const int n_cols = pInterWorkMem->params.L;
-	const int n_rows = pInterWorkMem->nESI	// added LT symbols
-		+ pInterWorkMem->params.Kprime - pInterWorkMem->params.K // padding
-		+ pInterWorkMem->params.S		// LDPC symbols
-		+ pInterWorkMem->params.H;		// HDPC symbols
-
-	/* Mem check */
-	const size_t mem_needed = sizeof(RqInterProgram)
-					+ sizeof(int) * n_rows
-					+ sizeof(uint8_t) * n_rows * n_cols;
-	if (nInterProgMemSize < mem_needed) {
-		errmsg("Not enough memory for Program.");
-		return RQ_ERR_ENOMEM;
-	}
+	const parameters* P = &pInterWorkMem->params;
+	int n_rows, n_cols;
+	rq_matrix_get_dim(P, pInterWorkMem->nESI, &n_rows, &n_cols);
 
-	/* Set up fields in the program */
-	pInterProgMem->lu_storage = (uint8_t*)((char*)pInterProgMem
-						+ sizeof(RqInterProgram)
-						+ sizeof(int) * n_rows);
-	pInterProgMem->nESI = pInterWorkMem->nESI;
-	pInterProgMem->LU = m256v_make(n_rows, n_cols, pInterProgMem->lu_storage);
+	int* rowperm = scratch;
+	int* colperm = rowperm + n_rows;
+	m256v LU = m256v_make(n_rows, n_cols, (uint8_t*)(colperm + n_cols));
 
 	/* Create the RQ matrix & LU decompose*/
-	rq_matrix_generate(&pInterProgMem->LU,
-			&pInterWorkMem->params,
-			pInterWorkMem->nESI,
-			pInterWorkMem->ESIs);
-	int colperm[n_cols];
-	const int rank = m256v_LU_decomp_inplace(
-				&pInterProgMem->LU,
-				pInterProgMem->rowperm,
-				colperm);
+	rq_matrix_generate(&LU, P, pInterWorkMem->nESI, pInterWorkMem->ESIs);
+	const int rank = m256v_LU_decomp_inplace_mt(&LU, rowperm, colperm,
+							nThreads, rq_pool_run);
+	pInterWorkMem->nDeficit = n_cols - rank;
 	if (rank < n_cols) {
 		return RQ_ERR_INSUFF_IDS;
 	}
@@ -172,19 +253,858 @@ int RqInterCompile(RqInterWorkMem* pInterWorkMem,
 		assert(colperm[i] == i);
 	}
 
-	/* Remove unused rows from LU matrix */
-	pInterProgMem->LU.n_row = rank;
-	assert(pInterProgMem->LU.n_row == pInterProgMem->LU.n_col);
+	rq_ops_from_lu(b, &LU, rowperm, pInterWorkMem->nESI);
+	return 0;
+}
 
+int RqInterCompile(RqInterWorkMem* pInterWorkMem,
+		   RqInterProgram* pInterProgMem,
+		   size_t nInterProgMemSize)
+{
+	return RqInterCompileEx(pInterWorkMem, pInterProgMem,
+				nInterProgMemSize, 1);
+}
+
+/* Compile, or with bResume, continue the failed compilation in the
+ * scratch memory.  With pLive, only the operations computing the
+ * intermediate symbols flagged in it are kept.
+ */
+static int compile(RqInterWorkMem* pInterWorkMem,
+		   RqInterProgram* pInterProgMem,
+		   size_t nInterProgMemSize,
+		   int nThreads,
+		   int bResume,
+		   uint8_t* pLive)
+{
+	pInterWorkMem->nProgMemNeeded = 0;
+	if (nInterProgMemSize < sizeof(RqInterProgram)) {
+		errmsg("Not enough memory for Program.");
+		return RQ_ERR_ENOMEM;
+	}
+	rq_ops_buf b = {
+		.ops = pInterProgMem->ops,
+		.n = 0,
+		.n_max = (nInterProgMemSize - sizeof(RqInterProgram))
+				/ sizeof(rq_op),
+	};
+
+	/* Compile */
+	const int nFlags = pInterWorkMem->nFlags;
+	void* scratch = (char*)pInterWorkMem
+			+ inter_scratch_offs(pInterWorkMem->nESI_max);
+	if (pLive != NULL
+	  && memchr(pLive, 1, pInterWorkMem->params.L) == NULL) {
+		/* Nothing to compute */
+	} else if (nFlags & RQ_INTER_DENSE) {
+		const int err = compile_dense(pInterWorkMem, scratch, &b,
+						nThreads);
+		if (err != 0)
+			return err;
+	} else {
+		const int err = (bResume && pInterWorkMem->bResumable
+				? rq_inact_resume : rq_inact_compile)(&b,
+			&pInterWorkMem->params,
+			pInterWorkMem->nESI,
+			pInterWorkMem->ESIs,
+			pInterWorkMem->nESI_max,
+			scratch,
+			inter_scratch_size(&pInterWorkMem->params,
+				pInterWorkMem->nESI_max, nFlags));
+		pInterWorkMem->bResumable = (err == RQ_INACT_SINGULAR);
+		pInterWorkMem->nDeficit = (err == RQ_INACT_SINGULAR
+					? rq_inact_deficit(scratch) : 0);
+		if (err == RQ_INACT_SINGULAR) {
+			return RQ_ERR_INSUFF_IDS;
+		} else if (err == RQ_INACT_NOMEM) {
+			errmsg("Insufficient inter work memory size.");
+			return RQ_ERR_ENOMEM;
+		}
+	}
+	pInterWorkMem->nProgMemNeeded = sizeof(RqInterProgram)
+					+ b.n * sizeof(rq_op);
+	if (rq_ops_overflow(&b)) {
+		errmsg("Not enough memory for Program.");
+		return RQ_ERR_ENOMEM;
+	}
+	if (pLive != NULL)
+		rq_ops_prune(&b, pLive);
+
+	pInterProgMem->magic = RQ_PROG_MAGIC;
+	pInterProgMem->version = RQ_PROG_VERSION;
+	pInterProgMem->nESI = pInterWorkMem->nESI;
+	pInterProgMem->nCols = pInterWorkMem->params.L;
+	pInterProgMem->nOpsCompiled = b.n;
+	pInterProgMem->nUnits = rq_ops_optimize(&b, pInterProgMem->nCols);
+	pInterProgMem->nOps = b.n;
 	return 0;
 }
 
+int RqInterCompileEx(RqInterWorkMem* pInterWorkMem,
+		     RqInterProgram* pInterProgMem,
+		     size_t nInterProgMemSize,
+		     int nThreads)
+{
+	return compile(pInterWorkMem, pInterProgMem, nInterProgMemSize,
+			nThreads, 0, NULL);
+}
+
+int RqInterCompileResume(RqInterWorkMem* pInterWorkMem,
+			 RqInterProgram* pInterProgMem,
+			 size_t nInterProgMemSize)
+{
+	return compile(pInterWorkMem, pInterProgMem, nInterProgMemSize,
+			1, 1, NULL);
+}
+
+/* Flag the source ESIs not in the ESI list in received, and return
+ * their number.
+ */
+static int find_missing(const RqInterWorkMem* pcInterWorkMem,
+			uint8_t* received)
+{
+	const int K = pcInterWorkMem->params.K;
+	memset(received, 0, K);
+	for (int i = 0; i < pcInterWorkMem->nESI; ++i) {
+		if (pcInterWorkMem->ESIs[i] < (uint32_t)K)
+			received[pcInterWorkMem->ESIs[i]] = 1;
+	}
+	int nMissing = 0;
+	for (int i = 0; i < K; ++i)
+		nMissing += !received[i];
+	return nMissing;
+}
+
+int RqInterCompilePartial(RqInterWorkMem* pInterWorkMem,
+			  RqInterProgram* pInterProgMem,
+			  size_t nInterProgMemSize)
+{
+	const parameters* P = &pInterWorkMem->params;
+	uint8_t received[P->K];
+	uint8_t live[P->L];
+	find_missing(pInterWorkMem, received);
+	memset(live, 0, P->L);
+	int rows[LT_MAX_ROW_WEIGHT];
+	for (int i = 0; i < P->K; ++i) {
+		if (received[i])
+			continue;
+		const int n = lt_get_row(P, i, rows);
+		for (int j = 0; j < n; ++j)
+			live[rows[j]] = 1;
+	}
+	return compile(pInterWorkMem, pInterProgMem, nInterProgMemSize,
+			1, 0, live);
+}
+
+int RqInterGetMissingIds(const RqInterWorkMem* pcInterWorkMem,
+			 uint32_t* pMissingIds,
+			 int* pnMissing)
+{
+	uint8_t received[pcInterWorkMem->params.K];
+	*pnMissing = find_missing(pcInterWorkMem, received);
+	if (pMissingIds != NULL) {
+		int n = 0;
+		for (int i = 0; i < pcInterWorkMem->params.K; ++i) {
+			if (!received[i])
+				pMissingIds[n++] = i;
+		}
+	}
+	return 0;
+}
+
+int RqInterGetRankDeficit(const RqInterWorkMem* pcInterWorkMem,
+			  int* pnNeeded)
+{
+	*pnNeeded = pcInterWorkMem->nDeficit;
+	return 0;
+}
+
+int RqInterGetProgMemNeeded(const RqInterWorkMem* pcInterWorkMem,
+			    size_t* pnNeeded)
+{
+	*pnNeeded = pcInterWorkMem->nProgMemNeeded;
+	return 0;
+}
+
+/* Buffers sized for the worst case, of which usually only a small part
+ * is used, are mapped without reserving memory for them:  Only the
+ * pages written to take up memory.
+ */
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE	0
+#endif
+
+static void* lazy_alloc(size_t size)
+{
+	void* p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (p == MAP_FAILED) ? NULL : p;
+}
+
+static void lazy_free(void* p, size_t size)
+{
+	if (p != NULL)
+		munmap(p, size);
+}
+
+int RqInterCompileCached(RqInterWorkMem* pInterWorkMem,
+			 const RqInterProgram** ppInterProgMem)
+{
+	/* Of the flags, only the choice of the backend makes a
+	 * difference for the program.
+	 */
+	const rq_cache_key key = {
+		.K = pInterWorkMem->params.K,
+		.flags = pInterWorkMem->nFlags & RQ_INTER_DENSE,
+		.n_ESIs = pInterWorkMem->nESI,
+		.ESIs = pInterWorkMem->ESIs,
+	};
+	*ppInterProgMem = rq_cache_get(&key);
+	if (*ppInterProgMem != NULL)
+		return 0;
+
+	/* Compile into a buffer of the maximum size, and cache the used
+	 * part of it.  The ESIs may need a larger one than what
+	 * RqInterGetMemSizes allows for; then compile again with that.
+	 */
+	size_t progSize = sizeof(RqInterProgram) + sizeof(rq_op)
+		* inter_ops_max(&pInterWorkMem->params,
+				pInterWorkMem->nESI_max, pInterWorkMem->nFlags);
+	RqInterProgram* prog = lazy_alloc(progSize);
+	if (prog == NULL) {
+		errmsg("Out of memory.");
+		return RQ_ERR_ENOMEM;
+	}
+	int err = RqInterCompile(pInterWorkMem, prog, progSize);
+	if (err == RQ_ERR_ENOMEM
+	  && pInterWorkMem->nProgMemNeeded > progSize) {
+		lazy_free(prog, progSize);
+		progSize = pInterWorkMem->nProgMemNeeded;
+		prog = lazy_alloc(progSize);
+		if (prog == NULL) {
+			errmsg("Out of memory.");
+			return RQ_ERR_ENOMEM;
+		}
+		err = RqInterCompile(pInterWorkMem, prog, progSize);
+	}
+	if (err == 0) {
+		*ppInterProgMem = rq_cache_put(&key, prog,
+						RqInterGetProgramSize(prog));
+	}
+	lazy_free(prog, progSize);
+	if (err != 0)
+		return err;
+	if (*ppInterProgMem == NULL) {
+		errmsg("Out of memory.");
+		return RQ_ERR_ENOMEM;
+	}
+	return 0;
+}
+
+void RqInterReleaseCached(const RqInterProgram* pcInterProgMem)
+{
+	rq_cache_release(pcInterProgMem);
+}
+
+int RqCacheSetBudget(size_t nBytes)
+{
+	rq_cache_set_budget(nBytes);
+	return 0;
+}
+
+int RqCacheGetStats(size_t* pnHits, size_t* pnMisses, size_t* pnBytes)
+{
+	rq_cache_stats(pnHits, pnMisses, pnBytes);
+	return 0;
+}
+
+size_t RqInterGetProgramSize(const RqInterProgram* pcInterProgMem)
+{
+	return sizeof(RqInterProgram) + pcInterProgMem->nOps * sizeof(rq_op);
+}
+
+int RqInterProgramFromMem(const void* pcMem,
+			  size_t nMemSize,
+			  const RqInterProgram** ppInterProgMem)
+{
+	const RqInterProgram* prog = pcMem;
+	*ppInterProgMem = NULL;
+	if (nMemSize < sizeof(RqInterProgram)
+	  || ((uintptr_t)pcMem % _Alignof(RqInterProgram)) != 0
+	  || prog->magic != RQ_PROG_MAGIC
+	  || prog->version != RQ_PROG_VERSION) {
+		errmsg("Not a program, or of another version.");
+		return RQ_ERR_EFORMAT;
+	}
+	if (prog->nOps > (nMemSize - sizeof(RqInterProgram)) / sizeof(rq_op)
+	  || prog->nCols > RQ_OPS_MAX_ROWS
+	  || prog->nESI > INT32_MAX
+	  || rq_ops_validate(prog->ops, prog->nOps,
+				prog->nESI, prog->nCols) != 0) {
+		errmsg("Program is corrupt.");
+		return RQ_ERR_EFORMAT;
+	}
+	*ppInterProgMem = prog;
+	return 0;
+}
+
+int RqInterSaveProgram(const RqInterProgram* pcInterProgMem,
+		       const char* sPath)
+{
+	FILE* f = fopen(sPath, "wb");
+	if (f == NULL) {
+		errmsg("Cannot open program file for writing.");
+		return RQ_ERR_EIO;
+	}
+	const size_t sz = RqInterGetProgramSize(pcInterProgMem);
+	const int ok = (fwrite(pcInterProgMem, 1, sz, f) == sz);
+	if (fclose(f) != 0 || !ok) {
+		errmsg("Cannot write program file.");
+		return RQ_ERR_EIO;
+	}
+	return 0;
+}
+
+int RqInterMapProgram(const char* sPath,
+		      const RqInterProgram** ppInterProgMem)
+{
+	*ppInterProgMem = NULL;
+	const int fd = open(sPath, O_RDONLY);
+	if (fd < 0) {
+		errmsg("Cannot open program file.");
+		return RQ_ERR_EIO;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		errmsg("Cannot read program file.");
+		return RQ_ERR_EIO;
+	}
+	void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		errmsg("Cannot map program file.");
+		return RQ_ERR_EIO;
+	}
+
+	/* The file must hold exactly the program, so that
+	 * RqInterUnmapProgram knows the size of the mapping.
+	 */
+	const RqInterProgram* prog;
+	int err = RqInterProgramFromMem(p, st.st_size, &prog);
+	if (err == 0 && RqInterGetProgramSize(prog) != (size_t)st.st_size) {
+		errmsg("Program file has trailing data.");
+		err = RQ_ERR_EFORMAT;
+	}
+	if (err != 0) {
+		munmap(p, st.st_size);
+		return err;
+	}
+	*ppInterProgMem = prog;
+	return 0;
+}
+
+int RqInterUnmapProgram(const RqInterProgram* pcInterProgMem)
+{
+	if (munmap((void*)pcInterProgMem,
+			RqInterGetProgramSize(pcInterProgMem)) != 0) {
+		errmsg("Cannot unmap program.");
+		return RQ_ERR_EIO;
+	}
+	return 0;
+}
+
+/* Bundles of systematic programs
+ *
+ * A bundle file consists of a header, an index with one entry per K'
+ * value, sorted by K', and the operations of the programs packed with
+ * rq_ops_pack.  The index holds the program headers, so that only
+ * the operations need to be unpacked.  Like programs, bundles are
+ * stored in the byte order of the machine.
+ */
+#define RQ_BUNDLE_MAGIC		0x42527654	// "TvRB"
+#define RQ_BUNDLE_VERSION	1
+
+typedef struct {
+	uint32_t nKprime;
+	uint32_t nCols;
+	uint64_t nOpsCompiled;
+	uint64_t nUnits;
+	uint64_t nOps;
+	uint64_t nOffset;	// Of the packed operations in the file
+	uint64_t nPackedSize;
+} bundle_entry;
+
+struct RqBundle_ {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t progVersion;	// RQ_PROG_VERSION of the programs
+	uint32_t nEntries;
+	uint64_t nFileSize;
+	uint64_t reserved;
+	bundle_entry entries[];
+};
+
+_Static_assert(sizeof(RqBundle) == 32 && sizeof(bundle_entry) == 48,
+		"RqBundle layout changed; bump RQ_BUNDLE_VERSION.");
+
+/* Compile the systematic program for K', pack it, and append it to
+ * the file.
+ */
+static int bundle_add(FILE* f, bundle_entry* e, int nKprime, int nThreads,
+			RqInterWorkMem* work, size_t workSize,
+			RqInterProgram* prog, size_t progSize,
+			uint8_t* packed)
+{
+	int err = RqInterInit(nKprime, 0, work, workSize);
+	if (err == 0)
+		err = RqInterAddIds(work, 0, nKprime);
+	if (err == 0)
+		err = RqInterCompileEx(work, prog, progSize, nThreads);
+	if (err != 0)
+		return err;
+
+	const size_t n = rq_ops_pack(prog->ops, prog->nOps, packed);
+	*e = (bundle_entry){
+		.nKprime = nKprime,
+		.nCols = prog->nCols,
+		.nOpsCompiled = prog->nOpsCompiled,
+		.nUnits = prog->nUnits,
+		.nOps = prog->nOps,
+		.nOffset = ftell(f),
+		.nPackedSize = n,
+	};
+	if (fwrite(packed, 1, n, f) != n) {
+		errmsg("Cannot write bundle file.");
+		return RQ_ERR_EIO;
+	}
+	return 0;
+}
+
+int RqBundleWrite(const char* sPath, int nKmin, int nKmax, int nThreads)
+{
+	const parameters Pmin = parameters_get(nKmin);
+	const parameters Pmax = parameters_get(nKmax);
+	if (Pmin.K == -1 || Pmax.K == -1 || nKmin > nKmax) {
+		errmsg("Unsupported K range.");
+		return RQ_ERR_EDOM;
+	}
+
+	/* The K' values covering the range */
+	uint32_t nEntries = 0;
+	for (int K = nKmin; K <= Pmax.Kprime; K = parameters_get(K).Kprime + 1)
+		++nEntries;
+	const size_t hdrSize = sizeof(RqBundle)
+				+ nEntries * sizeof(bundle_entry);
+
+	/* Buffers sized for the largest K' */
+	size_t workSize, progSize;
+	RqInterGetMemSizes(Pmax.Kprime, 0, &workSize, &progSize, NULL);
+	const size_t nOpsMax = (progSize - sizeof(RqInterProgram))
+				/ sizeof(rq_op);
+	RqBundle* hdr = calloc(1, hdrSize);
+	RqInterWorkMem* work = malloc(workSize);
+	RqInterProgram* prog = lazy_alloc(progSize);
+	uint8_t* packed = lazy_alloc(rq_ops_pack_bound(nOpsMax));
+	FILE* f = fopen(sPath, "wb");
+	int err = 0;
+	if (hdr == NULL || work == NULL || prog == NULL || packed == NULL) {
+		errmsg("Out of memory.");
+		err = RQ_ERR_ENOMEM;
+	} else if (f == NULL) {
+		errmsg("Cannot open bundle file for writing.");
+		err = RQ_ERR_EIO;
+	} else if (fseek(f, hdrSize, SEEK_SET) != 0) {
+		errmsg("Cannot write bundle file.");
+		err = RQ_ERR_EIO;
+	}
+
+	/* The programs, then the header and index in front of them */
+	int i = 0;
+	for (int K = nKmin; err == 0 && K <= Pmax.Kprime;
+				K = parameters_get(K).Kprime + 1) {
+		err = bundle_add(f, &hdr->entries[i++],
+				parameters_get(K).Kprime, nThreads,
+				work, workSize, prog, progSize, packed);
+	}
+	if (err == 0) {
+		hdr->magic = RQ_BUNDLE_MAGIC;
+		hdr->version = RQ_BUNDLE_VERSION;
+		hdr->progVersion = RQ_PROG_VERSION;
+		hdr->nEntries = nEntries;
+		hdr->nFileSize = ftell(f);
+		if (fseek(f, 0, SEEK_SET) != 0
+		  || fwrite(hdr, 1, hdrSize, f) != hdrSize) {
+			errmsg("Cannot write bundle file.");
+			err = RQ_ERR_EIO;
+		}
+	}
+	if (f != NULL && fclose(f) != 0 && err == 0) {
+		errmsg("Cannot write bundle file.");
+		err = RQ_ERR_EIO;
+	}
+	if (err != 0 && f != NULL)
+		remove(sPath);
+
+	free(hdr);
+	free(work);
+	lazy_free(prog, progSize);
+	lazy_free(packed, rq_ops_pack_bound(nOpsMax));
+	return err;
+}
+
+/* Check the header and the index of a bundle */
+static int bundle_check(const RqBundle* b, size_t size)
+{
+	if (size < sizeof(RqBundle)
+	  || b->magic != RQ_BUNDLE_MAGIC
+	  || b->version != RQ_BUNDLE_VERSION
+	  || b->progVersion != RQ_PROG_VERSION) {
+		errmsg("Not a bundle, or of another version.");
+		return RQ_ERR_EFORMAT;
+	}
+	const size_t hdrSize = sizeof(RqBundle)
+				+ (size_t)b->nEntries * sizeof(bundle_entry);
+	if (b->nFileSize != size || b->nEntries > size / sizeof(bundle_entry)
+	  || hdrSize > size) {
+		errmsg("Bundle is corrupt.");
+		return RQ_ERR_EFORMAT;
+	}
+	for (uint32_t i = 0; i < b->nEntries; ++i) {
+		const bundle_entry* e = &b->entries[i];
+		if ((i > 0 && e->nKprime <= b->entries[i - 1].nKprime)
+		  || e->nCols > RQ_OPS_MAX_ROWS
+		  || e->nOffset < hdrSize || e->nOffset > size
+		  || e->nPackedSize > size - e->nOffset) {
+			errmsg("Bundle is corrupt.");
+			return RQ_ERR_EFORMAT;
+		}
+	}
+	return 0;
+}
+
+int RqBundleMap(const char* sPath, const RqBundle** ppBundle)
+{
+	*ppBundle = NULL;
+	const int fd = open(sPath, O_RDONLY);
+	if (fd < 0) {
+		errmsg("Cannot open bundle file.");
+		return RQ_ERR_EIO;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		errmsg("Cannot read bundle file.");
+		return RQ_ERR_EIO;
+	}
+	void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		errmsg("Cannot map bundle file.");
+		return RQ_ERR_EIO;
+	}
+	const int err = bundle_check(p, st.st_size);
+	if (err != 0) {
+		munmap(p, st.st_size);
+		return err;
+	}
+	*ppBundle = p;
+	return 0;
+}
+
+int RqBundleUnmap(const RqBundle* pcBundle)
+{
+	if (munmap((void*)pcBundle, pcBundle->nFileSize) != 0) {
+		errmsg("Cannot unmap bundle.");
+		return RQ_ERR_EIO;
+	}
+	return 0;
+}
+
+/* Find the entry of the K' of nK; NULL if there is none */
+static const bundle_entry* bundle_find(const RqBundle* b, int nK)
+{
+	const parameters P = parameters_get(nK);
+	if (P.K == -1)
+		return NULL;
+	uint32_t lo = 0, hi = b->nEntries;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (b->entries[mid].nKprime < (uint32_t)P.Kprime)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == b->nEntries || b->entries[lo].nKprime != (uint32_t)P.Kprime)
+		return NULL;
+	return &b->entries[lo];
+}
+
+int RqBundleGetProgramSize(const RqBundle* pcBundle,
+			   int nK,
+			   size_t* pnProgMemSize)
+{
+	const bundle_entry* e = bundle_find(pcBundle, nK);
+	if (e == NULL) {
+		errmsg("K not in bundle.");
+		return RQ_ERR_EDOM;
+	}
+	*pnProgMemSize = sizeof(RqInterProgram) + e->nOps * sizeof(rq_op);
+	return 0;
+}
+
+int RqBundleLoadProgram(const RqBundle* pcBundle,
+			int nK,
+			RqInterProgram* pInterProgMem,
+			size_t nInterProgMemSize)
+{
+	const bundle_entry* e = bundle_find(pcBundle, nK);
+	if (e == NULL) {
+		errmsg("K not in bundle.");
+		return RQ_ERR_EDOM;
+	}
+	if (nInterProgMemSize < sizeof(RqInterProgram)
+	  || e->nOps > (nInterProgMemSize - sizeof(RqInterProgram))
+			/ sizeof(rq_op)) {
+		errmsg("Not enough memory for Program.");
+		return RQ_ERR_ENOMEM;
+	}
+
+	rq_op* ops = pInterProgMem->ops;
+	const uint8_t* packed = (const uint8_t*)pcBundle + e->nOffset;
+	if (rq_ops_unpack(packed, e->nPackedSize, ops, e->nOps) != 0) {
+		errmsg("Bundle is corrupt.");
+		return RQ_ERR_EFORMAT;
+	}
+
+	/* For K < K', the padding symbols are not part of the input, but
+	 * zero; this is what compiling for K gives, too.
+	 */
+	for (size_t i = 0; i < e->nOps; ++i) {
+		if (ops[i].op == RQ_OP_LOAD && ops[i].src >= (uint32_t)nK) {
+			ops[i] = (rq_op){ .dst = ops[i].dst,
+					  .op = RQ_OP_ZERO };
+		}
+	}
+	if (rq_ops_validate(ops, e->nOps, nK, e->nCols) != 0) {
+		errmsg("Bundle is corrupt.");
+		return RQ_ERR_EFORMAT;
+	}
+
+	pInterProgMem->magic = RQ_PROG_MAGIC;
+	pInterProgMem->version = RQ_PROG_VERSION;
+	pInterProgMem->nESI = nK;
+	pInterProgMem->nCols = e->nCols;
+	pInterProgMem->nOpsCompiled = e->nOpsCompiled;
+	pInterProgMem->nUnits = e->nUnits;
+	pInterProgMem->nOps = e->nOps;
+	return 0;
+}
+
+/* Streaming decoder; the state's memory follows the struct */
+struct RqStreamDec_ {
+	rq_stream s;
+	size_t nSymSize;
+};
+
+static size_t stream_mem_offs()
+{
+	return (sizeof(RqStreamDec) + 15) & ~(size_t)15;
+}
+
+int RqStreamGetMemSize(int nK, size_t nSymSize, size_t* pStreamDecMemSize)
+{
+	if (nK > RQ_STREAM_MAX_K) {
+		errmsg("K too large for the streaming decoder.");
+		return RQ_ERR_EDOM;
+	}
+	const parameters params = parameters_get(nK);
+	if (params.K == -1) {
+		errmsg("Unsupported K value.");
+		return RQ_ERR_EDOM;
+	}
+	*pStreamDecMemSize = stream_mem_offs()
+				+ rq_stream_mem_size(&params, nSymSize);
+	return 0;
+}
+
+int RqStreamInit(int nK,
+		 size_t nSymSize,
+		 RqStreamDec* pStreamDec,
+		 size_t nStreamDecMemSize)
+{
+	size_t need;
+	const int err = RqStreamGetMemSize(nK, nSymSize, &need);
+	if (err != 0)
+		return err;
+	if (nStreamDecMemSize < need) {
+		errmsg("Insufficient stream decoder memory size.");
+		return RQ_ERR_ENOMEM;
+	}
+	const parameters params = parameters_get(nK);
+	pStreamDec->nSymSize = nSymSize;
+	rq_stream_init(&pStreamDec->s, &params, nSymSize,
+			(char*)pStreamDec + stream_mem_offs());
+	return 0;
+}
+
+int RqStreamAddSymbol(RqStreamDec* pStreamDec,
+		      uint32_t nESI,
+		      const void* pcSym)
+{
+	rq_stream_add(&pStreamDec->s, nESI, pcSym);
+	return 0;
+}
+
+int RqStreamGetRank(const RqStreamDec* pStreamDec,
+		    int* pnRank,
+		    int* pnRankNeeded)
+{
+	if (pnRank != NULL)
+		*pnRank = pStreamDec->s.rank;
+	if (pnRankNeeded != NULL)
+		*pnRankNeeded = pStreamDec->s.P.L;
+	return 0;
+}
+
+int RqStreamGetInter(const RqStreamDec* pStreamDec,
+		     void* pInterSymMem,
+		     size_t nInterSymMemSize)
+{
+	const rq_stream* s = &pStreamDec->s;
+	if (s->rank < s->P.L)
+		return RQ_ERR_INSUFF_IDS;
+	if (nInterSymMemSize < (size_t)s->P.L * pStreamDec->nSymSize) {
+		errmsg("Insufficient intermediate symbol memory size.");
+		return RQ_ERR_ENOMEM;
+	}
+	rq_stream_get_inter(s, pInterSymMem);
+	return 0;
+}
+
+int RqInterGetOpCounts(const RqInterProgram* pcInterProgMem,
+		       size_t* pnOpsCompiled,
+		       size_t* pnOpsOptimized)
+{
+	if (pnOpsCompiled != NULL) {
+		*pnOpsCompiled = pcInterProgMem->nOpsCompiled;
+	}
+	if (pnOpsOptimized != NULL) {
+		*pnOpsOptimized = pcInterProgMem->nUnits;
+	}
+	return 0;
+}
+
+/* Narrowest strip chosen by the automatic strip sizing.  Every strip
+ * dispatches the whole schedule, and with narrower strips the
+ * dispatch overhead outweighs the gain in locality.
+ */
+#define RQ_MIN_AUTO_STRIP	2048
+
+/* Assumed L2 cache size if it cannot be queried */
+#define RQ_DEFAULT_L2_SIZE	(1024 * 1024)
+
+static size_t l2_cache_size()
+{
+	long sz = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	sz = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+	return (sz > 0) ? (size_t)sz : RQ_DEFAULT_L2_SIZE;
+}
+
+/* Strip width such that the rows the program works on together fit
+ * into L2.  That is not all the rows:  The received symbols are only
+ * loaded once, and so are most rows in the sparse parts of the
+ * schedule; what is reused many times over is essentially the rows of
+ * the dense part.  Symbols no wider than the narrowest strip are not
+ * split, which saves the scan of the program.
+ */
+static size_t auto_strip_size(const RqInterProgram* prog, size_t nSymSize)
+{
+	if (nSymSize <= RQ_MIN_AUTO_STRIP)
+		return nSymSize;
+	const size_t l2 = l2_cache_size();
+	const int n_max = (int)(l2 / RQ_MIN_AUTO_STRIP);
+	const int n_rows = rq_ops_working_rows(prog->ops, prog->nOps, n_max);
+	if (n_rows == 0)
+		return nSymSize;
+	size_t strip = l2 / n_rows;
+	strip -= strip % 64;
+	return (strip < RQ_MIN_AUTO_STRIP) ? RQ_MIN_AUTO_STRIP : strip;
+}
+
+/* Narrowest byte range a thread is given in the multithreaded
+ * execution; each thread runs the whole program on its range.
+ */
+#define RQ_MIN_THREAD_BYTES	512
+
+/* Split the symbol bytes into at most nThreads ranges of *pChunk bytes
+ * (the last one possibly shorter), and return the number of ranges.
+ */
+static int split_symbol(size_t nSymSize, int nThreads, size_t* pChunk)
+{
+	if (nThreads > RQ_POOL_MAX_THREADS)
+		nThreads = RQ_POOL_MAX_THREADS;
+	if (nThreads < 1)
+		nThreads = 1;
+	size_t chunk = (nSymSize + nThreads - 1) / nThreads;
+	if (chunk < RQ_MIN_THREAD_BYTES)
+		chunk = RQ_MIN_THREAD_BYTES;
+	chunk = (chunk + 63) & ~(size_t)63;
+	*pChunk = chunk;
+	if (nSymSize <= chunk)
+		return 1;
+	return (int)((nSymSize + chunk - 1) / chunk);
+}
+
+/* Column range [*pBeg, *pBeg + *pWidth) of the i-th chunk */
+static void chunk_range(size_t nSymSize, size_t chunk, int i,
+			int* pBeg, int* pWidth)
+{
+	const size_t beg = (size_t)i * chunk;
+	*pBeg = (int)beg;
+	*pWidth = (int)(nSymSize - beg < chunk ? nSymSize - beg : chunk);
+}
+
+typedef struct {
+	const RqInterProgram* prog;
+	const m256v* Y;
+	m256v* IB;
+	size_t chunk;
+	int strip;
+} inter_job;
+
+static void inter_task(void* arg, int i)
+{
+	const inter_job* job = arg;
+	int c0, w;
+	chunk_range(job->IB->n_col, job->chunk, i, &c0, &w);
+	const m256v Y = m256v_get_subview(job->Y, 0, c0, job->Y->n_row, w);
+	m256v IB = m256v_get_subview(job->IB, 0, c0, job->IB->n_row, w);
+	rq_ops_execute_strips(job->prog->ops, job->prog->nOps, &Y, &IB,
+				job->strip);
+}
+
 int RqInterExecute(const RqInterProgram* pcInterProgMem,
 		   size_t nSymSize,
 		   const void* pcInSymMem,
 		   size_t nInSymMemSize,
 		   void* pInterSymMem,
 		   size_t nInterSymMemSize)
+{
+	return RqInterExecuteEx(pcInterProgMem, nSymSize,
+				pcInSymMem, nInSymMemSize,
+				pInterSymMem, nInterSymMemSize, 0, 1);
+}
+
+int RqInterExecuteEx(const RqInterProgram* pcInterProgMem,
+		     size_t nSymSize,
+		     const void* pcInSymMem,
+		     size_t nInSymMemSize,
+		     void* pInterSymMem,
+		     size_t nInterSymMemSize,
+		     size_t nStripSize,
+		     int nThreads)
 {
 	/* Check memory sizes */
 #if 0
@@ -193,32 +1113,26 @@ int RqInterExecute(const RqInterProgram* pcInterProgMem,
 		return RQ_ERR_ENOMEM;
 	}
 #endif
-	if (nInterSymMemSize < pcInterProgMem->LU.n_col * nSymSize) {
+	if (nInterSymMemSize < pcInterProgMem->nCols * nSymSize) {
 		errmsg("Not enough space for Intermediate block provided.");
 		return RQ_ERR_ENOMEM;
 	}
 
 	/* Create matrices */
-	m256v IB = m256v_make(pcInterProgMem->LU.n_col, nSymSize, pInterSymMem);
+	m256v IB = m256v_make(pcInterProgMem->nCols, nSymSize, pInterSymMem);
 	m256v Y = m256v_make(pcInterProgMem->nESI, nSymSize, (void*)pcInSymMem);
 
-	/* Move data into the IB matrix */
-	for (int i = 0; i < pcInterProgMem->LU.n_row; ++i) {
-		const int l = pcInterProgMem->rowperm[i];
-		if (l >= pcInterProgMem->nESI) {
-			/* This row contains either a padded LT symbol
-			 * or an LDPC symbol or an HDPC symbol.  In
-			 * any case the corresponding RHS term is zero
-			 */
-			m256v_clear_row(&IB, i);
-		} else {
-			/* Row comes from an LT symbol */
-			m256v_copy_row(&Y, l, &IB, i);
-		}
-	}
-
-	/* Solve */
-	m256v_LU_invmult_inplace(&pcInterProgMem->LU, -1, NULL, NULL, &IB);
+	/* Run the schedule, on each thread's range of symbol bytes */
+	if (nStripSize == 0)
+		nStripSize = auto_strip_size(pcInterProgMem, nSymSize);
+	inter_job job = {
+		.prog = pcInterProgMem,
+		.Y = &Y,
+		.IB = &IB,
+		.strip = (nStripSize < nSymSize) ? (int)nStripSize : 0,
+	};
+	const int nTasks = split_symbol(nSymSize, nThreads, &job.chunk);
+	rq_pool_run(nTasks, inter_task, &job);
 	return 0;
 }
 
@@ -226,14 +1140,14 @@ int RqOutGetMemSizes(int nOutSymNum,
 		     size_t* pOutWorkMemSize,
 		     size_t* pOutProgMemSize)
 {
-	_Static_assert(sizeof(RqOutWorkMem) == sizeof(RqOutProgram),
-			"RqOutWorkMem and RqOutProgram need to be defined identically.");
-	const size_t sz = sizeof(RqOutWorkMem) + nOutSymNum*sizeof(uint32_t);
 	if (pOutWorkMemSize != NULL) {
-		*pOutWorkMemSize = sz;
+		*pOutWorkMemSize = sizeof(RqOutWorkMem)
+				+ nOutSymNum * sizeof(uint32_t);
 	}
 	if (pOutProgMemSize != NULL) {
-		*pOutProgMemSize = sz;
+		*pOutProgMemSize = sizeof(RqOutProgram)
+				+ (nOutSymNum + 1) * sizeof(uint32_t)
+				+ nOutSymNum * LT_MAX_ROW_WEIGHT * sizeof(int);
 	}
 	return 0;
 }
@@ -284,21 +1198,100 @@ int RqOutCompile(RqOutWorkMem* pOutWorkMem,
 		 RqOutProgram* pOutProgMem,
 		 size_t nOutProgMemSize)
 {
-	size_t sz = sizeof(*pOutProgMem) + pOutWorkMem->nESI * sizeof(pOutProgMem->ESIs[0]);
-	if (sz < nOutProgMemSize) {
+	const int n = pOutWorkMem->nESI;
+	const size_t offsSize = sizeof(*pOutProgMem)
+				+ (n + 1) * sizeof(pOutProgMem->offs[0]);
+	if (nOutProgMemSize < offsSize) {
 		errmsg("Not enough memory for OutProgMem.");
 		return RQ_ERR_ENOMEM;
 	}
+	const size_t nRowsMax = (nOutProgMemSize - offsSize) / sizeof(int);
 
-	memcpy(pOutProgMem, pOutWorkMem, sz);
+	/* Expand the tuples, so that executing is only summing rows */
+	pOutProgMem->params = pOutWorkMem->params;
+	pOutProgMem->nESI = n;
+	const parameters* P = &pOutWorkMem->params;
+	int* rows = out_rows(pOutProgMem);
+	size_t nRows = 0;
+	uint32_t ISIs[LT_BATCH];
+	tuple T[LT_BATCH];
+	for (int i0 = 0; i0 < n; i0 += LT_BATCH) {
+		const int m = n - i0 < LT_BATCH ? n - i0 : LT_BATCH;
+		for (int i = 0; i < m; ++i) {
+			const uint32_t ESI = pOutWorkMem->ESIs[i0 + i];
+			ISIs[i] = ESI + (ESI >= (uint32_t)P->K
+						? P->Kprime - P->K : 0);
+		}
+		tuple_generate_from_ISIs(P, m, ISIs, T);
+		for (int i = 0; i < m; ++i) {
+			int cols[LT_MAX_ROW_WEIGHT];
+			const int d = lt_row_from_tuple(P, T[i], cols);
+			if (nRows + d > nRowsMax) {
+				errmsg("Not enough memory for OutProgMem.");
+				return RQ_ERR_ENOMEM;
+			}
+			pOutProgMem->offs[i0 + i] = nRows;
+			memcpy(rows + nRows, cols, d * sizeof(int));
+			nRows += d;
+		}
+	}
+	pOutProgMem->offs[n] = nRows;
 	return 0;
 }
 
+/* Generate the output symbols O from the intermediate block I */
+static void out_generate(const RqOutProgram* prog, const m256v* I, m256v* O)
+{
+	/* Generate symbols
+	 *
+	 * The intermediate symbols making up each output symbol are
+	 * listed in the program, and summed up in a single pass over
+	 * the output symbol.
+	 */
+	const int* rows = out_rows(prog);
+	uint8_t ones[LT_MAX_ROW_WEIGHT];
+	memset(ones, 1, sizeof(ones));
+	for (int i = 0; i < prog->nESI; ++i) {
+		const int* r = rows + prog->offs[i];
+		const int n = prog->offs[i + 1] - prog->offs[i];
+		m256v_copy_row(I, r[0], O, i);
+		m256v_multadd_rows(I, r + 1, ones, n - 1, O, i);
+	}
+}
+
+typedef struct {
+	const RqOutProgram* prog;
+	const m256v* I;
+	m256v* O;
+	size_t chunk;
+} out_job;
+
+static void out_task(void* arg, int i)
+{
+	const out_job* job = arg;
+	int c0, w;
+	chunk_range(job->O->n_col, job->chunk, i, &c0, &w);
+	const m256v I = m256v_get_subview(job->I, 0, c0, job->I->n_row, w);
+	m256v O = m256v_get_subview(job->O, 0, c0, job->O->n_row, w);
+	out_generate(job->prog, &I, &O);
+}
+
 int RqOutExecute(const RqOutProgram* pcOutProgMem,
 		 size_t nSymSize,
 		 const void* pcInterSymMem,
 		 void* pOutSymMem,
 		 size_t nOutSymMemSize)
+{
+	return RqOutExecuteEx(pcOutProgMem, nSymSize, pcInterSymMem,
+				pOutSymMem, nOutSymMemSize, 1);
+}
+
+int RqOutExecuteEx(const RqOutProgram* pcOutProgMem,
+		   size_t nSymSize,
+		   const void* pcInterSymMem,
+		   void* pOutSymMem,
+		   size_t nOutSymMemSize,
+		   int nThreads)
 {
 	/* Check memory limitations */
 	if (nOutSymMemSize < pcOutProgMem->nESI * nSymSize) {
@@ -311,26 +1304,13 @@ int RqOutExecute(const RqOutProgram* pcOutProgMem,
 	m256v O = m256v_make(pcOutProgMem->nESI, nSymSize, pOutSymMem);
 	m256v I = m256v_make(P->L, nSymSize, (void*)pcInterSymMem);
 
-	/* Generate symbols */
-	for (int i = 0; i < pcOutProgMem->nESI; ++i) {
-		// Sect 5.3.5.3
-		tuple T = tuple_generate_from_ESI(
-				pcOutProgMem->ESIs[i], P);
-		m256v_copy_row(&I, T.b, &O, i);
-		for (int j = 1; j < T.d; ++j) {
-			T.b = (T.b + T.a) % P->W;
-			m256v_multadd_row(&I, T.b, 1, &O, i);
-		}
-		while (T.b1 >= P->P)
-			T.b1 = (T.b1 + T.a1) % P->P1;
-		m256v_multadd_row(&I, P->W + T.b1, 1, &O, i);
-		for (int j = 1; j < T.d1; ++j) {
-			do {
-				T.b1 = (T.b1 + T.a1) % P->P1;
-			} while(T.b1 >= P->P);
-			m256v_multadd_row(&I, P->W + T.b1, 1, &O, i);
-		}
-	}
-
+	/* Generate symbols, on each thread's range of symbol bytes */
+	out_job job = {
+		.prog = pcOutProgMem,
+		.I = &I,
+		.O = &O,
+	};
+	const int nTasks = split_symbol(nSymSize, nThreads, &job.chunk);
+	rq_pool_run(nTasks, out_task, &job);
 	return 0;
 }
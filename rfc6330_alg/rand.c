@@ -224,13 +224,18 @@ static const uint32_t V3[] = {
       3432275192
 };
 
-// Sect 5.3.5.1.
-uint32_t Rand(uint32_t y, int i, int m)
+uint32_t Rand_raw(uint32_t y, int i)
 {
 	const uint8_t x0 = (y + i) & 0xff;
 	const uint8_t x1 = ((y >> 8) + i) & 0xff;
 	const uint8_t x2 = ((y >> 16) + i) & 0xff;
 	const uint8_t x3 = ((y >> 24) + i) & 0xff;
 
-	return (V0[x0] ^ V1[x1] ^ V2[x2] ^ V3[x3]) % m;
+	return V0[x0] ^ V1[x1] ^ V2[x2] ^ V3[x3];
+}
+
+// Sect 5.3.5.1.
+uint32_t Rand(uint32_t y, int i, int m)
+{
+	return Rand_raw(y, i) % m;
 }
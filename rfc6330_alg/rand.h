@@ -10,4 +10,7 @@
 
 uint32_t Rand(uint32_t y, int i, int m);
 
+/** Rand(y, i, m) before the reduction modulo m. */
+uint32_t Rand_raw(uint32_t y, int i);
+
 #endif /* RAND_H */
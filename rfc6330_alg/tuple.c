@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "rand.h"
@@ -39,19 +40,85 @@ static const int f[] = {
 	1048576,
 };
 
+/* Degree at the start of each range of 1024 values of v; the ranges
+ * of the degrees are all wider than that, so at most one of them ends
+ * within a bucket.
+ */
+static const uint8_t deg_bucket[1024] = {
+	 1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+	 2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	 4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+	 4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+	 4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+	 4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+	 4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+	 4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+	 5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+	 5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+	 5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  6,  6,  6,  6,  6,  6,
+	 6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	 6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  7,  7,  7,  7,  7,
+	 7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+	 7,  7,  7,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,
+	 8,  8,  8,  8,  8,  8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+	 9,  9,  9,  9, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 11,
+	11, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12,
+	13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 15, 15, 15, 15,
+	15, 16, 16, 16, 16, 16, 17, 17, 17, 18, 18, 18, 18, 19, 19, 19,
+	20, 20, 21, 21, 21, 22, 22, 23, 23, 24, 24, 25, 25, 26, 27, 27,
+	28, 29, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+	30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+};
+
 // Sect 5.3.5.2.
-static int Deg(int v, int W)
+static int Deg(uint32_t v, int W)
 {
-	assert(0 <= v);
 	assert(v < (1 << 20));
 
-	for (int d = 1; d < sizeof(f)/sizeof(f[0]); ++d) {
-		if (f[d - 1] <= v && v < f[d]) {
-			return ((d <= W - 2) ? d : (W - 2));
-		}
-	}
-	assert(0); // Should never happen, given the precondition.
-	return -1;
+	int d = deg_bucket[v >> 10];
+	d += (v >= (uint32_t)f[d]);
+	return ((d <= W - 2) ? d : (W - 2));
 }
 
 // Sect 5.3.5.4.
@@ -83,3 +150,65 @@ tuple tuple_generate_from_ESI(uint32_t X, const parameters* P)
 		X += P->Kprime - P->K;
 	return tuple_generate_from_ISI(X, P);
 }
+
+/* Remainders by a fixed divisor m without a division, from D. Lemire,
+ * O. Kaser, N. Kurz, "Faster Remainder by Direct Computation", 2019:
+ * For 32 bit x, x % m is the high word of the 128 bit product of m
+ * and the fractional part of x/m, which M * x holds in 64 bits.
+ */
+typedef struct {
+	uint64_t M;
+	uint32_t m;
+} fastmod;
+
+static fastmod fastmod_make(uint32_t m)
+{
+	return (fastmod){ .M = UINT64_MAX / m + 1, .m = m };
+}
+
+static uint32_t fastmod_reduce(fastmod fm, uint32_t x)
+{
+#ifdef __SIZEOF_INT128__
+	return (uint32_t)(((unsigned __int128)(fm.M * x) * fm.m) >> 64);
+#else
+	return x % fm.m;
+#endif
+}
+
+/* The tuples for ISIs[0..n-1], or if ISIs is NULL, for ISI0, ...,
+ * ISI0 + n - 1.
+ */
+static void generate_batch(const parameters* P, int n, const uint32_t* ISIs,
+				uint32_t ISI0, tuple* T)
+{
+	const uint32_t A = (53591 + P->J * 997) | 0x1;
+	const uint32_t B = 10267 * (P->J + 1);
+	const fastmod W1 = fastmod_make(P->W - 1);
+	const fastmod W = fastmod_make(P->W);
+	const fastmod P11 = fastmod_make(P->P1 - 1);
+	const fastmod P1 = fastmod_make(P->P1);
+
+	for (int i = 0; i < n; ++i) {
+		const uint32_t X = ISIs ? ISIs[i] : ISI0 + i;
+		const uint32_t y = (B + X*A);
+		const uint32_t v = Rand_raw(y, 0) & ((1 << 20) - 1);
+		T[i].d = Deg(v, P->W);
+		T[i].a = 1 + fastmod_reduce(W1, Rand_raw(y, 1));
+		T[i].b = fastmod_reduce(W, Rand_raw(y, 2));
+		T[i].d1 = 2 + (T[i].d < 4 ? Rand_raw(X, 3) & 1 : 0);
+		T[i].a1 = 1 + fastmod_reduce(P11, Rand_raw(X, 4));
+		T[i].b1 = fastmod_reduce(P1, Rand_raw(X, 5));
+	}
+}
+
+void tuple_generate_from_ISIs(const parameters* P, int n,
+				const uint32_t* ISIs, tuple* T)
+{
+	generate_batch(P, n, ISIs, 0, T);
+}
+
+void tuple_generate_range(const parameters* P, uint32_t ISI0, int n,
+				tuple* T)
+{
+	generate_batch(P, n, NULL, ISI0, T);
+}
@@ -1,6 +1,8 @@
 #ifndef TUPLE_H
 #define TUPLE_H
 
+#include <stdint.h>
+
 #include "parameters.h"
 
 // Sect 5.3.3.2.
@@ -12,4 +14,13 @@ typedef struct {
 tuple tuple_generate_from_ISI(uint32_t ISI, const parameters* P);
 tuple tuple_generate_from_ESI(uint32_t ESI, const parameters* P);
 
+// The tuples of n ISIs at once; this is faster than one by one, as
+// the remainders by the fixed moduli are computed without divisions.
+void tuple_generate_from_ISIs(const parameters* P, int n,
+				const uint32_t* ISIs, tuple* T);
+
+// The tuples of the ISIs ISI0, ..., ISI0 + n - 1.
+void tuple_generate_range(const parameters* P, uint32_t ISI0, int n,
+				tuple* T);
+
 #endif /* TUPLE_H */
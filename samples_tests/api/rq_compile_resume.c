@@ -0,0 +1,211 @@
+/**	@file rq_compile_resume.c
+ *
+ *	Tests of resumed compilation:  After a compilation failed for
+ *	lack of symbols, adding ESIs one by one and resuming it yields a
+ *	program decoding to the intermediate block of the encoder, the
+ *	rank deficit goes down by at most one per ESI, and does not
+ *	change for a repeated ESI.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "api_utils.h"
+#include "rq_api.h"
+
+/**	Decode with the program prog for the ESIs esis[0..n-1], and
+ *	compare with the intermediate block ib_ref.
+ */
+static bool decodes(const RqInterProgram* prog, size_t interSymNum,
+			size_t dwidth, const int* esis, int n,
+			const uint8_t* syms, const uint8_t* ib_ref)
+{
+	uint8_t* in = malloc(n * dwidth);
+	uint8_t* ib = malloc(interSymNum * dwidth);
+	for (int i = 0; i < n; ++i)
+		memcpy(in + i * dwidth, syms + esis[i] * dwidth, dwidth);
+	const bool same = RqInterExecute(prog, dwidth, in, n * dwidth,
+					ib, interSymNum * dwidth) == 0
+		&& memcmp(ib, ib_ref, interSymNum * dwidth) == 0;
+	free(in);
+	free(ib);
+	return same;
+}
+
+/**	Start with K - 3 random ESIs, and add ESIs until the resumed
+ *	compilation succeeds.
+ */
+static bool test_resume(int K, int nFlags)
+{
+	const size_t dwidth = 9;
+	const int nSyms = 2 * K + 20;
+	bool success = true;
+	printf("Testing resumed compilation for K=%d%s.\n", K,
+		(nFlags & RQ_INTER_DENSE) ? " (dense)" : "");
+
+	size_t interSymNum;
+	RqInterGetMemSizes(K, 0, NULL, NULL, &interSymNum);
+	uint8_t* src = malloc(K * dwidth);
+	uint8_t* syms = malloc(nSyms * dwidth);
+	uint8_t* ib_ref = malloc(interSymNum * dwidth);
+	for (size_t i = 0; i < K * dwidth; ++i)
+		src[i] = rand() & 0xff;
+	if (!encode(K, nSyms, dwidth, src, ib_ref, syms)) {
+		fprintf(stderr, "Error:  Encoding failed.\n");
+		free(src);
+		free(syms);
+		free(ib_ref);
+		return false;
+	}
+
+	/* Random order of the ESIs; after K-3 of them, the first 4 are
+	 * repeated.
+	 */
+	const int nList = nSyms + 4;
+	int* esis = malloc(nList * sizeof(int));
+	for (int i = 0; i < nSyms; ++i)
+		esis[i] = i;
+	for (int i = nSyms - 1; i > 0; --i) {
+		const int j = rand() % (i + 1);
+		const int t = esis[i];
+		esis[i] = esis[j];
+		esis[j] = t;
+	}
+	memmove(esis + K + 1, esis + K - 3, (nSyms - K + 3) * sizeof(int));
+	memcpy(esis + K - 3, esis, 4 * sizeof(int));
+
+	size_t workSize, progSize;
+	RqInterGetMemSizesEx(K, nList - K, nFlags, &workSize, &progSize, NULL);
+	RqInterWorkMem* work = malloc(workSize);
+	RqInterProgram* prog = malloc(progSize);
+	RqInterInitEx(K, nList - K, nFlags, work, workSize);
+
+	/* Fewer rows than columns */
+	int n = 0;
+	for (; n < K - 3; ++n)
+		RqInterAddIds(work, esis[n], 1);
+	int err = RqInterCompile(work, prog, progSize);
+	int deficit;
+	RqInterGetRankDeficit(work, &deficit);
+	if (err != RQ_ERR_INSUFF_IDS || deficit != 3) {
+		fprintf(stderr, "Error:  Compile with K-3 ESIs returned %d, "
+				"deficit %d.\n", err, deficit);
+		success = false;
+	}
+
+	/* Enough rows, but 3 of them repeated */
+	for (; n < K; ++n)
+		RqInterAddIds(work, esis[n], 1);
+	err = RqInterCompileResume(work, prog, progSize);
+	RqInterGetRankDeficit(work, &deficit);
+	if (err != RQ_ERR_INSUFF_IDS || deficit < 3) {
+		fprintf(stderr, "Error:  Compile with 3 repeated ESIs "
+				"returned %d, deficit %d.\n", err, deficit);
+		success = false;
+	}
+
+	/* Add ESIs one by one; the next one is repeated, too */
+	while (success && err == RQ_ERR_INSUFF_IDS && n < nList) {
+		const bool repeated = (n == K);
+		RqInterAddIds(work, esis[n++], 1);
+		err = RqInterCompileResume(work, prog, progSize);
+		int d;
+		RqInterGetRankDeficit(work, &d);
+		if ((err == 0) != (d == 0) || d > deficit || d < deficit - 1
+		  || (repeated && d != deficit)) {
+			fprintf(stderr, "Error:  Deficit went from %d to %d "
+					"(status %d).\n", deficit, d, err);
+			success = false;
+		}
+		deficit = d;
+	}
+	if (success && err != 0) {
+		fprintf(stderr, "Error:  Resumed compile failed with %d.\n", err);
+		success = false;
+	} else if (success) {
+		printf("Compiled with %d ESIs.\n", n);
+		if (!decodes(prog, interSymNum, dwidth, esis, n,
+				syms, ib_ref)) {
+			fprintf(stderr, "Error:  Wrong intermediate block.\n");
+			success = false;
+		}
+	}
+
+	/* A fresh compilation agrees */
+	if (success) {
+		RqInterInitEx(K, nSyms - K + 1, nFlags, work, workSize);
+		for (int i = 0; i < n; ++i)
+			RqInterAddIds(work, esis[i], 1);
+		if (RqInterCompile(work, prog, progSize) != 0
+		  || !decodes(prog, interSymNum, dwidth, esis, n,
+				syms, ib_ref)) {
+			fprintf(stderr, "Error:  Fresh compile disagrees.\n");
+			success = false;
+		}
+	}
+
+	free(work);
+	free(prog);
+	free(esis);
+	free(src);
+	free(syms);
+	free(ib_ref);
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Test resuming compilations.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hs:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_resume(10, 0));
+	RUN_TEST(test_resume(11, 0));
+	RUN_TEST(test_resume(101, 0));
+	RUN_TEST(test_resume(1000, 0));
+	RUN_TEST(test_resume(101, RQ_INTER_DENSE));
+#undef RUN_TEST
+
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,144 @@
+/**	@file rq_compile_speed.c
+ *
+ *	Time RqInterCompile with the dense and the inactivation decoding
+ *	backends, for the K' values of the RFC 6330 table.  For the
+ *	latter, the number of row operations of the program before and
+ *	after the schedule optimization is shown as well.
+ *
+ *	The programs are compiled for the systematic ESIs 0, ..., K-1,
+ *	optionally with multiple threads (-t).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "parameters.h"
+#include "rq_api.h"
+
+/**	Time the compilation for K with the given flags.
+ *
+ *	The operation counts of the program before and after the
+ *	schedule optimization are stored in *pnOps and *pnUnits.
+ *
+ *	@return		The wall clock time in seconds, or a negative
+ *			value on failure.
+ */
+static double time_compile(int K, int nFlags, int nThreads,
+				size_t* pnOps, size_t* pnUnits)
+{
+	size_t workSize, progSize;
+	if (RqInterGetMemSizesEx(K, 0, nFlags, &workSize, &progSize, NULL) != 0)
+		return -1;
+	RqInterWorkMem* work = malloc(workSize);
+	RqInterProgram* prog = malloc(progSize);
+	double t = -1;
+	if (RqInterInitEx(K, 0, nFlags, work, workSize) == 0
+	  && RqInterAddIds(work, 0, K) == 0) {
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		const int err = RqInterCompileEx(work, prog, progSize,
+							nThreads);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		if (err == 0) {
+			t = (end.tv_sec - start.tv_sec)
+				+ 1e-9 * (end.tv_nsec - start.tv_nsec);
+			RqInterGetOpCounts(prog, pnOps, pnUnits);
+		}
+	}
+	free(work);
+	free(prog);
+	return t;
+}
+
+static void usage()
+{
+	puts(	"Time RqInterCompile for the K' values of RFC 6330.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -k #        smallest K to time (default 10)\n"
+		"   -K #        largest K to time (default 10000)\n"
+		"   -d #        largest K to time the dense backend for\n"
+		"               (default: same as -K)\n"
+		"   -n #        only time every n-th K' value (default 1)\n"
+		"   -t #        number of threads to compile with (default 1)\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int Kmin = 10;
+	int Kmax = 10000;
+	int Kdense = -1;
+	int nStep = 1;
+	int nThreads = 1;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hk:K:d:n:t:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 'k':
+			Kmin = atoi(optarg);
+			break;
+		case 'K':
+			Kmax = atoi(optarg);
+			break;
+		case 'd':
+			Kdense = atoi(optarg);
+			break;
+		case 'n':
+			nStep = atoi(optarg);
+			break;
+		case 't':
+			nThreads = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+	if (Kdense < 0)
+		Kdense = Kmax;
+	if (Kmax > RQ_MAX_K)
+		Kmax = RQ_MAX_K;
+	if (nStep < 1)
+		nStep = 1;
+
+	printf("%6s %6s %12s %12s %8s %10s %10s\n",
+		"K'", "L", "dense[s]", "inact[s]", "speedup", "ops", "units");
+	int i = 0;
+	int K = Kmin;
+	while (K <= Kmax) {
+		const parameters P = parameters_get(K);
+		if (P.K == -1)
+			break;
+		if (i++ % nStep == 0) {
+			size_t nOps = 0, nUnits = 0;
+			const double t_i =
+			  time_compile(P.Kprime, 0, nThreads,
+						&nOps, &nUnits);
+			if (P.Kprime <= Kdense) {
+				const double t_d = time_compile(P.Kprime,
+						RQ_INTER_DENSE, nThreads,
+						NULL, NULL);
+				printf("%6d %6d %12.4f %12.4f %8.1f",
+					P.Kprime, P.L, t_d, t_i,
+					t_i > 0 ? t_d / t_i : 0.0);
+			} else {
+				printf("%6d %6d %12s %12.4f %8s",
+					P.Kprime, P.L, "-", t_i, "-");
+			}
+			printf(" %10zu %10zu\n", nOps, nUnits);
+			fflush(stdout);
+		}
+
+		/* Next K' value */
+		K = P.Kprime + 1;
+	}
+
+	return EXIT_SUCCESS;
+}
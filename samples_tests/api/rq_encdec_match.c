@@ -2,11 +2,14 @@
  *
  *	Check that if a source block is encoded, and the symbols with
  *	ESIs v, v+1, ..., v + K - 1 are then decoded again, that the
- *	original data is obtained again.
+ *	original data is obtained again.  Also check that the
+ *	multithreaded execution gives the same results as the single
+ *	threaded one, also when several callers use it at once.
  */
 
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -15,6 +18,7 @@
 
 #include <getopt.h>
 
+#include "api_utils.h"
 #include "rq_api.h"
 
 int test_consistency_for(int K, int enc_offs)
@@ -174,6 +178,231 @@ static bool test_consistency(int nTestsPerK)
 	return success;
 }
 
+/**	Compare multithreaded to single threaded execution.
+ *
+ *	A source block is encoded into repair symbols, which are then
+ *	decoded again, with different thread counts.  The symbol sizes
+ *	are chosen such that the byte ranges of the threads are not all
+ *	of the same size.
+ */
+static bool test_threads()
+{
+	const int K = 297;
+	const int nRepair = K + 2;
+	const size_t dwidths[] = { 1, 700, 5001 };
+	const int nDwidths = sizeof(dwidths)/sizeof(dwidths[0]);
+	const int threads[] = { 2, 3, 8, 64 };
+	const int nThreads = sizeof(threads)/sizeof(threads[0]);
+	bool success = true;
+
+	printf("Testing multithreaded execution.\n");
+	RqInterProgram* enc = compile_inter(K, 0, K);
+	RqInterProgram* dec = compile_inter(K, K, nRepair);
+	RqOutProgram* out = compile_out(K, K, nRepair);
+	if (enc == NULL || dec == NULL || out == NULL) {
+		fprintf(stderr, "Error:  Compile failed.\n");
+		success = false;
+	}
+
+	size_t interSymNum;
+	RqInterGetMemSizes(K, nRepair - K, NULL, NULL, &interSymNum);
+	for (int i = 0; success && i < nDwidths; ++i) {
+		const size_t dwidth = dwidths[i];
+		uint8_t* src = malloc(K * dwidth);
+		uint8_t* ib_ref = malloc(interSymNum * dwidth);
+		uint8_t* ib = malloc(interSymNum * dwidth);
+		uint8_t* rep_ref = malloc(nRepair * dwidth);
+		uint8_t* rep = malloc(nRepair * dwidth);
+		for (size_t j = 0; j < K * dwidth; ++j)
+			src[j] = rand() & 0xff;
+
+		/* Single threaded reference */
+		if (RqInterExecute(enc, dwidth, src, K * dwidth,
+				ib_ref, interSymNum * dwidth) != 0
+		  || RqOutExecute(out, dwidth, ib_ref,
+				rep_ref, nRepair * dwidth) != 0) {
+			fprintf(stderr, "Error:  Execution failed.\n");
+			success = false;
+		}
+
+		for (int j = 0; success && j < nThreads; ++j) {
+			memset(rep, 0, nRepair * dwidth);
+			memset(ib, 0, interSymNum * dwidth);
+			if (RqOutExecuteEx(out, dwidth, ib_ref,
+					rep, nRepair * dwidth,
+					threads[j]) != 0
+			  || memcmp(rep, rep_ref, nRepair * dwidth) != 0) {
+				fprintf(stderr, "Error:  Encoding differs for "
+					"%d threads, symbol size %zu.\n",
+					threads[j], dwidth);
+				success = false;
+			}
+			if (RqInterExecuteEx(dec, dwidth,
+					rep_ref, nRepair * dwidth,
+					ib, interSymNum * dwidth,
+					0, threads[j]) != 0
+			  || memcmp(ib, ib_ref, interSymNum * dwidth) != 0) {
+				fprintf(stderr, "Error:  Decoding differs for "
+					"%d threads, symbol size %zu.\n",
+					threads[j], dwidth);
+				success = false;
+			}
+		}
+
+		free(src);
+		free(ib_ref);
+		free(ib);
+		free(rep_ref);
+		free(rep);
+	}
+
+	free(enc);
+	free(dec);
+	free(out);
+	return success;
+}
+
+typedef struct {
+	const RqInterProgram* dec;
+	size_t dwidth;
+	const uint8_t* rep;
+	size_t repSize;
+	const uint8_t* ib_ref;
+	size_t ibSize;
+	bool success;
+} job_arg;
+
+static void* job_main(void* varg)
+{
+	job_arg* arg = varg;
+	uint8_t* ib = malloc(arg->ibSize);
+	for (int i = 0; arg->success && i < 10; ++i) {
+		memset(ib, 0, arg->ibSize);
+		if (RqInterExecuteEx(arg->dec, arg->dwidth,
+				arg->rep, arg->repSize,
+				ib, arg->ibSize, 0, 4) != 0
+		  || memcmp(ib, arg->ib_ref, arg->ibSize) != 0)
+			arg->success = false;
+	}
+	free(ib);
+	return NULL;
+}
+
+/**	Several callers running multithreaded decodes at the same time
+ *	all get the right results.
+ */
+static bool test_concurrent_jobs()
+{
+	const int K = 297;
+	const int nRepair = K + 2;
+	const size_t dwidth = 3001;
+	enum { nCallers = 4 };
+	bool success = true;
+
+	printf("Testing concurrent multithreaded execution.\n");
+	RqInterProgram* enc = compile_inter(K, 0, K);
+	RqInterProgram* dec = compile_inter(K, K, nRepair);
+	RqOutProgram* out = compile_out(K, K, nRepair);
+	if (enc == NULL || dec == NULL || out == NULL) {
+		fprintf(stderr, "Error:  Compile failed.\n");
+		free(enc);
+		free(dec);
+		free(out);
+		return false;
+	}
+
+	size_t interSymNum;
+	RqInterGetMemSizes(K, nRepair - K, NULL, NULL, &interSymNum);
+	uint8_t* src = malloc(K * dwidth);
+	uint8_t* ib_ref = malloc(interSymNum * dwidth);
+	uint8_t* rep = malloc(nRepair * dwidth);
+	for (size_t j = 0; j < K * dwidth; ++j)
+		src[j] = rand() & 0xff;
+	if (RqInterExecute(enc, dwidth, src, K * dwidth,
+			ib_ref, interSymNum * dwidth) != 0
+	  || RqOutExecute(out, dwidth, ib_ref,
+			rep, nRepair * dwidth) != 0) {
+		fprintf(stderr, "Error:  Execution failed.\n");
+		success = false;
+	}
+
+	pthread_t callers[nCallers];
+	job_arg args[nCallers];
+	const int nStarted = success ? nCallers : 0;
+	for (int i = 0; i < nStarted; ++i) {
+		args[i] = (job_arg){ .dec = dec, .dwidth = dwidth,
+			.rep = rep, .repSize = nRepair * dwidth,
+			.ib_ref = ib_ref, .ibSize = interSymNum * dwidth,
+			.success = true };
+		pthread_create(&callers[i], NULL, job_main, &args[i]);
+	}
+	for (int i = 0; i < nStarted; ++i) {
+		pthread_join(callers[i], NULL);
+		if (!args[i].success) {
+			fprintf(stderr, "Error:  Caller %d got wrong "
+					"results.\n", i);
+			success = false;
+		}
+	}
+
+	free(src);
+	free(ib_ref);
+	free(rep);
+	free(enc);
+	free(dec);
+	free(out);
+	return success;
+}
+
+/**	Output programs compile into memory of at least the size from
+ *	RqOutGetMemSizes, and not into too little memory.
+ */
+static bool test_out_sizes()
+{
+	const int K = 100, n = 50;
+	const size_t dwidth = 7;
+	bool success = true;
+
+	printf("Testing output program memory sizes.\n");
+	size_t workSize, progSize, interSymNum;
+	RqOutGetMemSizes(n, &workSize, &progSize);
+	RqInterGetMemSizes(K, 0, NULL, NULL, &interSymNum);
+	RqOutWorkMem* work = malloc(workSize);
+	RqOutProgram* prog = malloc(2 * progSize);
+	RqOutProgram* ref = compile_out(K, 1000, n);
+	RqOutInit(K, work, workSize);
+	RqOutAddIds(work, 1000, n);
+
+	if (RqOutCompile(work, prog, 64) != RQ_ERR_ENOMEM) {
+		fprintf(stderr, "Error:  Compiled into too little memory.\n");
+		success = false;
+	}
+	if (ref == NULL || RqOutCompile(work, prog, 2 * progSize) != 0) {
+		fprintf(stderr, "Error:  Compile failed.\n");
+		success = false;
+	} else {
+		uint8_t* ib = malloc(interSymNum * dwidth);
+		uint8_t* o1 = malloc(n * dwidth);
+		uint8_t* o2 = malloc(n * dwidth);
+		for (size_t i = 0; i < interSymNum * dwidth; ++i)
+			ib[i] = rand() & 0xff;
+		if (RqOutExecute(ref, dwidth, ib, o1, n * dwidth) != 0
+		  || RqOutExecute(prog, dwidth, ib, o2, n * dwidth) != 0
+		  || memcmp(o1, o2, n * dwidth) != 0) {
+			fprintf(stderr, "Error:  Programs differ.\n");
+			success = false;
+		}
+		free(ib);
+		free(o1);
+		free(o2);
+	}
+
+	free(work);
+	free(prog);
+	free(ref);
+	return success;
+}
+
 static void usage()
 {
 	puts(	"RQ API tests.\n"
@@ -224,6 +453,9 @@ int main(int argc, char** argv)
 		} \
 	} while (0)
 	RUN_TEST(test_consistency(nTestsPerK));
+	RUN_TEST(test_threads());
+	RUN_TEST(test_concurrent_jobs());
+	RUN_TEST(test_out_sizes());
 #undef RUN_TEST
 
 	printf("Overall %d tests failed (%s)\n", nfail,
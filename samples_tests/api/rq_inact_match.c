@@ -0,0 +1,374 @@
+/**	@file rq_inact_match.c
+ *
+ *	Check that the inactivation decoding backend of RqInterCompile
+ *	behaves identically to the dense one (RQ_INTER_DENSE):  It fails
+ *	for the same ESI sets, and otherwise computes the same
+ *	intermediate block.  This includes ESI sets with many inactive
+ *	columns.  Also check that executing the programs in symbol strips
+ *	(RqInterExecuteEx) gives the same result.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "parameters.h"
+#include "rq_api.h"
+#include "tuple.h"
+
+/**	Compile a program for the given ESIs.
+ *
+ *	@return		0 on success, or the RqInterCompile error code.
+ *			On success, *ppProgram is allocated.
+ */
+static int compile(int K, int nFlags, int nESIs, const uint32_t* ESIs,
+			RqInterProgram** ppProgram, size_t* pInterSymNum)
+{
+	*ppProgram = NULL;
+
+	size_t workSize, progSize;
+	int err = RqInterGetMemSizesEx(K, nESIs - K, nFlags,
+				&workSize, &progSize, pInterSymNum);
+	if (err != 0)
+		return err;
+
+	RqInterWorkMem* work = malloc(workSize);
+	RqInterProgram* prog = malloc(progSize);
+	err = RqInterInitEx(K, nESIs - K, nFlags, work, workSize);
+	for (int i = 0; err == 0 && i < nESIs; ++i)
+		err = RqInterAddIds(work, ESIs[i], 1);
+	if (err == 0)
+		err = RqInterCompile(work, prog, progSize);
+
+	/* ESI sets leaving many columns inactive can need more program
+	 * memory than RqInterGetMemSizesEx reports.
+	 */
+	if (err == RQ_ERR_ENOMEM) {
+		RqInterGetProgMemNeeded(work, &progSize);
+		free(prog);
+		prog = malloc(progSize);
+		err = RqInterCompile(work, prog, progSize);
+	}
+	free(work);
+
+	if (err == 0) {
+		*ppProgram = prog;
+	} else {
+		free(prog);
+	}
+	return err;
+}
+
+/**	Encode random source data into the symbols with the given ESIs.
+ *
+ *	@return		0 on success.
+ */
+static int encode(int K, int nESIs, const uint32_t* ESIs, int dwidth,
+			uint8_t* iblock, size_t interSymNum, uint8_t* syms)
+{
+	uint32_t* srcESIs = malloc(K * sizeof(uint32_t));
+	uint8_t* src = malloc(K * dwidth);
+	for (int i = 0; i < K; ++i)
+		srcESIs[i] = i;
+	for (int i = 0; i < K * dwidth; ++i)
+		src[i] = rand() & 0xff;
+
+	RqInterProgram* prog;
+	int err = compile(K, 0, K, srcESIs, &prog, NULL);
+	if (err == 0) {
+		err = RqInterExecute(prog, dwidth, src, K * dwidth,
+					iblock, interSymNum * dwidth);
+		free(prog);
+	}
+	free(srcESIs);
+	free(src);
+	if (err != 0)
+		return err;
+
+	size_t outWorkSize, outProgSize;
+	err = RqOutGetMemSizes(nESIs, &outWorkSize, &outProgSize);
+	if (err != 0)
+		return err;
+	RqOutWorkMem* outWork = malloc(outWorkSize);
+	RqOutProgram* outProg = malloc(outProgSize);
+	err = RqOutInit(K, outWork, outWorkSize);
+	for (int i = 0; err == 0 && i < nESIs; ++i)
+		err = RqOutAddIds(outWork, ESIs[i], 1);
+	if (err == 0)
+		err = RqOutCompile(outWork, outProg, outProgSize);
+	if (err == 0)
+		err = RqOutExecute(outProg, dwidth, iblock, syms,
+					nESIs * dwidth);
+	free(outWork);
+	free(outProg);
+	return err;
+}
+
+/**	Run one comparison.
+ *
+ *	@return		0 if the backends agree, 1 otherwise.  *pDecoded
+ *			is set if decoding was possible.
+ */
+static int compare_for(int K, int nESIs, const uint32_t* ESIs,
+			bool* pDecoded)
+{
+	RqInterProgram* dense;
+	RqInterProgram* inact;
+	size_t interSymNum;
+	const int err_d = compile(K, RQ_INTER_DENSE, nESIs, ESIs,
+					&dense, &interSymNum);
+	const int err_i = compile(K, 0, nESIs, ESIs, &inact, NULL);
+	*pDecoded = (err_d == 0);
+	if (err_d != err_i) {
+		fprintf(stderr, "Error:  Compile results differ: "
+			"dense %d, inactivation %d.\n", err_d, err_i);
+		free(dense);
+		free(inact);
+		return 1;
+	}
+	if (err_d != 0)
+		return 0;
+
+	/* Decode encoded random data with both programs.  (With more
+	 * symbols than needed, arbitrary symbol data would be
+	 * inconsistent, and the results would depend on the choice of
+	 * rows.)
+	 */
+	const int dwidth = 13;
+	uint8_t* syms = malloc(nESIs * dwidth);
+	uint8_t* ib_ref = malloc(interSymNum * dwidth);
+	uint8_t* ib_d = malloc(interSymNum * dwidth);
+	uint8_t* ib_i = malloc(interSymNum * dwidth);
+	int ret = 0;
+	if (encode(K, nESIs, ESIs, dwidth, ib_ref, interSymNum, syms) != 0
+	  || RqInterExecute(dense, dwidth, syms, nESIs * dwidth,
+				ib_d, interSymNum * dwidth) != 0
+	  || RqInterExecute(inact, dwidth, syms, nESIs * dwidth,
+				ib_i, interSymNum * dwidth) != 0) {
+		fprintf(stderr, "Error:  Encoding or decoding failed.\n");
+		ret = 1;
+	} else if (memcmp(ib_d, ib_i, interSymNum * dwidth) != 0) {
+		fprintf(stderr, "Error:  Intermediate blocks differ.\n");
+		ret = 1;
+	} else if (memcmp(ib_ref, ib_i, interSymNum * dwidth) != 0) {
+		fprintf(stderr, "Error:  Intermediate block is wrong.\n");
+		ret = 1;
+	}
+
+	free(syms);
+	free(ib_ref);
+	free(ib_d);
+	free(ib_i);
+	free(dense);
+	free(inact);
+	return ret;
+}
+
+/**	Compare the backends on random ESI sets.
+ *
+ *	The ESIs are chosen from [0, 2K) with overheads of -1 to 2
+ *	symbols, so that both successful and failing decodings occur.
+ */
+static bool test_match(int nTestsPerK)
+{
+	const int Kvals[] = { 10, 26, 101, 297, 1000, 2804 };
+	const int nKvals = sizeof(Kvals)/sizeof(Kvals[0]);
+	bool success = true;
+
+	printf("Testing inactivation vs dense decoding.\n");
+	for (int i = 0; i < nKvals; ++i) {
+		const int K = Kvals[i];
+		const int nIter = (K > 500) ? 4 : nTestsPerK;
+		int ndec = 0;
+		uint32_t* ESIs = malloc(2 * K * sizeof(uint32_t));
+		for (int j = 0; j < nIter; ++j) {
+			/* Random selection of distinct ESIs */
+			for (int l = 0; l < 2 * K; ++l)
+				ESIs[l] = l;
+			const int nESIs = K - 1 + (j % 4);
+			for (int l = 0; l < nESIs; ++l) {
+				const int m = l + rand() % (2 * K - l);
+				const uint32_t t = ESIs[l];
+				ESIs[l] = ESIs[m];
+				ESIs[m] = t;
+			}
+
+			bool decoded;
+			if (compare_for(K, nESIs, ESIs, &decoded) != 0) {
+				fprintf(stderr, "        K=%d, j=%d.\n", K, j);
+				success = false;
+			}
+			ndec += decoded;
+		}
+		printf("  K=%d: %d of %d decodings successful.\n",
+			K, ndec, nIter);
+		free(ESIs);
+	}
+
+	return success;
+}
+
+/**	Compare the backends on repair symbols of high LT degree only.
+ *
+ *	These leave many more columns inactive than random ESI sets (over
+ *	a third of them for degree 5 and up); decoding has to work all
+ *	the same.
+ */
+static bool test_high_degree()
+{
+	const struct { int K, dmin; } cases[] = {
+		{ 1000, 10 }, { 3000, 3 }, { 3000, 5 },
+	};
+	const int nCases = sizeof(cases)/sizeof(cases[0]);
+	bool success = true;
+
+	printf("Testing ESIs of high LT degree.\n");
+	for (int i = 0; i < nCases; ++i) {
+		const int K = cases[i].K;
+		const parameters P = parameters_get(K);
+		const int nESIs = K + 2;
+		uint32_t* ESIs = malloc(nESIs * sizeof(uint32_t));
+		int n = 0;
+		for (uint32_t ESI = K; n < nESIs; ++ESI) {
+			const uint32_t ISI = ESI + P.Kprime - K;
+			if (tuple_generate_from_ISI(ISI, &P).d >= cases[i].dmin)
+				ESIs[n++] = ESI;
+		}
+
+		bool decoded;
+		if (compare_for(K, nESIs, ESIs, &decoded) != 0 || !decoded) {
+			fprintf(stderr, "Error:  Failed for K=%d, degree >= %d.\n",
+				K, cases[i].dmin);
+			success = false;
+		}
+		free(ESIs);
+	}
+
+	return success;
+}
+
+/**	Decode with RqInterExecuteEx for a range of strip sizes.
+ *
+ *	The strip sizes include ones that do not divide the symbol size,
+ *	and the automatic choice.
+ */
+static bool test_strips()
+{
+	const int Kvals[] = { 10, 297, 1000 };
+	const int nKvals = sizeof(Kvals)/sizeof(Kvals[0]);
+	const size_t strips[] = { 1, 64, 100, 333, 999, 1000, 5000, 0 };
+	const int nStrips = sizeof(strips)/sizeof(strips[0]);
+	const int dwidth = 1000;
+	bool success = true;
+
+	printf("Testing strip-wise execution.\n");
+	for (int i = 0; i < nKvals; ++i) {
+		const int K = Kvals[i];
+		const int nESIs = K + 2;
+		uint32_t* ESIs = malloc(nESIs * sizeof(uint32_t));
+		for (int l = 0; l < nESIs; ++l)
+			ESIs[l] = 2 * l + 1;
+
+		RqInterProgram* prog;
+		size_t interSymNum;
+		if (compile(K, 0, nESIs, ESIs, &prog, &interSymNum) != 0) {
+			fprintf(stderr, "Error:  Compile failed for K=%d.\n",
+				K);
+			free(ESIs);
+			success = false;
+			continue;
+		}
+
+		uint8_t* syms = malloc(nESIs * dwidth);
+		uint8_t* ib_ref = malloc(interSymNum * dwidth);
+		uint8_t* ib = malloc(interSymNum * dwidth);
+		if (encode(K, nESIs, ESIs, dwidth, ib_ref, interSymNum, syms)
+		  != 0) {
+			fprintf(stderr, "Error:  Encoding failed for K=%d.\n",
+				K);
+			success = false;
+		}
+		for (int j = 0; success && j < nStrips; ++j) {
+			memset(ib, 0, interSymNum * dwidth);
+			if (RqInterExecuteEx(prog, dwidth,
+					syms, nESIs * dwidth,
+					ib, interSymNum * dwidth,
+					strips[j], 1) != 0
+			  || memcmp(ib_ref, ib, interSymNum * dwidth) != 0) {
+				fprintf(stderr, "Error:  Wrong result for "
+					"K=%d, strip size %zu.\n",
+					K, strips[j]);
+				success = false;
+			}
+		}
+
+		free(syms);
+		free(ib_ref);
+		free(ib);
+		free(prog);
+		free(ESIs);
+	}
+
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Compare inactivation and dense decoding.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -i #        number of iterations per K\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int nTestsPerK = 20;
+
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hi:s:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 'i':
+			nTestsPerK = atoi(optarg);
+			break;
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_match(nTestsPerK));
+	RUN_TEST(test_high_degree());
+	RUN_TEST(test_strips());
+#undef RUN_TEST
+
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,203 @@
+/**	@file rq_partial_dec.c
+ *
+ *	Tests of partial decoding:  With a few source symbols missing,
+ *	the partial program and an output program for the missing ESIs
+ *	recover them, with fewer operations than the full program, and
+ *	with all source symbols received, the partial program is empty.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "api_utils.h"
+#include "rq_api.h"
+
+/**	Receive all but nMissing random source symbols, and nMissing + 2
+ *	repair symbols, and recover the missing source symbols.
+ */
+static bool test_partial(int K, int nMissing, int nFlags)
+{
+	const size_t dwidth = 11;
+	const int nRepair = nMissing + 2;
+	const int nSyms = K + nRepair;
+	bool success = true;
+	printf("Testing partial decoding for K=%d, %d missing%s.\n", K,
+		nMissing, (nFlags & RQ_INTER_DENSE) ? " (dense)" : "");
+
+	uint8_t* src = malloc(K * dwidth);
+	uint8_t* syms = malloc(nSyms * dwidth);
+	for (size_t i = 0; i < K * dwidth; ++i)
+		src[i] = rand() & 0xff;
+	if (!encode(K, nSyms, dwidth, src, NULL, syms)) {
+		fprintf(stderr, "Error:  Encoding failed.\n");
+		free(src);
+		free(syms);
+		return false;
+	}
+
+	/* Drop random source symbols */
+	bool* lost = calloc(K, sizeof(bool));
+	for (int i = 0; i < nMissing; ) {
+		const int esi = rand() % K;
+		if (!lost[esi]) {
+			lost[esi] = true;
+			++i;
+		}
+	}
+
+	/* Received symbols */
+	size_t workSize, progSize, interSymNum;
+	RqInterGetMemSizesEx(K, nRepair, nFlags,
+				&workSize, &progSize, &interSymNum);
+	RqInterWorkMem* work = malloc(workSize);
+	RqInterProgram* prog = malloc(progSize);
+	RqInterProgram* full = malloc(progSize);
+	uint8_t* in = malloc(nSyms * dwidth);
+	int nIn = 0;
+	RqInterInitEx(K, nRepair, nFlags, work, workSize);
+	for (int esi = 0; esi < nSyms; ++esi) {
+		if (esi < K && lost[esi])
+			continue;
+		RqInterAddIds(work, esi, 1);
+		memcpy(in + nIn++ * dwidth, syms + esi * dwidth, dwidth);
+	}
+
+	/* The missing ESIs */
+	uint32_t* missing = malloc(K * sizeof(uint32_t));
+	int nListed;
+	RqInterGetMissingIds(work, missing, &nListed);
+	bool listed = (nListed == nMissing);
+	for (int i = 0; listed && i < nListed; ++i)
+		listed = lost[missing[i]] && (i == 0 || missing[i - 1] < missing[i]);
+	if (!listed) {
+		fprintf(stderr, "Error:  Wrong missing ESIs.\n");
+		success = false;
+	}
+
+	/* Compile; a singular system is retried with more repair symbols
+	 * in other tests, here it is just skipped.
+	 */
+	int err = RqInterCompilePartial(work, prog, progSize);
+	if (err == RQ_ERR_INSUFF_IDS) {
+		printf("Not decodable, skipped.\n");
+		goto done;
+	} else if (err != 0 || RqInterCompile(work, full, progSize) != 0) {
+		fprintf(stderr, "Error:  Compile failed.\n");
+		success = false;
+		goto done;
+	}
+	size_t nPartialOps, nFullOps;
+	RqInterGetOpCounts(prog, &nPartialOps, NULL);
+	RqInterGetOpCounts(full, &nFullOps, NULL);
+	printf("%zu of %zu operations.\n", nPartialOps, nFullOps);
+	if ((nMissing == 0) != (nPartialOps == 0)
+	  || nPartialOps > nFullOps) {
+		fprintf(stderr, "Error:  Unexpected program size.\n");
+		success = false;
+	}
+
+	/* Recover the missing symbols */
+	if (success && nMissing > 0) {
+		uint8_t* ib = malloc(interSymNum * dwidth);
+		uint8_t* out = malloc(nMissing * dwidth);
+		size_t outWorkSize, outProgSize;
+		RqOutGetMemSizes(nMissing, &outWorkSize, &outProgSize);
+		RqOutWorkMem* outWork = malloc(outWorkSize);
+		RqOutProgram* outProg = malloc(outProgSize);
+		RqOutInit(K, outWork, outWorkSize);
+		for (int i = 0; i < nMissing; ++i)
+			RqOutAddIds(outWork, missing[i], 1);
+		if (RqInterExecute(prog, dwidth, in, nIn * dwidth,
+					ib, interSymNum * dwidth) != 0
+		  || RqOutCompile(outWork, outProg, outProgSize) != 0
+		  || RqOutExecute(outProg, dwidth, ib,
+					out, nMissing * dwidth) != 0) {
+			fprintf(stderr, "Error:  Execution failed.\n");
+			success = false;
+		}
+		for (int i = 0; success && i < nMissing; ++i) {
+			if (memcmp(out + i * dwidth, src + missing[i] * dwidth,
+					dwidth) != 0) {
+				fprintf(stderr, "Error:  Wrong source symbol "
+						"%u.\n", missing[i]);
+				success = false;
+			}
+		}
+		free(ib);
+		free(out);
+		free(outWork);
+		free(outProg);
+	}
+
+done:
+	free(lost);
+	free(missing);
+	free(in);
+	free(work);
+	free(prog);
+	free(full);
+	free(src);
+	free(syms);
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Test partial decoding.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hs:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_partial(10, 0, 0));
+	RUN_TEST(test_partial(10, 1, 0));
+	RUN_TEST(test_partial(11, 5, 0));
+	RUN_TEST(test_partial(1000, 0, 0));
+	RUN_TEST(test_partial(1000, 1, 0));
+	RUN_TEST(test_partial(1000, 20, 0));
+	RUN_TEST(test_partial(1000, 1000, 0));
+	RUN_TEST(test_partial(5000, 3, 0));
+	RUN_TEST(test_partial(101, 4, RQ_INTER_DENSE));
+#undef RUN_TEST
+
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
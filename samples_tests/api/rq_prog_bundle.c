@@ -0,0 +1,224 @@
+/**	@file rq_prog_bundle.c
+ *
+ *	Tests of bundles of systematic programs:  The programs loaded
+ *	from a bundle compute the same as compiled ones, also for K
+ *	values with padding, and damaged bundles are rejected.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <getopt.h>
+
+#include "api_utils.h"
+#include "rq_api.h"
+
+/* K range of the bundle; K=11 has padding, and K=10 is the K' below */
+#define KMIN	11
+#define KMAX	300
+
+/**	Load the program for K from a bundle.
+ *
+ *	@return		The program, or NULL on failure.
+ */
+static RqInterProgram* load(const RqBundle* bundle, int K)
+{
+	size_t progSize;
+	if (RqBundleGetProgramSize(bundle, K, &progSize) != 0)
+		return NULL;
+	RqInterProgram* prog = malloc(progSize);
+	if (RqBundleLoadProgram(bundle, K, prog, progSize) != 0) {
+		free(prog);
+		return NULL;
+	}
+	return prog;
+}
+
+/**	Programs loaded from the bundle match compiled ones. */
+static bool test_load(const char* path)
+{
+	/* K' values, K values with padding, and the range ends */
+	const int Kvals[] = { KMIN, 12, 18, 26, 100, 101, 251, KMAX };
+	const int nKvals = sizeof(Kvals)/sizeof(Kvals[0]);
+	bool success = true;
+
+	printf("Testing programs loaded from a bundle.\n");
+	const RqBundle* bundle;
+	if (RqBundleMap(path, &bundle) != 0) {
+		fprintf(stderr, "Error:  Cannot map the bundle.\n");
+		return false;
+	}
+	for (int i = 0; i < nKvals; ++i) {
+		const int K = Kvals[i];
+		RqInterProgram* ref = compile_inter(K, 0, K);
+		RqInterProgram* prog = load(bundle, K);
+		if (ref == NULL || prog == NULL) {
+			fprintf(stderr, "Error:  Compiling or loading the "
+					"program failed for K=%d.\n", K);
+			success = false;
+		} else {
+			size_t nRef, nProg;
+			RqInterGetOpCounts(ref, NULL, &nRef);
+			RqInterGetOpCounts(prog, NULL, &nProg);
+			if (nRef != nProg || RqInterGetProgramSize(ref)
+					!= RqInterGetProgramSize(prog)) {
+				fprintf(stderr, "Error:  Loaded program has "
+					"another size (K=%d).\n", K);
+				success = false;
+			}
+			if (!same_result(K, K, 13, ref, prog)) {
+				fprintf(stderr, "Error:  Loaded program "
+					"computes different result (K=%d).\n",
+					K);
+				success = false;
+			}
+		}
+		free(ref);
+		free(prog);
+	}
+
+	/* Outside the range */
+	size_t sz;
+	if (RqBundleGetProgramSize(bundle, KMIN - 1, &sz) != RQ_ERR_EDOM
+	  || RqBundleGetProgramSize(bundle, 400, &sz) != RQ_ERR_EDOM) {
+		fprintf(stderr, "Error:  Found K outside of the bundle.\n");
+		success = false;
+	}
+
+	/* Too little memory */
+	RqBundleGetProgramSize(bundle, 100, &sz);
+	RqInterProgram* prog = malloc(sz);
+	if (RqBundleLoadProgram(bundle, 100, prog, sz - 1) != RQ_ERR_ENOMEM) {
+		fprintf(stderr, "Error:  Loaded into too little memory.\n");
+		success = false;
+	}
+	free(prog);
+
+	RqBundleUnmap(bundle);
+	return success;
+}
+
+/**	Damaged bundles are rejected. */
+static bool test_reject(const char* path)
+{
+	bool success = true;
+	printf("Testing rejection of damaged bundles.\n");
+
+	FILE* f = fopen(path, "r+b");
+	if (f == NULL) {
+		fprintf(stderr, "Error:  Cannot open the bundle.\n");
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	const long size = ftell(f);
+	uint8_t buf[64];
+
+	/* Wrong magic number */
+	fseek(f, 0, SEEK_SET);
+	fread(buf, 1, 1, f);
+	buf[1] = buf[0] ^ 0xff;
+	fseek(f, 0, SEEK_SET);
+	fwrite(&buf[1], 1, 1, f);
+	fflush(f);
+	const RqBundle* bundle;
+	if (RqBundleMap(path, &bundle) != RQ_ERR_EFORMAT) {
+		fprintf(stderr, "Error:  Bundle with wrong magic accepted.\n");
+		success = false;
+	}
+	fseek(f, 0, SEEK_SET);
+	fwrite(&buf[0], 1, 1, f);
+
+	/* Garbage at the end of the last program */
+	memset(buf, 0xff, sizeof(buf));
+	fseek(f, size - sizeof(buf), SEEK_SET);
+	fwrite(buf, 1, sizeof(buf), f);
+	fclose(f);
+	if (RqBundleMap(path, &bundle) != 0) {
+		fprintf(stderr, "Error:  Cannot map the bundle.\n");
+		return false;
+	}
+	size_t sz;
+	RqBundleGetProgramSize(bundle, KMAX, &sz);
+	RqInterProgram* prog = malloc(sz);
+	if (RqBundleLoadProgram(bundle, KMAX, prog, sz) != RQ_ERR_EFORMAT) {
+		fprintf(stderr, "Error:  Damaged program loaded.\n");
+		success = false;
+	}
+	free(prog);
+	RqBundleUnmap(bundle);
+
+	/* Nonexistent file */
+	if (RqBundleMap("/nonexistent/rq_bundle", &bundle) != RQ_ERR_EIO) {
+		fprintf(stderr, "Error:  Mapping missing file succeeded.\n");
+		success = false;
+	}
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Test bundles of systematic programs.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hs:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	/* Create the bundle */
+	char path[] = "/tmp/rq_prog_bundle_XXXXXX";
+	const int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Error:  Cannot create temporary file.\n");
+		exit(EXIT_FAILURE);
+	}
+	close(fd);
+	if (RqBundleWrite(path, KMIN, KMAX, 1) != 0) {
+		fprintf(stderr, "Error:  Cannot write the bundle.\n");
+		unlink(path);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_load(path));
+	RUN_TEST(test_reject(path));
+#undef RUN_TEST
+
+	unlink(path);
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
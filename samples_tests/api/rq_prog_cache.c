@@ -0,0 +1,317 @@
+/**	@file rq_prog_cache.c
+ *
+ *	Tests of the program cache (RqInterCompileCached):  Cached
+ *	programs compute the same as freshly compiled ones, the memory
+ *	budget is respected, evicted programs stay valid while
+ *	referenced, and concurrent use from multiple threads works.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "api_utils.h"
+#include "rq_api.h"
+
+/**	Set up the work memory for the ESIs first, ..., first + n - 1.
+ *
+ *	@return		The work memory, or NULL on failure.
+ */
+static RqInterWorkMem* make_work(int K, uint32_t first, int n)
+{
+	size_t workSize;
+	if (RqInterGetMemSizes(K, n - K, &workSize, NULL, NULL) != 0)
+		return NULL;
+	RqInterWorkMem* work = malloc(workSize);
+	if (RqInterInit(K, n - K, work, workSize) != 0
+	  || RqInterAddIds(work, first, n) != 0) {
+		free(work);
+		return NULL;
+	}
+	return work;
+}
+
+/**	Cached programs are reused, and compute the same as fresh ones. */
+static bool test_reuse()
+{
+	const int K = 100;
+	bool success = true;
+	printf("Testing program reuse.\n");
+	RqCacheSetBudget(64 << 20);
+
+	/* Reference program */
+	size_t workSize, progSize;
+	RqInterGetMemSizes(K, 0, &workSize, &progSize, NULL);
+	RqInterWorkMem* work = make_work(K, 0, K);
+	RqInterProgram* ref = malloc(progSize);
+	RqInterCompile(work, ref, progSize);
+
+	size_t hits0, misses0, hits, misses, bytes;
+	RqCacheGetStats(&hits0, &misses0, NULL);
+	const RqInterProgram* p1;
+	const RqInterProgram* p2;
+	if (RqInterCompileCached(work, &p1) != 0
+	  || RqInterCompileCached(work, &p2) != 0) {
+		fprintf(stderr, "Error:  RqInterCompileCached failed.\n");
+		success = false;
+	} else {
+		RqCacheGetStats(&hits, &misses, &bytes);
+		if (p1 != p2 || hits != hits0 + 1 || misses != misses0 + 1
+		  || bytes == 0) {
+			fprintf(stderr, "Error:  Program was not reused.\n");
+			success = false;
+		}
+		if (!same_result(K, K, 7, ref, p1)) {
+			fprintf(stderr, "Error:  Cached program computes "
+					"different result.\n");
+			success = false;
+		}
+		RqInterReleaseCached(p1);
+		RqInterReleaseCached(p2);
+	}
+
+	/* Same K, other ESIs */
+	free(work);
+	work = make_work(K, 1, K);
+	if (RqInterCompileCached(work, &p2) != 0) {
+		fprintf(stderr, "Error:  RqInterCompileCached failed.\n");
+		success = false;
+	} else {
+		if (p1 == p2) {
+			fprintf(stderr, "Error:  Program reused for "
+					"different ESIs.\n");
+			success = false;
+		}
+		RqInterReleaseCached(p2);
+	}
+
+	RqCacheSetBudget(0);
+	RqCacheGetStats(NULL, NULL, &bytes);
+	if (bytes != 0) {
+		fprintf(stderr, "Error:  Cache not empty with budget 0.\n");
+		success = false;
+	}
+
+	free(work);
+	free(ref);
+	return success;
+}
+
+/**	The budget is respected, and held programs survive eviction. */
+static bool test_eviction()
+{
+	const int K = 300;
+	const int nProgs = 6;
+	bool success = true;
+	printf("Testing eviction.\n");
+
+	/* Measure the size of one program */
+	RqCacheSetBudget(64 << 20);
+	RqInterWorkMem* work = make_work(K, 0, K);
+	const RqInterProgram* held;
+	size_t bytes;
+	if (RqInterCompileCached(work, &held) != 0) {
+		fprintf(stderr, "Error:  RqInterCompileCached failed.\n");
+		free(work);
+		return false;
+	}
+	RqCacheGetStats(NULL, NULL, &bytes);
+	free(work);
+
+	/* Make room for about two programs, and add more */
+	const size_t budget = 5 * bytes / 2;
+	RqCacheSetBudget(budget);
+	for (int i = 1; i < nProgs; ++i) {
+		const RqInterProgram* p;
+		work = make_work(K, i, K);
+		if (RqInterCompileCached(work, &p) != 0) {
+			fprintf(stderr, "Error:  RqInterCompileCached "
+					"failed.\n");
+			success = false;
+		} else {
+			RqInterReleaseCached(p);
+		}
+		free(work);
+
+		size_t used;
+		RqCacheGetStats(NULL, NULL, &used);
+		if (used > budget) {
+			fprintf(stderr, "Error:  Cache exceeds budget.\n");
+			success = false;
+		}
+	}
+
+	/* The first program has been evicted, but is still usable */
+	size_t hits0, hits;
+	RqCacheGetStats(&hits0, NULL, NULL);
+	work = make_work(K, 0, K);
+	const RqInterProgram* p;
+	if (RqInterCompileCached(work, &p) != 0) {
+		fprintf(stderr, "Error:  RqInterCompileCached failed.\n");
+		success = false;
+	} else {
+		RqCacheGetStats(&hits, NULL, NULL);
+		if (hits != hits0 || p == held) {
+			fprintf(stderr, "Error:  LRU program not evicted.\n");
+			success = false;
+		}
+		if (!same_result(K, K, 7, held, p)) {
+			fprintf(stderr, "Error:  Evicted program "
+					"computes different result.\n");
+			success = false;
+		}
+		RqInterReleaseCached(p);
+	}
+	RqInterReleaseCached(held);
+	free(work);
+
+	RqCacheSetBudget(0);
+	return success;
+}
+
+typedef struct {
+	int nIter;
+	const size_t* nOpsRef;
+	int nPatterns;
+	bool success;
+} thread_arg;
+
+static void* thread_main(void* varg)
+{
+	thread_arg* arg = varg;
+	const int K = 50;
+	unsigned seed = (unsigned)(size_t)varg;
+	for (int i = 0; i < arg->nIter; ++i) {
+		const int pat = rand_r(&seed) % arg->nPatterns;
+		RqInterWorkMem* work = make_work(K, pat, K);
+		const RqInterProgram* p;
+		size_t nOps;
+		if (RqInterCompileCached(work, &p) != 0) {
+			arg->success = false;
+		} else {
+			RqInterGetOpCounts(p, &nOps, NULL);
+			if (nOps != arg->nOpsRef[pat])
+				arg->success = false;
+			RqInterReleaseCached(p);
+		}
+		free(work);
+	}
+	return NULL;
+}
+
+/**	Use the cache from several threads at once, with evictions
+ *	going on.
+ */
+static bool test_threads(int nThreads)
+{
+	const int K = 50;
+	enum { nPatterns = 8 };
+	bool success = true;
+	printf("Testing concurrent use by %d threads.\n", nThreads);
+
+	/* Reference op counts, and the size of a program */
+	size_t nOpsRef[nPatterns];
+	size_t workSize, progSize;
+	RqInterGetMemSizes(K, 0, &workSize, &progSize, NULL);
+	RqInterProgram* prog = malloc(progSize);
+	size_t bytes = 0;
+	for (int i = 0; i < nPatterns; ++i) {
+		RqInterWorkMem* work = make_work(K, i, K);
+		RqInterCompile(work, prog, progSize);
+		RqInterGetOpCounts(prog, &nOpsRef[i], NULL);
+		free(work);
+	}
+	RqCacheSetBudget(64 << 20);
+	RqInterWorkMem* work = make_work(K, 0, K);
+	const RqInterProgram* p;
+	RqInterCompileCached(work, &p);
+	RqInterReleaseCached(p);
+	RqCacheGetStats(NULL, NULL, &bytes);
+	free(work);
+	free(prog);
+
+	/* Room for half the patterns */
+	RqCacheSetBudget(bytes * nPatterns / 2);
+
+	pthread_t threads[nThreads];
+	thread_arg args[nThreads];
+	for (int i = 0; i < nThreads; ++i) {
+		args[i] = (thread_arg){ .nIter = 200, .nOpsRef = nOpsRef,
+				.nPatterns = nPatterns, .success = true };
+		pthread_create(&threads[i], NULL, thread_main, &args[i]);
+	}
+	for (int i = 0; i < nThreads; ++i) {
+		pthread_join(threads[i], NULL);
+		if (!args[i].success) {
+			fprintf(stderr, "Error:  Thread %d got wrong "
+					"programs.\n", i);
+			success = false;
+		}
+	}
+
+	RqCacheSetBudget(0);
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Test the program cache.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -t #        number of threads for the concurrency test\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int nThreads = 8;
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "ht:s:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 't':
+			nThreads = atoi(optarg);
+			break;
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	if (nThreads < 1)
+		nThreads = 1;
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_reuse());
+	RUN_TEST(test_eviction());
+	RUN_TEST(test_threads(nThreads));
+#undef RUN_TEST
+
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
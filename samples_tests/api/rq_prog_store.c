@@ -0,0 +1,219 @@
+/**	@file rq_prog_store.c
+ *
+ *	Tests of stored programs:  Programs copied in memory or saved to
+ *	and mapped from a file compute the same as the original, and
+ *	damaged programs are rejected.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <getopt.h>
+
+#include "api_utils.h"
+#include "rq_api.h"
+
+/* Layout of stored programs, see tvrq_api.c:  A 40 byte header, with
+ * the magic number and the version in the first two 32 bit words,
+ * followed by 8 byte operations { uint32 src, uint16 dst, uint8 op,
+ * uint8 alpha }.
+ */
+#define HEADER_SIZE	40
+#define OP_SIZE		8
+
+/* Operation codes of accumulations (XOR, MULADD, MULTI) */
+#define is_acc_code(c)	((c) == 2 || (c) == 3 || (c) == 5)
+
+/**	Copy programs in memory and through a file. */
+static bool test_roundtrip()
+{
+	const int Kvals[] = { 10, 500, 2000 };
+	const int nKvals = sizeof(Kvals)/sizeof(Kvals[0]);
+	bool success = true;
+
+	printf("Testing program copies and files.\n");
+	char path[] = "/tmp/rq_prog_store_XXXXXX";
+	const int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Error:  Cannot create temporary file.\n");
+		return false;
+	}
+	close(fd);
+
+	for (int i = 0; success && i < nKvals; ++i) {
+		const int K = Kvals[i];
+		RqInterProgram* prog = compile_inter(K, K / 2, K + 1);
+		if (prog == NULL) {
+			fprintf(stderr, "Error:  Compile failed for K=%d.\n", K);
+			success = false;
+			break;
+		}
+
+		/* Copy of exactly the used size */
+		const size_t sz = RqInterGetProgramSize(prog);
+		void* copy = malloc(sz);
+		memcpy(copy, prog, sz);
+		memset(prog, 0, sz);
+		const RqInterProgram* pc;
+		if (RqInterProgramFromMem(copy, sz, &pc) != 0 || pc != copy) {
+			fprintf(stderr, "Error:  Copied program rejected "
+					"(K=%d).\n", K);
+			success = false;
+		}
+
+		/* Through a file */
+		const RqInterProgram* pm;
+		if (success && (RqInterSaveProgram(pc, path) != 0
+		  || RqInterMapProgram(path, &pm) != 0)) {
+			fprintf(stderr, "Error:  Saving or mapping the program "
+					"failed (K=%d).\n", K);
+			success = false;
+		} else if (success) {
+			if (!same_result(K, K + 1, 11, pc, pm)) {
+				fprintf(stderr, "Error:  Mapped program "
+					"computes different result (K=%d).\n",
+					K);
+				success = false;
+			}
+			RqInterUnmapProgram(pm);
+		}
+		free(copy);
+		free(prog);
+	}
+
+	unlink(path);
+	return success;
+}
+
+/**	Check that a damaged program is rejected with RQ_ERR_EFORMAT. */
+static bool rejected(const uint8_t* mem, size_t sz, const char* what)
+{
+	void* copy = malloc(sz);
+	memcpy(copy, mem, sz);
+	const RqInterProgram* p;
+	const int err = RqInterProgramFromMem(copy, sz, &p);
+	free(copy);
+	if (err != RQ_ERR_EFORMAT || p != NULL) {
+		fprintf(stderr, "Error:  Program with %s accepted.\n", what);
+		return false;
+	}
+	return true;
+}
+
+/**	Damaged programs are rejected. */
+static bool test_reject()
+{
+	const int K = 100;
+	bool success = true;
+
+	printf("Testing rejection of damaged programs.\n");
+	RqInterProgram* prog = compile_inter(K, 0, K);
+	if (prog == NULL) {
+		fprintf(stderr, "Error:  Compile failed.\n");
+		return false;
+	}
+	const size_t sz = RqInterGetProgramSize(prog);
+	uint8_t* mem = malloc(sz);
+	memcpy(mem, prog, sz);
+
+	success &= rejected(mem, HEADER_SIZE - 1, "truncated header");
+	success &= rejected(mem, sz - 1, "truncated operations");
+	mem[0] ^= 0xff;
+	success &= rejected(mem, sz, "wrong magic");
+	mem[0] ^= 0xff;
+	mem[4] ^= 0xff;
+	success &= rejected(mem, sz, "wrong version");
+	mem[4] ^= 0xff;
+
+	/* Damage an accumulation, which has a source and a target row */
+	uint8_t* op = mem + HEADER_SIZE;
+	while (op < mem + sz && !is_acc_code(op[6]))
+		op += OP_SIZE;
+	if (op == mem + sz) {
+		fprintf(stderr, "Error:  No accumulation in the program.\n");
+		free(mem);
+		free(prog);
+		return false;
+	}
+	uint8_t save[OP_SIZE];
+	memcpy(save, op, OP_SIZE);
+	op[4] = op[5] = 0xff;
+	success &= rejected(mem, sz, "target row out of range");
+	memcpy(op, save, OP_SIZE);
+	op[6] = 0x7f;
+	success &= rejected(mem, sz, "invalid operation code");
+	memcpy(op, save, OP_SIZE);
+	op[0] = op[1] = op[2] = op[3] = 0xff;
+	success &= rejected(mem, sz, "source row out of range");
+	memcpy(op, save, OP_SIZE);
+
+	/* The undamaged program is accepted */
+	const RqInterProgram* p;
+	if (RqInterProgramFromMem(mem, sz, &p) != 0) {
+		fprintf(stderr, "Error:  Valid program rejected.\n");
+		success = false;
+	}
+
+	/* Nonexistent file */
+	if (RqInterMapProgram("/nonexistent/rq_program", &p) != RQ_ERR_EIO) {
+		fprintf(stderr, "Error:  Mapping missing file succeeded.\n");
+		success = false;
+	}
+
+	free(mem);
+	free(prog);
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Test storing and loading programs.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hs:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_roundtrip());
+	RUN_TEST(test_reject());
+#undef RUN_TEST
+
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,165 @@
+/**	@file rq_stream_dec.c
+ *
+ *	Tests of the streaming decoder:  Symbols fed in random order
+ *	decode to the intermediate block of the encoder, dependent
+ *	symbols do not increase the rank, the intermediate block is only
+ *	available once the rank is L, and K beyond RQ_STREAM_MAX_K is
+ *	refused.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "api_utils.h"
+#include "rq_api.h"
+
+/**	Decode K source symbols from a random selection of source and
+ *	repair symbols.
+ */
+static bool test_decode(int K)
+{
+	const int dwidth = 17;
+	const int nSyms = 2 * K + 20;
+	bool success = true;
+	printf("Testing streaming decoding for K=%d.\n", K);
+
+	/* Encode */
+	size_t interSymNum;
+	RqInterGetMemSizes(K, 0, NULL, NULL, &interSymNum);
+	uint8_t* src = malloc(K * dwidth);
+	uint8_t* syms = malloc(nSyms * dwidth);
+	uint8_t* ib_ref = malloc(interSymNum * dwidth);
+	uint8_t* ib = malloc(interSymNum * dwidth);
+	for (int i = 0; i < K * dwidth; ++i)
+		src[i] = rand() & 0xff;
+	if (!encode(K, nSyms, dwidth, src, ib_ref, syms)) {
+		fprintf(stderr, "Error:  Encoding failed.\n");
+		success = false;
+		goto done;
+	}
+
+	/* Feed the symbols in random order until the rank is L */
+	size_t decSize;
+	RqStreamGetMemSize(K, dwidth, &decSize);
+	RqStreamDec* dec = malloc(decSize);
+	RqStreamInit(K, dwidth, dec, decSize);
+	int* order = malloc(nSyms * sizeof(int));
+	for (int i = 0; i < nSyms; ++i)
+		order[i] = i;
+	for (int i = nSyms - 1; i > 0; --i) {
+		const int j = rand() % (i + 1);
+		const int t = order[i];
+		order[i] = order[j];
+		order[j] = t;
+	}
+	int rank = 0, L = 0, nFed = 0;
+	while (nFed < nSyms) {
+		RqStreamGetRank(dec, &rank, &L);
+		if (rank == L)
+			break;
+		if (RqStreamGetInter(dec, ib, interSymNum * dwidth)
+						!= RQ_ERR_INSUFF_IDS) {
+			fprintf(stderr, "Error:  Intermediate block "
+					"available with rank %d.\n", rank);
+			success = false;
+		}
+		const int esi = order[nFed++];
+		RqStreamAddSymbol(dec, esi, syms + esi * dwidth);
+
+		/* The same symbol again is dependent */
+		int rank2;
+		RqStreamAddSymbol(dec, esi, syms + esi * dwidth);
+		RqStreamGetRank(dec, &rank2, NULL);
+		if (rank2 > rank + 1) {
+			fprintf(stderr, "Error:  Duplicate symbol "
+					"increased the rank.\n");
+			success = false;
+		}
+	}
+	if (rank != L || (size_t)L != interSymNum) {
+		fprintf(stderr, "Error:  Rank %d after all symbols.\n", rank);
+		success = false;
+	} else if (RqStreamGetInter(dec, ib, interSymNum * dwidth) != 0
+	  || memcmp(ib, ib_ref, interSymNum * dwidth) != 0) {
+		fprintf(stderr, "Error:  Wrong intermediate block.\n");
+		success = false;
+	} else {
+		printf("Decoded after %d of %d symbols.\n", nFed, nSyms);
+	}
+	free(dec);
+	free(order);
+
+done:
+	free(src);
+	free(syms);
+	free(ib_ref);
+	free(ib);
+	return success;
+}
+
+/**	K beyond the supported maximum is refused. */
+static bool test_max_K()
+{
+	size_t decSize;
+	printf("Testing the maximum K.\n");
+	return RqStreamGetMemSize(RQ_STREAM_MAX_K, 1, &decSize) == 0
+		&& RqStreamGetMemSize(RQ_STREAM_MAX_K + 1, 1, &decSize)
+			== RQ_ERR_EDOM;
+}
+
+static void usage()
+{
+	puts(	"Test the streaming decoder.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -s #        set RNG seed\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	int seed = 0;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "hs:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	/* Run tests */
+	int nfail = 0;
+	srand(seed < 0 ? time(0) : seed);
+#define RUN_TEST(x) \
+	do { \
+		if (x) { \
+			printf("--> pass\n"); \
+		} else { \
+			printf("--> FAIL\n"); \
+			++nfail; \
+		} \
+	} while (0)
+	RUN_TEST(test_decode(10));
+	RUN_TEST(test_decode(11));
+	RUN_TEST(test_decode(101));
+	RUN_TEST(test_decode(500));
+	RUN_TEST(test_max_K());
+#undef RUN_TEST
+
+	printf("Overall %d tests failed (%s)\n", nfail,
+		(nfail ? "FAIL" : "pass"));
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "api_utils.h"
+
+RqInterProgram* compile_inter(int K, uint32_t first, int n)
+{
+	size_t workSize, progSize;
+	if (RqInterGetMemSizes(K, n - K, &workSize, &progSize, NULL) != 0)
+		return NULL;
+	RqInterWorkMem* work = malloc(workSize);
+	RqInterProgram* prog = malloc(progSize);
+	if (RqInterInit(K, n - K, work, workSize) != 0
+	  || RqInterAddIds(work, first, n) != 0
+	  || RqInterCompile(work, prog, progSize) != 0) {
+		free(prog);
+		prog = NULL;
+	}
+	free(work);
+	return prog;
+}
+
+RqOutProgram* compile_out(int K, uint32_t first, int n)
+{
+	size_t workSize, progSize;
+	if (RqOutGetMemSizes(n, &workSize, &progSize) != 0)
+		return NULL;
+	RqOutWorkMem* work = malloc(workSize);
+	RqOutProgram* prog = malloc(progSize);
+	if (RqOutInit(K, work, workSize) != 0
+	  || RqOutAddIds(work, first, n) != 0
+	  || RqOutCompile(work, prog, progSize) != 0) {
+		free(prog);
+		prog = NULL;
+	}
+	free(work);
+	return prog;
+}
+
+bool encode(int K, int nSyms, size_t dwidth, const uint8_t* src,
+			uint8_t* ib, uint8_t* syms)
+{
+	size_t interSymNum;
+	RqInterGetMemSizes(K, 0, NULL, NULL, &interSymNum);
+	RqInterProgram* prog = compile_inter(K, 0, K);
+	RqOutProgram* outProg = compile_out(K, 0, nSyms);
+	uint8_t* ib_own = (ib == NULL) ? malloc(interSymNum * dwidth) : NULL;
+	if (ib == NULL)
+		ib = ib_own;
+	const bool success = prog != NULL && outProg != NULL
+		&& RqInterExecute(prog, dwidth, src, K * dwidth,
+				ib, interSymNum * dwidth) == 0
+		&& RqOutExecute(outProg, dwidth, ib,
+				syms, nSyms * dwidth) == 0;
+	free(prog);
+	free(outProg);
+	free(ib_own);
+	return success;
+}
+
+bool same_result(int K, int n, size_t dwidth, const RqInterProgram* p1,
+			const RqInterProgram* p2)
+{
+	size_t interSymNum;
+	RqInterGetMemSizes(K, n - K, NULL, NULL, &interSymNum);
+	uint8_t* syms = malloc(n * dwidth);
+	uint8_t* ib1 = malloc(interSymNum * dwidth);
+	uint8_t* ib2 = malloc(interSymNum * dwidth);
+	for (size_t i = 0; i < n * dwidth; ++i)
+		syms[i] = rand() & 0xff;
+	const bool same =
+		RqInterExecute(p1, dwidth, syms, n * dwidth,
+				ib1, interSymNum * dwidth) == 0
+		&& RqInterExecute(p2, dwidth, syms, n * dwidth,
+				ib2, interSymNum * dwidth) == 0
+		&& memcmp(ib1, ib2, interSymNum * dwidth) == 0;
+	free(syms);
+	free(ib1);
+	free(ib2);
+	return same;
+}
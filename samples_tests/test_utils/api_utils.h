@@ -0,0 +1,41 @@
+#ifndef API_UTILS_H
+#define API_UTILS_H
+
+/**	@file api_utils.h
+ *
+ *	Helpers of the API tests.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rq_api.h"
+
+/**	Compile an intermediate block program for the ESIs first, ...,
+ *	first + n - 1.
+ *
+ *	@return		The program, to be freed, or NULL on failure.
+ */
+RqInterProgram* compile_inter(int K, uint32_t first, int n);
+
+/**	Compile an output program for the ESIs first, ..., first + n - 1.
+ *
+ *	@return		The program, to be freed, or NULL on failure.
+ */
+RqOutProgram* compile_out(int K, uint32_t first, int n);
+
+/**	Encode:  Compute the intermediate block for the source symbols
+ *	src into ib, unless ib is NULL, and the symbols with the ESIs 0,
+ *	..., nSyms-1 into syms.
+ */
+bool encode(int K, int nSyms, size_t dwidth, const uint8_t* src,
+			uint8_t* ib, uint8_t* syms);
+
+/**	Check that two programs for n ESIs compute the same intermediate
+ *	block from the same random symbols of dwidth bytes.
+ */
+bool same_result(int K, int n, size_t dwidth, const RqInterProgram* p1,
+			const RqInterProgram* p2);
+
+#endif /* API_UTILS_H */
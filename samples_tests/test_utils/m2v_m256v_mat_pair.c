@@ -54,7 +54,7 @@ bool run_mat_pair_test(mat_pair_test testfunc)
 	static const int nrow_arr[] = { 17, 41 };
 	for (int i = 0; i < array_size(nrow_arr); ++i) {
 		const int nrow = nrow_arr[i];
-		static const int ncol_arr[] = { 7, 15, 32, 33, 99 };
+		static const int ncol_arr[] = { 7, 15, 32, 33, 64, 99, 600 };
 		for (int j = 0; j < array_size(ncol_arr); ++j) {
 			const int ncol = ncol_arr[j];
 			m256v Ml;
@@ -77,6 +77,7 @@ void clobber_m2v(m2v* M)
 {
 	const int n_word = M->n_row * M->row_stride;
 	for (int i = 0; i < n_word; ++i) {
-		M->e[i] = rand();
+		M->e[i] = ((m2v_base)rand() << 62) ^ ((m2v_base)rand() << 31)
+			^ (m2v_base)rand();
 	}
 }
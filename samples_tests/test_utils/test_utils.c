@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -55,3 +56,35 @@ void get_esis_after_loss(int nESIs, uint32_t* ESIs, float loss)
 		ESIs[j] = esi;
 	}
 }
+
+typedef struct {
+	par_task_fn fn;
+	void* arg;
+	int i;
+} test_task;
+
+static void* test_task_main(void* p)
+{
+	const test_task* task = p;
+	task->fn(task->arg, task->i);
+	return NULL;
+}
+
+/* Runner for the algebra routines that starts a thread per task. */
+void test_par_run(int n_tasks, par_task_fn fn, void* arg)
+{
+	pthread_t threads[n_tasks];
+	test_task tasks[n_tasks];
+	for (int i = 0; i < n_tasks; ++i) {
+		tasks[i] = (test_task){ .fn = fn, .arg = arg, .i = i };
+		if (i > 0 && pthread_create(&threads[i], NULL,
+					test_task_main, &tasks[i]) != 0)
+		{
+			fprintf(stderr, "Error:  Could not start a thread.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	fn(arg, 0);
+	for (int i = 1; i < n_tasks; ++i)
+		pthread_join(threads[i], NULL);
+}
@@ -3,6 +3,8 @@
 
 #include <inttypes.h>
 
+#include "par_run.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -16,6 +18,9 @@ void get_random_esis(int nESIs, uint32_t* ESIs);
  */
 void get_esis_after_loss(int nESIs, uint32_t* ESIs, float loss);
 
+/* Runner for the algebra routines that starts a thread per task. */
+void test_par_run(int n_tasks, par_task_fn fn, void* arg);
+
 #ifdef __cplusplus
 }
 #endif
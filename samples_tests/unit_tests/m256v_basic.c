@@ -251,7 +251,7 @@ static bool test_permute_rows()
 
 static bool test_permute_cols()
 {
-	const int rowscols[] = { 1, 2, 3, 5, 8, 10, 15 };
+	const int rowscols[] = { 1, 2, 3, 5, 8, 10, 15, 16, 17, 33, 100 };
 	for (int i = 0; i < array_size(rowscols); ++i) {
 		const int rc = rowscols[i];
 
@@ -286,6 +286,61 @@ static bool test_permute_cols()
 	return true;
 }
 
+/* Check the blocked transpose against element access, on a subview
+ * so that the row stride differs from the width.
+ */
+static bool test_transpose()
+{
+	const int dims[] = { 1, 7, 15, 16, 17, 32, 45, 70 };
+	for (int i = 0; i < array_size(dims); ++i) {
+		for (int j = 0; j < array_size(dims); ++j) {
+			const int nr = dims[i], nc = dims[j];
+			Def_mat256_rand(A0, a0, nr + 1, nc + 3, 0xff)
+			const m256v A = m256v_get_subview(&A0, 1, 2, nr, nc);
+			m256v_Def(T, t, nc, nr)
+			m256v_transpose(&A, &T);
+			for (int r = 0; r < nr; ++r) {
+				for (int c = 0; c < nc; ++c) {
+					if (m256v_get_el(&T, c, r)
+					  != m256v_get_el(&A, r, c))
+						return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static bool test_mult_cols()
+{
+	const int dims[] = { 1, 15, 16, 17, 50 };
+	for (int i = 0; i < array_size(dims); ++i) {
+		for (int j = 0; j < array_size(dims); ++j) {
+			const int nr = dims[i], nc = dims[j];
+			Def_mat256_rand(A0, a0, nr, nc + 5, 0xff)
+			m256v A = m256v_get_subview(&A0, 0, 3, nr, nc);
+			m256v_Def(R, ref, nr, nc + 5)
+			memcpy(ref, a0, sizeof(a0));
+
+			/* Some tiles are left alone (all alpha 1) */
+			uint8_t alphas[nc];
+			for (int c = 0; c < nc; ++c)
+				alphas[c] = (c / 16 % 2) ? rand() : 1;
+			for (int r = 0; r < nr; ++r) {
+				for (int c = 0; c < nc; ++c) {
+					m256v_set_el(&R, r, c + 3, gf256_mul(
+					  alphas[c], m256v_get_el(&R, r, c + 3)));
+				}
+			}
+
+			m256v_mult_cols(&A, alphas);
+			if (memcmp(a0, ref, sizeof(a0)) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
 static bool test_add()
 {
 	/* Hard coded addition */
@@ -397,6 +452,68 @@ static bool test_mul()
 	return true;
 }
 
+/* Check m256v_mul_add against an element-wise reference.
+ *
+ * The sizes are chosen such that the blocking over the inner dimension
+ * and over the columns both have ragged edges.
+ */
+static bool test_mul_add_x(int n_row, int n_inner, int n_col, uint8_t mask)
+{
+	uint8_t* a = malloc(n_row * n_inner);
+	uint8_t* b = malloc(n_inner * n_col);
+	uint8_t* c = malloc(n_row * n_col);
+	uint8_t* ref = malloc(n_row * n_col);
+	rand_coeffs(a, n_row * n_inner, mask);
+	rand_coeffs(b, n_inner * n_col, 0xff);
+	rand_coeffs(c, n_row * n_col, 0xff);
+	m256v A = m256v_make(n_row, n_inner, a);
+	m256v B = m256v_make(n_inner, n_col, b);
+	m256v C = m256v_make(n_row, n_col, c);
+
+	for (int i = 0; i < n_row; ++i) {
+		for (int j = 0; j < n_col; ++j) {
+			uint8_t x = c[i * n_col + j];
+			for (int e = 0; e < n_inner; ++e) {
+				x = fadd(x, fmul(a[i * n_inner + e],
+						 b[e * n_col + j]));
+			}
+			ref[i * n_col + j] = x;
+		}
+	}
+
+	m256v_mul_add(&A, &B, &C);
+	const bool success = (memcmp(c, ref, n_row * n_col) == 0);
+	if (!success) {
+		fprintf(stderr, "%s:%d:  m256v_mul_add mismatch "
+		  "(%dx%d * %dx%d)\n", __FILE__, __LINE__,
+		  n_row, n_inner, n_inner, n_col);
+	}
+
+	free(ref);
+	free(c);
+	free(b);
+	free(a);
+	return success;
+}
+
+static bool test_mul_add()
+{
+	if (!test_mul_add_x(1, 1, 1, 0xff))
+		return false;
+	if (!test_mul_add_x(17, 70, 33, 0xff))
+		return false;
+	if (!test_mul_add_x(5, 100, 4100, 0xff))
+		return false;
+	if (!test_mul_add_x(40, 65, 200, 0x01))
+		return false;
+	for (int i = 0; i < 100; ++i) {
+		if (!test_mul_add_x(1 + rand() % 40, 1 + rand() % 80,
+					1 + rand() % 150, 0xff))
+			return false;
+	}
+	return true;
+}
+
 static void usage()
 {
 	puts(	"Tests for basic m256v functionality.\n"
@@ -447,10 +564,13 @@ int main(int argc, char** argv)
 	RUN_TEST(test_copy());
 	RUN_TEST(test_permute_rows());
 	RUN_TEST(test_permute_cols());
+	RUN_TEST(test_transpose());
+	RUN_TEST(test_mult_cols());
 	RUN_TEST(test_add());
 	RUN_TEST(test_add_inplace());
 	RUN_TEST(test_mul0());
 	RUN_TEST(test_mul());
+	RUN_TEST(test_mul_add());
 #undef RUN_TEST
 
 	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
@@ -0,0 +1,319 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "gf256.h"
+#include "m256v.h"
+#include "m256v_kern.h"
+
+#include "utils.h"
+
+#define MAX_LEN		300
+#define MAX_OFFS	67
+
+/* Check a kernel set's multadd against gf256_mul.
+ *
+ * Lengths, alignments and multipliers are varied so that the vector
+ * main loops as well as the tail handling are exercised.
+ */
+static bool test_multadd(const m256v_kern* k)
+{
+	uint8_t s[MAX_OFFS + MAX_LEN], t[MAX_OFFS + MAX_LEN];
+	uint8_t ref[MAX_OFFS + MAX_LEN];
+	for (int alpha = 0; alpha < 256; ++alpha) {
+		for (int it = 0; it < 20; ++it) {
+			const int n = rand() % MAX_LEN;
+			const int so = rand() % MAX_OFFS;
+			const int to = rand() % MAX_OFFS;
+			rand_arr(s, 0xff);
+			rand_arr(t, 0xff);
+			memcpy(ref, t, sizeof(t));
+			for (int i = 0; i < n; ++i)
+				ref[to + i] ^= gf256_mul(alpha, s[so + i]);
+
+			k->multadd(t + to, s + so, n, alpha);
+			if (memcmp(t, ref, sizeof(t)) != 0) {
+				fprintf(stderr, "  %s: multadd mismatch for "
+				  "alpha=%d, n=%d, so=%d, to=%d\n",
+				  k->name, alpha, n, so, to);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Same as test_multadd, but with source and target identical. */
+static bool test_multadd_alias(const m256v_kern* k)
+{
+	uint8_t t[MAX_LEN], ref[MAX_LEN];
+	for (int alpha = 0; alpha < 256; ++alpha) {
+		const int n = rand() % MAX_LEN;
+		rand_arr(t, 0xff);
+		memcpy(ref, t, sizeof(t));
+		for (int i = 0; i < n; ++i)
+			ref[i] ^= gf256_mul(alpha, ref[i]);
+
+		k->multadd(t, t, n, alpha);
+		if (memcmp(t, ref, sizeof(t)) != 0) {
+			fprintf(stderr, "  %s: aliased multadd mismatch for "
+			  "alpha=%d, n=%d\n", k->name, alpha, n);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool test_mult(const m256v_kern* k)
+{
+	uint8_t t[MAX_OFFS + MAX_LEN], ref[MAX_OFFS + MAX_LEN];
+	for (int alpha = 0; alpha < 256; ++alpha) {
+		for (int it = 0; it < 20; ++it) {
+			const int n = rand() % MAX_LEN;
+			const int to = rand() % MAX_OFFS;
+			rand_arr(t, 0xff);
+			memcpy(ref, t, sizeof(t));
+			for (int i = 0; i < n; ++i)
+				ref[to + i] = gf256_mul(alpha, ref[to + i]);
+
+			k->mult(t + to, n, alpha);
+			if (memcmp(t, ref, sizeof(t)) != 0) {
+				fprintf(stderr, "  %s: mult mismatch for "
+				  "alpha=%d, n=%d, to=%d\n",
+				  k->name, alpha, n, to);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Check multadd_multi against a sequence of gf256_mul sums.
+ *
+ * Source rows are taken from a common buffer at random offsets, so
+ * that sources may overlap each other (but never the target).
+ */
+static bool test_multadd_multi(const m256v_kern* k)
+{
+	enum { max_k = 40 };
+	uint8_t src[MAX_OFFS + MAX_LEN];
+	uint8_t t[MAX_OFFS + MAX_LEN], ref[MAX_OFFS + MAX_LEN];
+	for (int it = 0; it < 2000; ++it) {
+		const int n = rand() % MAX_LEN;
+		const int nsrc = rand() % max_k;
+		const int to = rand() % MAX_OFFS;
+		const uint8_t* s[max_k];
+		uint8_t alpha[max_k];
+		rand_arr(src, 0xff);
+		rand_arr(t, 0xff);
+		memcpy(ref, t, sizeof(t));
+		for (int j = 0; j < nsrc; ++j) {
+			s[j] = src + rand() % MAX_OFFS;
+			alpha[j] = rand();
+			for (int i = 0; i < n; ++i)
+				ref[to + i] ^= gf256_mul(alpha[j], s[j][i]);
+		}
+
+		k->multadd_multi(t + to, s, alpha, nsrc, n);
+		if (memcmp(t, ref, sizeof(t)) != 0) {
+			fprintf(stderr, "  %s: multadd_multi mismatch for "
+			  "k=%d, n=%d, to=%d\n", k->name, nsrc, n, to);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Check m256v_multadd_rows against repeated m256v_multadd_row. */
+static bool test_multadd_rows(const m256v_kern* k)
+{
+	const m256v_kern* prev = m256v_kern_active;
+	m256v_kern_active = k;
+
+	bool success = true;
+	const int n_row = 50, n_col = 77;
+	for (int it = 0; it < 200 && success; ++it) {
+		Def_mat256_rand(A, a, n_row, n_col, 0xff)
+		m256v_Def(R, ref, n_row, n_col)
+		memcpy(ref, a, sizeof(a));
+
+		/* More terms than the batch size, including repeated
+		 * rows and zero coefficients.
+		 */
+		const int rt = rand() % n_row;
+		const int n = rand() % 80;
+		int rows[80];
+		uint8_t alphas[80];
+		for (int j = 0; j < n; ++j) {
+			rows[j] = rand() % n_row;
+			if (rows[j] == rt)
+				rows[j] = (rt + 1) % n_row;
+			alphas[j] = (rand() % 4 == 0) ? 0 : rand();
+			m256v_multadd_row(&R, rows[j], alphas[j], &R, rt);
+		}
+
+		m256v_multadd_rows(&A, rows, alphas, n, &A, rt);
+		if (memcmp(a, ref, sizeof(a)) != 0) {
+			fprintf(stderr, "  %s: m256v_multadd_rows mismatch "
+			  "for n=%d\n", k->name, n);
+			success = false;
+		}
+	}
+
+	m256v_kern_active = prev;
+	return success;
+}
+
+/* Check m256v_multadd_row_from with the given kernel active. */
+static bool test_multadd_row_from(const m256v_kern* k)
+{
+	const m256v_kern* prev = m256v_kern_active;
+	m256v_kern_active = k;
+
+	bool success = true;
+	const int n_col = 131;
+	for (int it = 0; it < 1000 && success; ++it) {
+		Def_mat256_rand(A, a, 2, n_col, 0xff)
+		m256v_Def(R, ref, 2, n_col)
+		memcpy(ref, a, sizeof(a));
+
+		const int offs = rand() % n_col;
+		const uint8_t alpha = rand();
+		for (int c = offs; c < n_col; ++c) {
+			m256v_set_el(&R, 1, c, gf256_add(m256v_get_el(&R, 1, c),
+			  gf256_mul(alpha, m256v_get_el(&R, 0, c))));
+		}
+
+		m256v_multadd_row_from(&A, 0, offs, alpha, &A, 1);
+		if (memcmp(a, ref, sizeof(a)) != 0) {
+			fprintf(stderr, "  %s: m256v_multadd_row_from "
+			  "mismatch for offs=%d, alpha=%d\n",
+			  k->name, offs, (int)alpha);
+			success = false;
+		}
+	}
+
+	m256v_kern_active = prev;
+	return success;
+}
+
+/* Check m256v_mult_col_from with the given kernel active.
+ *
+ * The matrix is taller than the gather buffer so that more than one
+ * chunk is processed.
+ */
+static bool test_mult_col_from(const m256v_kern* k)
+{
+	const m256v_kern* prev = m256v_kern_active;
+	m256v_kern_active = k;
+
+	bool success = true;
+	const int n_row = 601, n_col = 3;
+	for (int it = 0; it < 200 && success; ++it) {
+		Def_mat256_rand(A, a, n_row, n_col, 0xff)
+		m256v_Def(R, ref, n_row, n_col)
+		memcpy(ref, a, sizeof(a));
+
+		const int c = rand() % n_col;
+		const int offs = rand() % n_row;
+		const uint8_t alpha = rand();
+		for (int r = offs; r < n_row; ++r) {
+			m256v_set_el(&R, r, c,
+			  gf256_mul(alpha, m256v_get_el(&R, r, c)));
+		}
+
+		m256v_mult_col_from(&A, c, offs, alpha);
+		if (memcmp(a, ref, sizeof(a)) != 0) {
+			fprintf(stderr, "  %s: m256v_mult_col_from "
+			  "mismatch for c=%d, offs=%d, alpha=%d\n",
+			  k->name, c, offs, (int)alpha);
+			success = false;
+		}
+	}
+
+	m256v_kern_active = prev;
+	return success;
+}
+
+/* Check the built-in self test accepts the kernel set. */
+static bool test_selftest(const m256v_kern* k)
+{
+	if (!m256v_kern_selftest(k)) {
+		fprintf(stderr, "  %s: self test failed\n", k->name);
+		return false;
+	}
+	return true;
+}
+
+static bool test_all_kernels(bool (*testfunc)(const m256v_kern*))
+{
+	bool success = true;
+	const m256v_kern* k;
+	for (int i = 0; (k = m256v_kern_get_nth(i)) != NULL; ++i) {
+		if (!testfunc(k))
+			success = false;
+	}
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Tests for the GF(256) row operation kernels.\n"
+		"\n"
+		"All kernel sets supported by the CPU are checked.\n"
+		"\n"
+		"  -h   Display this help screen.\n"
+		);
+}
+
+int main(int argc, char** argv)
+{
+	/* Read cmdline args */
+	int c;
+	while ((c = getopt(argc, argv, "h")) != -1) {
+		switch(c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	printf("Active kernel set: %s\n", m256v_kern_active->name);
+	printf("Supported kernel sets:");
+	const m256v_kern* k;
+	for (int i = 0; (k = m256v_kern_get_nth(i)) != NULL; ++i)
+		printf(" %s", k->name);
+	printf("\n");
+
+	int nfail = 0;
+#define RUN_TEST(x) \
+	do { \
+		printf("Running: " #x "\n"); \
+		if (!x) { \
+			printf("--> FAIL (test " #x ")\n"); \
+			++nfail; \
+		} else { \
+			printf("--> pass\n"); \
+		} \
+	} while(0)
+
+	RUN_TEST(test_all_kernels(test_multadd));
+	RUN_TEST(test_all_kernels(test_multadd_alias));
+	RUN_TEST(test_all_kernels(test_mult));
+	RUN_TEST(test_all_kernels(test_multadd_multi));
+	RUN_TEST(test_all_kernels(test_multadd_row_from));
+	RUN_TEST(test_all_kernels(test_multadd_rows));
+	RUN_TEST(test_all_kernels(test_mult_col_from));
+	RUN_TEST(test_all_kernels(test_selftest));
+#undef RUN_TEST
+
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -8,6 +8,7 @@
 #include "gf256.h"
 #include "m256v.h"
 #include "perm.h"
+#include "test_utils.h"
 
 #include "utils.h"
 
@@ -371,6 +372,157 @@ static bool test_lu_invmul()
 	return true;
 }
 
+/* Compare m256v_LU_decomp_inplace with the reference implementation.
+ *
+ * The blocked decomposition only kicks in for larger matrices, and
+ * must give bit-identical results, including the permutations.  Low
+ * rank matrices and zero columns are used to exercise the cases where
+ * a panel runs out of pivots.
+ */
+static bool test_lu_blocked_x(int n_row, int n_col, int rank, int n_zcol,
+				int field)
+{
+	const uint8_t mask = get_mask(field);
+
+	/* A = B * C is of rank at most `rank' */
+	Def_mat256_rand(B, b, n_row, rank, mask)
+	Def_mat256_rand(C, c, rank, n_col, mask)
+	m256v_Def(A, a, n_row, n_col)
+	m256v_mul(&B, &C, &A);
+	for (int i = 0; i < n_zcol; ++i) {
+		const int zc = rand() % n_col;
+		for (int r = 0; r < n_row; ++r)
+			m256v_set_el(&A, r, zc, 0);
+	}
+
+	m256v_Def(A_ref, a_ref, n_row, n_col)
+	memcpy(a_ref, a, sizeof(a));
+	m256v_Def(A_mt, a_mt, n_row, n_col)
+	memcpy(a_mt, a, sizeof(a));
+
+	int rp[n_row], cp[n_col];
+	int rp_ref[n_row], cp_ref[n_col];
+	const int r1 = m256v_LU_decomp_inplace(&A, rp, cp);
+	const int r2 = m256v_LU_decomp_inplace_basic(&A_ref, rp_ref, cp_ref);
+	if (r1 != r2
+	  || memcmp(rp, rp_ref, sizeof(rp)) != 0
+	  || memcmp(cp, cp_ref, sizeof(cp)) != 0
+	  || memcmp(a, a_ref, sizeof(a)) != 0)
+	{
+		fprintf(stderr, "Error:  Blocked LU differs from reference "
+		  "(n_row=%d, n_col=%d, rank=%d/%d, n_zcol=%d, field=%d)\n",
+		  n_row, n_col, r1, r2, n_zcol, field);
+		return false;
+	}
+
+	/* Multithreaded version */
+	const int n_threads = 3;
+	const int r3 = m256v_LU_decomp_inplace_mt(&A_mt, rp, cp, n_threads,
+							test_par_run);
+	if (r3 != r2
+	  || memcmp(rp, rp_ref, sizeof(rp)) != 0
+	  || memcmp(cp, cp_ref, sizeof(cp)) != 0
+	  || memcmp(a_mt, a_ref, sizeof(a)) != 0)
+	{
+		fprintf(stderr, "Error:  Multithreaded LU differs from "
+		  "reference (n_row=%d, n_col=%d, rank=%d/%d, n_zcol=%d, "
+		  "field=%d)\n", n_row, n_col, r3, r2, n_zcol, field);
+		return false;
+	}
+
+	return true;
+}
+
+static bool test_lu_blocked()
+{
+	const int shapes[][2] = {
+		{ 64, 64 }, { 100, 100 }, { 150, 90 }, { 90, 150 },
+		{ 200, 200 }, { 257, 250 },
+	};
+	for (int i = 0; i < array_size(shapes); ++i) {
+		const int n_row = shapes[i][0];
+		const int n_col = shapes[i][1];
+		const int n = (n_row < n_col ? n_row : n_col);
+		const int ranks[] = { n, n - 1, n / 2, 33 };
+		for (int j = 0; j < array_size(ranks); ++j) {
+			for (int n_zcol = 0; n_zcol < 6; n_zcol += 5) {
+				if (!test_lu_blocked_x(n_row, n_col,
+						ranks[j], n_zcol, 256))
+					return false;
+				if (!test_lu_blocked_x(n_row, n_col,
+						ranks[j], n_zcol, 2))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Decompose the first n_old rows, append the others with
+ * m256v_LU_decomp_append, and check the result against A*X and the
+ * rank of the whole matrix.
+ */
+static bool test_lu_append_x(int n_row, int n_col, int n_old, int rank,
+				int field)
+{
+	const uint8_t mask = get_mask(field);
+	const int dlen = 8;
+
+	/* A = B * C is of rank at most `rank' */
+	Def_mat256_rand(B, b, n_row, rank, mask)
+	Def_mat256_rand(C, c, rank, n_col, mask)
+	m256v_Def(A, a, n_row, n_col)
+	m256v_mul(&B, &C, &A);
+	Def_mat256_rand(X, x, n_col, dlen, mask)
+	m256v_Def(Y1, y1, n_row, dlen)
+	m256v_mul(&A, &X, &Y1);
+
+	m256v_Def(A_ref, a_ref, n_row, n_col)
+	memcpy(a_ref, a, sizeof(a));
+	int rp[n_row], cp[n_col];
+	const int r_ref = m256v_LU_decomp_inplace_basic(&A_ref, rp, cp);
+
+	m256v_Def(LU, lu, n_row, n_col)
+	memcpy(lu, a, sizeof(a));
+	m256v Old = m256v_get_subview(&LU, 0, 0, n_old, n_col);
+	const int r_old = m256v_LU_decomp_inplace(&Old, rp, cp);
+	const int r = m256v_LU_decomp_append(&LU, n_old, r_old, rp, cp);
+
+	m256v_Def(Y2, y2, n_row, dlen)
+	m256v_LU_mult(&LU, rp, cp, &X, &Y2);
+	if (r != r_ref || memcmp(y1, y2, sizeof(y1)) != 0) {
+		fprintf(stderr, "Error:  Appended LU wrong (n_row=%d, "
+		  "n_col=%d, n_old=%d, rank=%d/%d, field=%d)\n",
+		  n_row, n_col, n_old, r, r_ref, field);
+		return false;
+	}
+	return true;
+}
+
+static bool test_lu_append()
+{
+	const int shapes[][3] = {
+		{ 10, 10, 7 }, { 40, 30, 25 }, { 100, 100, 90 },
+		{ 150, 90, 60 }, { 90, 150, 80 },
+	};
+	for (int i = 0; i < array_size(shapes); ++i) {
+		const int n_row = shapes[i][0];
+		const int n_col = shapes[i][1];
+		const int n_old = shapes[i][2];
+		const int n = (n_row < n_col ? n_row : n_col);
+		const int ranks[] = { n, n - 1, n / 2 };
+		for (int j = 0; j < array_size(ranks); ++j) {
+			if (!test_lu_append_x(n_row, n_col, n_old,
+						ranks[j], 256)
+			  || !test_lu_append_x(n_row, n_col, n_old,
+						ranks[j], 2))
+				return false;
+		}
+	}
+	return true;
+}
+
 static void usage()
 {
 	puts(	"LU wide implementation tester.\n"
@@ -412,6 +564,8 @@ int main(int argc, char** argv)
 	RUN_TEST(test_lu(256));
 	RUN_TEST(test_lu_mul());
 	RUN_TEST(test_lu_invmul());
+	RUN_TEST(test_lu_blocked());
+	RUN_TEST(test_lu_append());
 #undef RUN_TEST
 
 	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
@@ -139,6 +139,29 @@ static bool mptest_multadd_row_from(int nrow, int ncol, m256v* Ml, m2v* Ms)
 	return true;
 }
 
+static bool mptest_multadd_rows(int nrow, int ncol, m256v* Ml, m2v* Ms)
+{
+	for (int i = 0; i < 8; ++i) {
+		const int rt = rand() % nrow;
+		const int n = rand() % nrow;
+		int rows[n > 0 ? n : 1];
+		uint8_t alphas_l[n > 0 ? n : 1];
+		int alphas_s[n > 0 ? n : 1];
+		for (int j = 0; j < n; ++j) {
+			rows[j] = rand() % nrow;
+			if (rows[j] == rt)
+				rows[j] = (rt + 1) % nrow;
+			alphas_l[j] = alphas_s[j] = rand() & 1;
+		}
+		if (nrow == 1)
+			continue;
+
+		m256v_multadd_rows(Ml, rows, alphas_l, n, Ml, rt);
+		m2v_multadd_rows(Ms, rows, alphas_s, n, Ms, rt);
+	}
+	return true;
+}
+
 static bool mptest_copy_row(int nrow, int ncol, m256v* Ml, m2v* Ms)
 {
 	for (int i = 0; i < 10; ++i) {
@@ -167,6 +190,24 @@ static bool mptest_row_iszero(int nrow, int ncol, m256v* Ml, m2v* Ms)
 	return true;
 }
 
+static bool mptest_row_weight(int nrow, int ncol, m256v* Ml, m2v* Ms)
+{
+	for (int i = 0; i < nrow/2; ++i) {
+		const int r = rand() % nrow;
+		m2v_clear_row(Ms, r);
+		m256v_clear_row(Ml, r);
+	}
+
+	for (int r = 0; r < nrow; ++r) {
+		int w = 0;
+		for (int c = 0; c < ncol; ++c)
+			w += m256v_get_el(Ml, r, c);
+		if (m2v_row_weight(Ms, r) != w)
+			return false;
+	}
+	return true;
+}
+
 static bool mptest_swap_cols(int nrow, int ncol, m256v* Ml, m2v* Ms)
 {
 	for (int i = 0; i < ncol/3; ++i) {
@@ -296,6 +337,79 @@ static bool mptest_permute_cols(int nrow, int ncol, m256v* Ml, m2v* Ms)
 	return true;
 }
 
+static bool mptest_mult_cols(int nrow, int ncol, m256v* Ml, m2v* Ms)
+{
+	int alphas_s[ncol];
+	uint8_t alphas_l[ncol];
+	for (int c = 0; c < ncol; ++c)
+		alphas_s[c] = alphas_l[c] = rand() & 1;
+	m2v_mult_cols(Ms, alphas_s);
+	m256v_mult_cols(Ml, alphas_l);
+	return true;
+}
+
+/* Transposes and column permutations of matrices with more than one
+ * 64 x 64 block in either direction.
+ */
+static bool test_transpose()
+{
+	const int dims[] = { 1, 63, 64, 65, 130, 200 };
+	for (int i = 0; i < array_size(dims); ++i) {
+		for (int j = 0; j < array_size(dims); ++j) {
+			const int nr = dims[i], nc = dims[j];
+			m256v Al, Tl;
+			m2v As, Ts;
+			get_mat_pair(nr, nc, &Al, &As);
+			get_mat_pair(nc, nr, &Tl, &Ts);
+			clobber_m2v(&Ts);
+
+			m2v_transpose(&As, &Ts);
+			m256v_transpose(&Al, &Tl);
+			bool succ = check_mat_pair_equal(&Tl, &Ts);
+
+			int p[nc];
+			perm_rand(nc, p);
+			m2v_permute_cols(&As, p);
+			m256v_permute_cols(&Al, p);
+			succ = succ && check_mat_pair_equal(&Al, &As);
+
+			free_mat_pair_mem(&Al, &As);
+			free_mat_pair_mem(&Tl, &Ts);
+			if (!succ)
+				return false;
+		}
+	}
+	return true;
+}
+
+/* Column operations on matrices too wide for the tiled column
+ * permutations' buffers
+ */
+static bool test_wide_col_ops()
+{
+	const int nr = 70, nc = 9000;
+	m256v Al;
+	m2v As;
+	get_mat_pair(nr, nc, &Al, &As);
+
+	int p[nc];
+	perm_rand(nc, p);
+	m2v_permute_cols(&As, p);
+	m256v_permute_cols(&Al, p);
+	bool succ = check_mat_pair_equal(&Al, &As);
+
+	int alphas_s[nc];
+	uint8_t alphas_l[nc];
+	for (int c = 0; c < nc; ++c)
+		alphas_s[c] = alphas_l[c] = (c < 5000) || (rand() & 1);
+	m2v_mult_cols(&As, alphas_s);
+	m256v_mult_cols(&Al, alphas_l);
+	succ = succ && check_mat_pair_equal(&Al, &As);
+
+	free_mat_pair_mem(&Al, &As);
+	return succ;
+}
+
 static bool test_add()
 {
 	for (int n_row = 10; n_row < 50; n_row = n_row * 17/10) {
@@ -442,8 +556,10 @@ int main(int argc, char** argv)
 	RUN_TEST(run_mat_pair_test(mptest_clear_row));
 	RUN_TEST(run_mat_pair_test(mptest_multadd_row));
 	RUN_TEST(run_mat_pair_test(mptest_multadd_row_from));
+	RUN_TEST(run_mat_pair_test(mptest_multadd_rows));
 	RUN_TEST(run_mat_pair_test(mptest_copy_row));
 	RUN_TEST(run_mat_pair_test(mptest_row_iszero));
+	RUN_TEST(run_mat_pair_test(mptest_row_weight));
 	RUN_TEST(run_mat_pair_test(mptest_swap_cols));
 	RUN_TEST(run_mat_pair_test(mptest_mult_col_from));
 	RUN_TEST(run_mat_pair_test(mptest_copy_col));
@@ -454,6 +570,9 @@ int main(int argc, char** argv)
 	RUN_TEST(test_copy());
 	RUN_TEST(run_mat_pair_test(mptest_permute_rows));
 	RUN_TEST(run_mat_pair_test(mptest_permute_cols));
+	RUN_TEST(run_mat_pair_test(mptest_mult_cols));
+	RUN_TEST(test_transpose());
+	RUN_TEST(test_wide_col_ops());
 	RUN_TEST(test_add());
 	RUN_TEST(test_add_inplace());
 	RUN_TEST(test_mul());
@@ -0,0 +1,243 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "m256v.h"
+#include "m2v.h"
+#include "m2v_kern.h"
+
+#include "m2v_m256v_mat_pair.h"
+
+#define MAX_LEN		100
+#define MAX_OFFS	17
+
+static void rand_words(m2v_base* w, int n)
+{
+	for (int i = 0; i < n; ++i) {
+		w[i] = ((m2v_base)rand() << 62) ^ ((m2v_base)rand() << 31)
+			^ (m2v_base)rand();
+	}
+}
+
+/* Check a kernel set against the scalar one.
+ *
+ * Lengths and offsets are varied so that the vector main loops as
+ * well as the tail handling are exercised.  The words around the
+ * target range must be left alone.
+ */
+static bool test_against_scalar(const m2v_kern* k)
+{
+	const m2v_kern* ref_k = &m2v_kern_scalar;
+	m2v_base s[4][MAX_OFFS + MAX_LEN];
+	m2v_base t[MAX_OFFS + MAX_LEN], ref[MAX_OFFS + MAX_LEN];
+	m2v_base t2[MAX_OFFS + MAX_LEN], ref2[MAX_OFFS + MAX_LEN];
+	for (int it = 0; it < 2000; ++it) {
+		const int n = rand() % MAX_LEN;
+		const int so = rand() % MAX_OFFS;
+		const int to = rand() % MAX_OFFS;
+		for (int j = 0; j < 4; ++j)
+			rand_words(s[j], MAX_OFFS + MAX_LEN);
+		rand_words(t, MAX_OFFS + MAX_LEN);
+		rand_words(t2, MAX_OFFS + MAX_LEN);
+
+		memcpy(ref, t, sizeof(t));
+		k->add(t + to, s[0] + so, n);
+		ref_k->add(ref + to, s[0] + so, n);
+		if (memcmp(t, ref, sizeof(t)) != 0) {
+			fprintf(stderr, "  %s: add mismatch for n=%d, so=%d, "
+			  "to=%d\n", k->name, n, so, to);
+			return false;
+		}
+
+		const int nsrc = rand() % 5;
+		const m2v_base* srcs[4];
+		for (int j = 0; j < nsrc; ++j)
+			srcs[j] = s[rand() % 4] + rand() % MAX_OFFS;
+		k->add_multi(t + to, srcs, nsrc, n);
+		ref_k->add_multi(ref + to, srcs, nsrc, n);
+		if (memcmp(t, ref, sizeof(t)) != 0) {
+			fprintf(stderr, "  %s: add_multi mismatch for k=%d, "
+			  "n=%d, to=%d\n", k->name, nsrc, n, to);
+			return false;
+		}
+
+		memcpy(ref2, t2, sizeof(t2));
+		k->swap(t + to, t2 + so, n);
+		ref_k->swap(ref + to, ref2 + so, n);
+		if (memcmp(t, ref, sizeof(t)) != 0
+		  || memcmp(t2, ref2, sizeof(t2)) != 0) {
+			fprintf(stderr, "  %s: swap mismatch for n=%d, so=%d, "
+			  "to=%d\n", k->name, n, so, to);
+			return false;
+		}
+
+		if (k->weight(t + to, n) != ref_k->weight(t + to, n)) {
+			fprintf(stderr, "  %s: weight mismatch for n=%d, "
+			  "to=%d\n", k->name, n, to);
+			return false;
+		}
+
+		/* A zero range, possibly with one bit set */
+		memset(t + to, 0, n * sizeof(m2v_base));
+		if (n > 0 && rand() % 2)
+			t[to + rand() % n] |= (m2v_base)1 << (rand() % 64);
+		if (k->iszero(t + to, n) != ref_k->iszero(t + to, n)) {
+			fprintf(stderr, "  %s: iszero mismatch for n=%d, "
+			  "to=%d\n", k->name, n, to);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Check the m2v row operations with the given kernel set active
+ * against the m256v ones.
+ */
+static bool test_row_ops(const m2v_kern* k)
+{
+	const m2v_kern* prev = m2v_kern_active;
+	m2v_kern_active = k;
+
+	bool success = true;
+	static const int ncol_arr[] = { 1, 63, 64, 65, 511, 512, 513, 1100 };
+	for (int j = 0; j < (int)(sizeof(ncol_arr) / sizeof(ncol_arr[0])); ++j) {
+		const int nrow = 20, ncol = ncol_arr[j];
+		m256v Ml;
+		m2v Ms;
+		get_mat_pair(nrow, ncol, &Ml, &Ms);
+		for (int it = 0; it < 200; ++it) {
+			const int r1 = rand() % nrow;
+			const int r2 = rand() % nrow;
+			switch (rand() % 5) {
+			case 0:
+				m2v_swap_rows(&Ms, r1, r2);
+				m256v_swap_rows(&Ml, r1, r2);
+				break;
+			case 1:
+				m2v_multadd_row(&Ms, r1, 1, &Ms, r2);
+				m256v_multadd_row(&Ml, r1, 1, &Ml, r2);
+				break;
+			case 2: {
+				const int offs = rand() % ncol;
+				m2v_multadd_row_from(&Ms, r1, offs, 1, &Ms, r2);
+				m256v_multadd_row_from(&Ml, r1, offs, 1, &Ml, r2);
+				break;
+			}
+			case 3:
+				if (rand() % 4 == 0) {
+					m2v_clear_row(&Ms, r1);
+					m256v_clear_row(&Ml, r1);
+				}
+				break;
+			case 4: {
+				int rows[3], alphas_s[3];
+				uint8_t alphas_l[3];
+				for (int l = 0; l < 3; ++l) {
+					rows[l] = rand() % nrow;
+					if (rows[l] == r2)
+						rows[l] = (r2 + 1) % nrow;
+					alphas_s[l] = alphas_l[l] = rand() & 1;
+				}
+				m2v_multadd_rows(&Ms, rows, alphas_s, 3, &Ms, r2);
+				m256v_multadd_rows(&Ml, rows, alphas_l, 3, &Ml, r2);
+				break;
+			}
+			}
+
+			int w = 0;
+			for (int c = 0; c < ncol; ++c)
+				w += m256v_get_el(&Ml, r1, c);
+			if (m2v_row_weight(&Ms, r1) != w
+			  || m2v_row_iszero(&Ms, r1) != (w == 0)) {
+				fprintf(stderr, "  %s: row weight mismatch for "
+				  "ncol=%d\n", k->name, ncol);
+				success = false;
+				break;
+			}
+		}
+		if (!check_mat_pair_equal(&Ml, &Ms)) {
+			fprintf(stderr, "  %s: row operation mismatch for "
+			  "ncol=%d\n", k->name, ncol);
+			success = false;
+		}
+		free_mat_pair_mem(&Ml, &Ms);
+	}
+
+	m2v_kern_active = prev;
+	return success;
+}
+
+/* Check the built-in self test accepts the kernel set. */
+static bool test_selftest(const m2v_kern* k)
+{
+	if (!m2v_kern_selftest(k)) {
+		fprintf(stderr, "  %s: self test failed\n", k->name);
+		return false;
+	}
+	return true;
+}
+
+static bool test_all_kernels(bool (*testfunc)(const m2v_kern*))
+{
+	bool success = true;
+	const m2v_kern* k;
+	for (int i = 0; (k = m2v_kern_get_nth(i)) != NULL; ++i) {
+		if (!testfunc(k))
+			success = false;
+	}
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Tests for the GF(2) row operation kernels.\n"
+		"\n"
+		"All kernel sets supported by the CPU are checked.\n"
+		"\n"
+		"  -h   Display this help screen.\n"
+		);
+}
+
+int main(int argc, char** argv)
+{
+	/* Read cmdline args */
+	int c;
+	while ((c = getopt(argc, argv, "h")) != -1) {
+		switch(c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	printf("Active kernel set: %s\n", m2v_kern_active->name);
+	printf("Supported kernel sets:");
+	const m2v_kern* k;
+	for (int i = 0; (k = m2v_kern_get_nth(i)) != NULL; ++i)
+		printf(" %s", k->name);
+	printf("\n");
+
+	int nfail = 0;
+#define RUN_TEST(x) \
+	do { \
+		printf("Running: " #x "\n"); \
+		if (!x) { \
+			printf("--> FAIL (test " #x ")\n"); \
+			++nfail; \
+		} else { \
+			printf("--> pass\n"); \
+		} \
+	} while(0)
+
+	RUN_TEST(test_all_kernels(test_against_scalar));
+	RUN_TEST(test_all_kernels(test_row_ops));
+	RUN_TEST(test_all_kernels(test_selftest));
+#undef RUN_TEST
+
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -78,6 +78,125 @@ bool test_m2v_lu()
 	return true;
 }
 
+/* Compare the M4RI decomposition against the basic one, on matrices
+ * large enough for it to kick in.  Low rank matrices and zero columns
+ * exercise the cases where a panel runs out of pivots.
+ */
+static bool stest_m2v_lu_m4ri(int nrow, int ncol, int rank, int n_zcol)
+{
+	/* A = B * C is of rank at most `rank' */
+	m256v Bl, Cl;
+	m2v Bs, Cs;
+	get_mat_pair(nrow, rank, &Bl, &Bs);
+	get_mat_pair(rank, ncol, &Cl, &Cs);
+	m256v Al;
+	m2v As;
+	get_mat_pair(nrow, ncol, &Al, &As);
+	m256v_mul(&Bl, &Cl, &Al);
+	for (int i = 0; i < n_zcol; ++i) {
+		const int zc = rand() % ncol;
+		for (int r = 0; r < nrow; ++r)
+			m256v_set_el(&Al, r, zc, 0);
+	}
+	m2v_base* ref_mem = malloc(nrow * As.row_stride * sizeof(m2v_base));
+	m2v Aref = m2v_make(nrow, ncol, ref_mem);
+	for (int r = 0; r < nrow; ++r) {
+		for (int c = 0; c < ncol; ++c) {
+			m2v_set_el(&As, r, c, m256v_get_el(&Al, r, c));
+			m2v_set_el(&Aref, r, c, m256v_get_el(&Al, r, c));
+		}
+	}
+
+	int rp[nrow], cp[ncol];
+	int rp_ref[nrow], cp_ref[ncol];
+	const int r1 = m2v_LU_decomp_inplace(&As, rp, cp);
+	const int r2 = m2v_LU_decomp_inplace_basic(&Aref, rp_ref, cp_ref);
+	bool success = (r1 == r2
+		&& memcmp(rp, rp_ref, sizeof(rp)) == 0
+		&& memcmp(cp, cp_ref, sizeof(cp)) == 0);
+	for (int r = 0; success && r < nrow; ++r) {
+		for (int c = 0; c < ncol; ++c) {
+			if (m2v_get_el(&As, r, c) != m2v_get_el(&Aref, r, c))
+				success = false;
+		}
+	}
+	if (!success) {
+		printf("Failure detected:  M4RI LU differs from reference "
+			"(nrow=%d, ncol=%d, rank=%d/%d, n_zcol=%d).\n",
+			nrow, ncol, r1, r2, n_zcol);
+	}
+
+	free(ref_mem);
+	free_mat_pair_mem(&Al, &As);
+	free_mat_pair_mem(&Cl, &Cs);
+	free_mat_pair_mem(&Bl, &Bs);
+	return success;
+}
+
+bool test_m2v_lu_m4ri()
+{
+	const int shapes[][2] = {
+		{ 64, 64 }, { 100, 100 }, { 150, 90 }, { 90, 150 },
+		{ 200, 200 }, { 257, 250 }, { 300, 1100 },
+	};
+	for (int i = 0; i < array_size(shapes); ++i) {
+		const int nrow = shapes[i][0];
+		const int ncol = shapes[i][1];
+		const int n = (nrow < ncol ? nrow : ncol);
+		const int ranks[] = { n, n - 1, n / 2, 33, 3 };
+		for (int j = 0; j < array_size(ranks); ++j) {
+			for (int n_zcol = 0; n_zcol < 6; n_zcol += 5) {
+				if (!stest_m2v_lu_m4ri(nrow, ncol, ranks[j],
+								n_zcol))
+					return false;
+			}
+		}
+	}
+
+	/* Rows too wide for a table of two rows, tabulated in strips */
+	return stest_m2v_lu_m4ri(70, 300000, 70, 0);
+}
+
+/* M4RM multiplication against the GF(256) one */
+static bool stest_m2v_m4rm(int nrow, int nmid, int ncol)
+{
+	m256v Al, Bl, Cl;
+	m2v As, Bs, Cs;
+	get_mat_pair(nrow, nmid, &Al, &As);
+	get_mat_pair(nmid, ncol, &Bl, &Bs);
+	get_mat_pair(nrow, ncol, &Cl, &Cs);
+	clobber_m2v(&Cs);
+
+	m2v_mul(&As, &Bs, &Cs);
+	m256v_mul(&Al, &Bl, &Cl);
+	const bool success = check_mat_pair_equal(&Cl, &Cs);
+	if (!success) {
+		printf("Failure detected:  Products differ (%d x %d x %d).\n",
+			nrow, nmid, ncol);
+	}
+
+	free_mat_pair_mem(&Cl, &Cs);
+	free_mat_pair_mem(&Bl, &Bs);
+	free_mat_pair_mem(&Al, &As);
+	return success;
+}
+
+bool test_m2v_m4rm()
+{
+	const int dims[] = { 1, 7, 8, 9, 31, 32, 33, 100, 257 };
+	for (int i = 0; i < array_size(dims); ++i) {
+		for (int j = 0; j < array_size(dims); ++j) {
+			for (int k = 0; k < array_size(dims); k += 2) {
+				if (!stest_m2v_m4rm(dims[i], dims[j], dims[k]))
+					return false;
+			}
+		}
+	}
+
+	/* Rows too wide for a table of two rows, tabulated in strips */
+	return stest_m2v_m4rm(5, 9, 300000);
+}
+
 bool stest_m2v_mult(int nrow, int ncol)
 {
 	/* Generate inputs and prepare output mat */
@@ -312,6 +431,8 @@ int main(int argc, char** argv)
 
 	// LU routines test
 	RUN_TEST(test_m2v_lu());
+	RUN_TEST(test_m2v_lu_m4ri());
+	RUN_TEST(test_m2v_m4rm());
 	RUN_TEST(test_m2v_mult());
 	RUN_TEST(test_m2v_mult_inplace());
 	RUN_TEST(test_m2v_invmult_inplace());
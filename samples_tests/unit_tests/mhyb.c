@@ -0,0 +1,106 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "m256v.h"
+#include "mhyb.h"
+#include "parameters.h"
+#include "rq_matrix.h"
+
+/* Check the hybrid RQ matrix against the dense one. */
+static bool test_rq_matrix(int K, int n_ESIs)
+{
+	const parameters P = parameters_get(K);
+	uint32_t* ESIs = malloc(n_ESIs * sizeof(uint32_t));
+	for (int i = 0; i < n_ESIs; ++i)
+		ESIs[i] = (i % 3 ? i : rand() % 100000);
+
+	int n_rows, n_cols;
+	rq_matrix_get_dim(&P, n_ESIs, &n_rows, &n_cols);
+	const int n_sp = n_rows - P.H;
+	const int nnz_max = rq_matrix_nnz_max(&P, n_ESIs);
+	int* row_ptr = malloc((n_sp + 1) * sizeof(int));
+	int* row_cols = malloc(nnz_max * sizeof(int));
+	uint8_t* hdpc = malloc(P.H * n_cols);
+	uint8_t* dense = malloc(n_rows * n_cols);
+	uint8_t* expanded = malloc(n_rows * n_cols);
+
+	mhyb M = mhyb_make(n_sp, nnz_max, P.H, n_cols,
+				row_ptr, row_cols, hdpc);
+	rq_matrix_generate_hybrid(&M, &P, n_ESIs, ESIs);
+	m256v A = m256v_make(n_rows, n_cols, dense);
+	rq_matrix_generate(&A, &P, n_ESIs, ESIs);
+	m256v B = m256v_make(n_rows, n_cols, expanded);
+	mhyb_to_dense(&M, &B);
+
+	bool success = true;
+	if (mhyb_n_row(&M) != n_rows || mhyb_nnz(&M) > nnz_max) {
+		fprintf(stderr, "  Wrong size of the hybrid matrix (K=%d).\n", K);
+		success = false;
+	} else if (memcmp(dense, expanded, n_rows * n_cols) != 0) {
+		fprintf(stderr, "  Hybrid matrix differs (K=%d).\n", K);
+		success = false;
+	}
+	for (int it = 0; success && it < 1000; ++it) {
+		const int r = rand() % n_rows, c = rand() % n_cols;
+		if (mhyb_get_el(&M, r, c) != m256v_get_el(&A, r, c)) {
+			fprintf(stderr, "  Element (%d,%d) differs (K=%d).\n",
+					r, c, K);
+			success = false;
+		}
+	}
+
+	free(ESIs);
+	free(row_ptr);
+	free(row_cols);
+	free(hdpc);
+	free(dense);
+	free(expanded);
+	return success;
+}
+
+static void usage()
+{
+	puts(	"Tests for hybrid sparse/dense matrices.\n"
+		"\n"
+		"  -h   Display this help screen.\n"
+		);
+}
+
+int main(int argc, char** argv)
+{
+	/* Read cmdline args */
+	int c;
+	while ((c = getopt(argc, argv, "h")) != -1) {
+		switch(c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	int nfail = 0;
+#define RUN_TEST(x) \
+	do { \
+		printf("Running: " #x "\n"); \
+		if (!x) { \
+			printf("--> FAIL (test " #x ")\n"); \
+			++nfail; \
+		} else { \
+			printf("--> pass\n"); \
+		} \
+	} while(0)
+
+	RUN_TEST(test_rq_matrix(10, 10));
+	RUN_TEST(test_rq_matrix(11, 15));
+	RUN_TEST(test_rq_matrix(101, 100));
+	RUN_TEST(test_rq_matrix(1000, 1003));
+	RUN_TEST(test_rq_matrix(1000, 130));
+#undef RUN_TEST
+
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
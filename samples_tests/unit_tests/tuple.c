@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "lt.h"
+#include "parameters.h"
+#include "rand.h"
+#include "tuple.h"
+
+#define N_ISIS		1000
+
+/* Sect 5.3.5.2, straight from the RFC */
+static int ref_Deg(uint32_t v, int W)
+{
+	static const int f[] = {
+		0, 5243, 529531, 704294, 791675, 844104, 879057, 904023,
+		922747, 937311, 948962, 958494, 966438, 973160, 978921,
+		983914, 988283, 992138, 995565, 998631, 1001391, 1003887,
+		1006157, 1008229, 1010129, 1011876, 1013490, 1014983,
+		1016370, 1017662, 1048576,
+	};
+	for (int d = 1; d < 31; ++d) {
+		if ((uint32_t)f[d - 1] <= v && v < (uint32_t)f[d])
+			return (d <= W - 2 ? d : W - 2);
+	}
+	return -1;
+}
+
+/* Sect 5.3.5.4, with Rand's divisions */
+static tuple ref_tuple(uint32_t X, const parameters* P)
+{
+	const uint32_t A = (53591 + P->J * 997) | 0x1;
+	const uint32_t B = 10267 * (P->J + 1);
+	const uint32_t y = (B + X*A);
+	tuple T;
+	T.d = ref_Deg(Rand(y, 0, 1 << 20), P->W);
+	T.a = 1 + Rand(y, 1, P->W - 1);
+	T.b = Rand(y, 2, P->W);
+	T.d1 = (T.d < 4 ? 2 + Rand(X, 3, 2) : 2);
+	T.a1 = 1 + Rand(X, 4, P->P1 - 1);
+	T.b1 = Rand(X, 5, P->P1);
+	return T;
+}
+
+static bool same_tuple(tuple T1, tuple T2)
+{
+	return T1.d == T2.d && T1.a == T2.a && T1.b == T2.b
+		&& T1.d1 == T2.d1 && T1.a1 == T2.a1 && T1.b1 == T2.b1;
+}
+
+/* Check single, batch, and range tuple generation against the
+ * reference, for a range of ISIs and for random ones.
+ */
+static bool test_tuples(int K)
+{
+	const parameters P = parameters_get(K);
+	uint32_t ISIs[N_ISIS];
+	tuple T_range[N_ISIS], T_batch[N_ISIS];
+	const uint32_t ISI0 = rand() % 100000;
+	for (int i = 0; i < N_ISIS; ++i)
+		ISIs[i] = (i % 2 ? ISI0 + i : (uint32_t)rand() * 31);
+	tuple_generate_range(&P, ISI0, N_ISIS, T_range);
+	tuple_generate_from_ISIs(&P, N_ISIS, ISIs, T_batch);
+
+	for (int i = 0; i < N_ISIS; ++i) {
+		const tuple ref_r = ref_tuple(ISI0 + i, &P);
+		const tuple ref_b = ref_tuple(ISIs[i], &P);
+		if (!same_tuple(T_range[i], ref_r)
+		  || !same_tuple(T_batch[i], ref_b)
+		  || !same_tuple(tuple_generate_from_ISI(ISIs[i], &P), ref_b)) {
+			fprintf(stderr, "  Tuple mismatch for K=%d, ISI=%u.\n",
+				K, ISIs[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* LT rows have distinct columns, in range */
+static bool test_lt_rows(int K)
+{
+	const parameters P = parameters_get(K);
+	for (uint32_t ISI = 0; ISI < N_ISIS; ++ISI) {
+		int cols[LT_MAX_ROW_WEIGHT];
+		const int n = lt_get_row(&P, ISI, cols);
+		for (int j = 0; j < n; ++j) {
+			bool ok = (cols[j] >= 0 && cols[j] < P.W + P.P);
+			for (int k = 0; k < j; ++k)
+				ok = ok && (cols[k] != cols[j]);
+			if (!ok) {
+				fprintf(stderr, "  Bad LT row for K=%d, "
+						"ISI=%u.\n", K, ISI);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void usage()
+{
+	puts(	"Tests for the tuple generation.\n"
+		"\n"
+		"  -h   Display this help screen.\n"
+		);
+}
+
+int main(int argc, char** argv)
+{
+	/* Read cmdline args */
+	int c;
+	while ((c = getopt(argc, argv, "h")) != -1) {
+		switch(c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+
+	int nfail = 0;
+#define RUN_TEST(x) \
+	do { \
+		printf("Running: " #x "\n"); \
+		if (!x) { \
+			printf("--> FAIL (test " #x ")\n"); \
+			++nfail; \
+		} else { \
+			printf("--> pass\n"); \
+		} \
+	} while(0)
+
+	RUN_TEST(test_tuples(10));
+	RUN_TEST(test_tuples(1000));
+	RUN_TEST(test_tuples(56403));
+	RUN_TEST(test_lt_rows(10));
+	RUN_TEST(test_lt_rows(56403));
+#undef RUN_TEST
+
+	return (nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,95 @@
+/**	@file rq_bundle.c
+ *
+ *	Write a bundle of the systematic programs for a range of K values
+ *	(by default all of them), see RqBundleWrite.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include "parameters.h"
+#include "rq_api.h"
+
+static void usage()
+{
+	puts(	"Write a bundle of systematic programs.\n"
+		"\n"
+		"   -h          display this help screen and exit\n"
+		"   -o <path>   bundle file to write (required)\n"
+		"   -k #        smallest K to include (default 1)\n"
+		"   -K #        largest K to include (default RQ_MAX_K)\n"
+		"   -t #        number of threads to compile with (default 1)\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	const char* sPath = NULL;
+	int Kmin = 1;
+	int Kmax = RQ_MAX_K;
+	int nThreads = 1;
+
+	/* scan command lines */
+	int c;
+	while ((c = getopt(argc, argv, "ho:k:K:t:")) != -1) {
+		switch (c) {
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		case 'o':
+			sPath = optarg;
+			break;
+		case 'k':
+			Kmin = atoi(optarg);
+			break;
+		case 'K':
+			Kmax = atoi(optarg);
+			break;
+		case 't':
+			nThreads = atoi(optarg);
+			break;
+		case '?':
+			exit(EXIT_FAILURE);
+		};
+	}
+	if (sPath == NULL) {
+		fprintf(stderr, "Error:  No bundle file given (-o).\n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	const int err = RqBundleWrite(sPath, Kmin, Kmax, nThreads);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (err != 0) {
+		fprintf(stderr, "Error:  Writing the bundle failed (%d).\n",
+				err);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Report the sizes */
+	const RqBundle* bundle;
+	if (RqBundleMap(sPath, &bundle) != 0)
+		exit(EXIT_FAILURE);
+	size_t nProgs = 0, nProgBytes = 0;
+	for (int K = Kmin; K <= Kmax; K = parameters_get(K).Kprime + 1) {
+		size_t sz;
+		if (RqBundleGetProgramSize(bundle, K, &sz) != 0)
+			break;
+		nProgBytes += sz;
+		++nProgs;
+	}
+	RqBundleUnmap(bundle);
+	FILE* f = fopen(sPath, "rb");
+	fseek(f, 0, SEEK_END);
+	const long nFileBytes = ftell(f);
+	fclose(f);
+	printf("Wrote %s in %.1f s:  %ld bytes for %zu K' values "
+		"(%zu bytes uncompressed).\n", sPath,
+		(t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec),
+		nFileBytes, nProgs, nProgBytes);
+	return EXIT_SUCCESS;
+}
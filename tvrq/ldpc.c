@@ -1,35 +1,89 @@
 #include <assert.h>
+#include <string.h>
 
 #include "ldpc.h"
 
-void ldpc_generate_mat(m256v* L, const parameters* P)
+void ldpc_enum_entries(const parameters* P,
+			void* usr,
+			void (*f)(void* usr, int row, int col))
 {
-	assert(L->n_row == P->S);
-	assert(L->n_col == P->L);
-
-	m256v_clear(L);
-
-	/* Fill in the left part (G_LDPC,1) */
+	/* Fill in the left part (G_LDPC,1)
+	 *
+	 * The three rows of a column can coincide for some S; such
+	 * entries are reported only once.
+	 */
 	for (int i = 0; i < P->B; ++i) {
 		const int a = 1 + i / P->S;
-		int b = i % P->S;
-		m256v_set_el(L, b, i, 1);
-		b = (b + a) % P->S;
-		m256v_set_el(L, b, i, 1);
-		b = (b + a) % P->S;
-		m256v_set_el(L, b, i, 1);
+		const int b0 = i % P->S;
+		const int b1 = (b0 + a) % P->S;
+		const int b2 = (b1 + a) % P->S;
+		f(usr, b0, i);
+		if (b1 != b0)
+			f(usr, b1, i);
+		if (b2 != b0 && b2 != b1)
+			f(usr, b2, i);
 	}
 
 	/* Add diagonal at offset B */
 	for (int i = 0; i < P->S; ++i) {
-		m256v_set_el(L, i, i + P->B, 1);
+		f(usr, i, i + P->B);
 	}
 
 	/* Double diagonal on the right (G_LDPC,2) */
 	for (int i = 0; i < P->S; ++i) {
 		const int a = i % P->P;
 		const int b = (i + 1) % P->P;
-		m256v_set_el(L, i, P->W + a, 1);
-		m256v_set_el(L, i, P->W + b, 1);
+		f(usr, i, P->W + a);
+		if (b != a)
+			f(usr, i, P->W + b);
 	}
 }
+
+static void set_one(void* usr, int row, int col)
+{
+	m256v_set_el((m256v*)usr, row, col, 1);
+}
+
+void ldpc_generate_mat(m256v* L, const parameters* P)
+{
+	assert(L->n_row == P->S);
+	assert(L->n_col == P->L);
+
+	m256v_clear(L);
+	ldpc_enum_entries(P, L, set_one);
+}
+
+static void count_entry(void* usr, int row, int col)
+{
+	(void)col;
+	int* cnt = usr;
+	++cnt[row];
+}
+
+typedef struct {
+	int* pos;
+	int* cols;
+} fill_ctx;
+
+static void fill_entry(void* usr, int row, int col)
+{
+	fill_ctx* ctx = usr;
+	ctx->cols[ctx->pos[row]++] = col;
+}
+
+void ldpc_generate_sparse(mhyb* M, const parameters* P)
+{
+	assert(M->n_col == P->L);
+
+	/* The entries are enumerated by column, so count first */
+	int pos[P->S];
+	memset(pos, 0, sizeof(pos));
+	ldpc_enum_entries(P, pos, count_entry);
+	const int row0 = M->n_sp;
+	fill_ctx ctx = {
+		.pos = pos,
+		.cols = mhyb_reserve_rows(M, P->S, pos),
+	};
+	memcpy(pos, M->row_ptr + row0, sizeof(pos));
+	ldpc_enum_entries(P, &ctx, fill_entry);
+}
@@ -8,7 +8,20 @@
 
 #include "parameters.h"
 #include "m256v.h"
+#include "mhyb.h"
 
 void ldpc_generate_mat(m256v* L, const parameters* P);
 
+/**	Append the S LDPC rows to the sparse rows of M. */
+void ldpc_generate_sparse(mhyb* M, const parameters* P);
+
+/**	Enumerate the nonzero entries of the LDPC matrix.
+ *
+ *	Calls f(usr, row, col) once for every nonzero entry.  All
+ *	nonzero entries of the LDPC matrix are 1.
+ */
+void ldpc_enum_entries(const parameters* P,
+			void* usr,
+			void (*f)(void* usr, int row, int col));
+
 #endif /* LDPC_H */
@@ -1,9 +1,45 @@
 #include <assert.h>
 
 #include "lt.h"
-#include "tuple.h"
 
 // Sect 5.3.5.3
+int lt_row_from_tuple(const parameters* P, tuple T, int* cols)
+{
+	/* W and P1 are prime, so that the columns of both sequences are
+	 * all distinct.
+	 */
+	int n = 0;
+	cols[n++] = T.b;
+	for (int j = 1; j < T.d; ++j) {
+		T.b += T.a;
+		if (T.b >= P->W)
+			T.b -= P->W;
+		cols[n++] = T.b;
+	}
+	while (T.b1 >= P->P) {
+		T.b1 += T.a1;
+		if (T.b1 >= P->P1)
+			T.b1 -= P->P1;
+	}
+	cols[n++] = P->W + T.b1;
+	for (int j = 1; j < T.d1; ++j) {
+		do {
+			T.b1 += T.a1;
+			if (T.b1 >= P->P1)
+				T.b1 -= P->P1;
+		} while (T.b1 >= P->P);
+		cols[n++] = P->W + T.b1;
+	}
+
+	assert(n <= LT_MAX_ROW_WEIGHT);
+	return n;
+}
+
+int lt_get_row(const parameters* P, uint32_t ISI, int* cols)
+{
+	return lt_row_from_tuple(P, tuple_generate_from_ISI(ISI, P), cols);
+}
+
 void lt_generate_mat(m256v* M,
 			const parameters* P,
 			int n_ISIs,
@@ -13,21 +49,34 @@ void lt_generate_mat(m256v* M,
 	assert(M->n_col == P->L);
 
 	m256v_clear(M);
-	for (int i = 0; i < n_ISIs; ++i) {
-		tuple T = tuple_generate_from_ISI(ISIs[i], P);
-		m256v_set_el(M, i, T.b, 1);
-		for (int j = 1; j < T.d; ++j) {
-			T.b = (T.b + T.a) % P->W;
-			m256v_set_el(M, i, T.b, 1);
+	int cols[LT_MAX_ROW_WEIGHT];
+	tuple T[LT_BATCH];
+	for (int i0 = 0; i0 < n_ISIs; i0 += LT_BATCH) {
+		const int m = n_ISIs - i0 < LT_BATCH ? n_ISIs - i0 : LT_BATCH;
+		tuple_generate_from_ISIs(P, m, ISIs + i0, T);
+		for (int i = 0; i < m; ++i) {
+			const int n = lt_row_from_tuple(P, T[i], cols);
+			for (int j = 0; j < n; ++j)
+				m256v_set_el(M, i0 + i, cols[j], 1);
 		}
-		while (T.b1 >= P->P)
-			T.b1 = (T.b1 + T.a1) % P->P1;
-		m256v_set_el(M, i, P->W + T.b1, 1);
-		for (int j = 1; j < T.d1; ++j) {
-			T.b1 = (T.b1 + T.a1) % P->P1;
-			while (T.b1 >= P->P)
-				T.b1 = (T.b1 + T.a1) % P->P1;
-			m256v_set_el(M, i, P->W + T.b1, 1);
+	}
+}
+
+void lt_generate_sparse(mhyb* M,
+			const parameters* P,
+			int n_ISIs,
+			const uint32_t* ISIs)
+{
+	assert(M->n_col == P->L);
+
+	int cols[LT_MAX_ROW_WEIGHT];
+	tuple T[LT_BATCH];
+	for (int i0 = 0; i0 < n_ISIs; i0 += LT_BATCH) {
+		const int m = n_ISIs - i0 < LT_BATCH ? n_ISIs - i0 : LT_BATCH;
+		tuple_generate_from_ISIs(P, m, ISIs + i0, T);
+		for (int i = 0; i < m; ++i) {
+			const int n = lt_row_from_tuple(P, T[i], cols);
+			mhyb_append_row(M, cols, n);
 		}
 	}
 }
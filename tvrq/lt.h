@@ -10,10 +10,46 @@
 
 #include "parameters.h"
 #include "m256v.h"
+#include "mhyb.h"
+#include "tuple.h"
+
+/* Maximum number of nonzeros in an LT row:  d <= 30 and d1 <= 3 */
+#define LT_MAX_ROW_WEIGHT	33
+
+/* Number of tuples generated at once by the functions creating many
+ * LT rows.
+ */
+#define LT_BATCH		64
+
+/**	Compute the nonzero columns of the LT row for an ISI.
+ *
+ *	All the nonzero entries of an LT row are 1.
+ *
+ *	@param	cols
+ *		Array receiving the column indices; must have space for
+ *		LT_MAX_ROW_WEIGHT entries.
+ *
+ *	@return	The number of columns written.  Each column appears at
+ *		most once.
+ */
+int lt_get_row(const parameters* P, uint32_t ISI, int* cols);
+
+/**	Like lt_get_row, for the tuple of the ISI.
+ *
+ *	For many ISIs, generating their tuples with
+ *	tuple_generate_from_ISIs first is faster.
+ */
+int lt_row_from_tuple(const parameters* P, tuple T, int* cols);
 
 void lt_generate_mat(m256v* M,
 			const parameters* P,
 			int n_ISIs,
 			const uint32_t* ISIs);
 
+/**	Append the LT rows of the given ISIs to the sparse rows of M. */
+void lt_generate_sparse(mhyb* M,
+			const parameters* P,
+			int n_ISIs,
+			const uint32_t* ISIs);
+
 #endif /* LT_H */
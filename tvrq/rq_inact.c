@@ -0,0 +1,1008 @@
+/**	@file rq_inact.c
+ *
+ *	Inactivation decoding of the RQ matrix.
+ *
+ *	The matrix rows are ordered as in rq_matrix_generate:  LT rows
+ *	for the ESIs, LT rows for the padding symbols, LDPC rows, HDPC
+ *	rows.  All but the HDPC rows are sparse with entries 1; they
+ *	are kept in compressed row and column form for the first phase.
+ *
+ *	Phase 1 (cf. RFC 6330 Sect 5.4.2.2) works on the matrix V of
+ *	active columns, initially all but the PI columns.  In each step,
+ *	a non-HDPC row with the least number r of nonzeros in V is
+ *	chosen; one of its V columns becomes the next pivot column, and
+ *	the other r - 1 are inactivated, i.e., moved to the right end.
+ *	This goes on until no row with nonzeros in V remains.  Among
+ *	the rows with r = 2, one in a largest component of the graph
+ *	they form on the V columns is chosen, as the RFC prescribes.
+ *
+ *	All the V columns of the chosen row leave V either way, so the
+ *	choice of the pivot among them affects neither the rows chosen
+ *	later nor the number of inactivations.  It does decide which
+ *	nonzeros end up in L11 and A21, each of which costs a row
+ *	operation below; so, as in Markowitz pivoting, the column with
+ *	the fewest nonzeros in the remaining rows is chosen.  After
+ *	the corresponding row and column permutation, the matrix has
+ *	the shape
+ *
+ *		[ L11    A12 ]
+ *		[ A21    A22 ]
+ *
+ *	with L11 i x i lower triangular with unit diagonal.  The
+ *	remaining work is done numerically, on a dense matrix holding
+ *	only the u inactive columns:  U12 = L11^(-1) A12 and the Schur
+ *	complement A22 - A21 U12 are computed with sparse row
+ *	operations, and the Schur complement is LU decomposed.
+ *
+ *	The schedule solving the system with the right hand side
+ *	[ b1; b2 ] then is:
+ *
+ *	   z1 = L11^(-1) b1			(sparse)
+ *	   b2' = b2 - A21 z1			(sparse, HDPC rows dense)
+ *	   x2 = (A22 - A21 U12)^(-1) b2'	(dense, u x u)
+ *	   x1 = L11^(-1) (L11 z1 - A12 x2)	(sparse)
+ *
+ *	The last step recovers b1 from z1 instead of using U12, as U12 is
+ *	dense.  This way, the schedule has O(nonzeros + u^2) operations.
+ *
+ *	All rows but the HDPC ones are binary, and so are their rows of
+ *	U12 and of the Schur complement.  These are kept bit-packed in
+ *	an m2v, and the binary rows of the Schur complement are LU
+ *	decomposed over GF(2) first.  Only the H HDPC rows are dense:
+ *	they are eliminated with the binary pivots, and what remains of
+ *	them right of the binary pivots is LU decomposed in m256v.
+ *	Together, this is an LU decomposition of the Schur complement
+ *	with the binary pivot rows first.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gf256.h"
+#include "m2v.h"
+#include "rq_inact.h"
+#include "rq_matrix.h"
+
+/* Rows are kept in buckets by (r, original degree).  Both are capped;
+ * rows above the cap are still chosen correctly, only the tie breaking
+ * among them is less precise.
+ */
+#define R_CAP		64
+#define DEG_CAP		64
+#define N_KEYS		((R_CAP + 1) * DEG_CAP)
+
+/* Number of rows passed to m2v_multadd_rows and m256v_multadd_rows
+ * in one call
+ */
+#define BATCH		64
+
+typedef struct {
+	int n_sp;		/* Number of sparse rows */
+	int nnz_max;		/* Bound on the number of nonzeros */
+} sizes;
+
+static sizes get_sizes(const parameters* P, int n_ESIs)
+{
+	sizes s;
+	const int n_pad = P->Kprime - P->K;
+	s.n_sp = n_ESIs + n_pad + P->S;
+	s.nnz_max = rq_matrix_nnz_max(P, n_ESIs);
+	return s;
+}
+
+/* Bound on the number of dense rows of the Schur complement:  the HDPC
+ * rows, and the rows rq_inact_resume adds.  The numerical phase is
+ * only reached with at least K ESIs.
+ */
+static int dense_rows_max(const parameters* P, int n_ESIs)
+{
+	return P->H + (n_ESIs > P->K ? n_ESIs - P->K : 0);
+}
+
+/* Scratch memory allocation */
+
+typedef struct {
+	char* p;
+	size_t left;
+	size_t used;
+} arena;
+
+static void* arena_get(arena* a, size_t sz)
+{
+	sz = (sz + 15) & ~(size_t)15;
+	a->used += sz;
+	if (sz > a->left)
+		return NULL;
+	void* ret = a->p;
+	a->p += sz;
+	a->left -= sz;
+	return ret;
+}
+
+/* What rq_inact_resume needs to know about a failed compilation; the
+ * rest is in the state arrays.
+ */
+typedef struct {
+	int valid;		/* The state can be resumed */
+	int n_ESIs;
+	int n_piv;
+	int rank_b;		/* Number of binary pivots */
+	int n_dense;		/* Number of dense rows */
+	int rank_d;		/* Rank of the dense part */
+	int deficit;		/* L minus the rank, or a lower bound */
+} resume_info;
+
+typedef struct {
+	resume_info* rs;
+
+	/* Sparse rows & columns */
+	int* row_ptr;		/* n_sp + 1 */
+	int* row_cols;		/* nnz_max */
+	int* col_ptr;		/* L + 1 */
+	int* col_rows;		/* nnz_max */
+
+	/* Phase 1 state */
+	int* row_r;		/* n_sp: Nonzeros in V */
+	int* row_deg;		/* n_sp: Original degree */
+	int* row_next;		/* n_sp: Bucket list links */
+	int* row_prev;		/* n_sp */
+	int* comp_heap;		/* 3 n_sp: Components of the r = 2 graph */
+	int n_comp_heap;
+	int* row_pos;		/* n_rows: Position after permutation */
+	int* col_pos;		/* L: Position, or -1 if in V */
+	int* col_cnt;		/* L: Nonzeros in the rows not chosen yet */
+	int* head;		/* N_KEYS */
+
+	/* Numerical phase */
+	int* rowperm;		/* n_rows */
+	int* colperm;		/* L */
+	m2v_base* bin;		/* n_rows x L bits: binary rows */
+	uint8_t* dense;		/* n_dense x L: dense rows */
+	uint8_t* expand;	/* BATCH x L: expanded binary rows */
+	uint8_t* hdpc;		/* H x L */
+	int* rp2;		/* n_rows: binary LU */
+	int* cp2;		/* L */
+	int* rp3;		/* n_dense: dense LU */
+	int* cp3;		/* L */
+	int* dpos;		/* n_dense: Positions of the dense rows */
+	int* tmp;		/* max(n_rows, L) */
+} state;
+
+static void alloc_state(state* st, arena* a, const parameters* P, int n_ESIs)
+{
+	const sizes s = get_sizes(P, n_ESIs);
+	const int n_rows = s.n_sp + P->H;
+	const int L = P->L;
+	const int n_dense = dense_rows_max(P, n_ESIs);
+
+#define GET(ptr, n) \
+	((ptr) = arena_get(a, (size_t)(n) * sizeof(*(ptr))))
+	GET(st->rs, 1);
+	GET(st->row_ptr, s.n_sp + 1);
+	GET(st->row_cols, s.nnz_max);
+	GET(st->col_ptr, L + 1);
+	GET(st->col_rows, s.nnz_max);
+	GET(st->row_r, s.n_sp);
+	GET(st->row_deg, s.n_sp);
+	GET(st->row_next, s.n_sp);
+	GET(st->row_prev, s.n_sp);
+	GET(st->comp_heap, 3 * s.n_sp);
+	GET(st->row_pos, n_rows);
+	GET(st->col_pos, L);
+	GET(st->col_cnt, L);
+	GET(st->head, N_KEYS);
+	GET(st->rowperm, n_rows);
+	GET(st->colperm, L);
+	GET(st->bin, (size_t)n_rows * m2v_get_row_size(L));
+	GET(st->dense, (size_t)n_dense * L);
+	GET(st->expand, BATCH * L);
+	GET(st->hdpc, P->H * L);
+	GET(st->rp2, n_rows);
+	GET(st->cp2, L);
+	GET(st->rp3, n_dense);
+	GET(st->cp3, L);
+	GET(st->dpos, n_dense);
+	GET(st->tmp, n_rows > L ? n_rows : L);
+#undef GET
+}
+
+size_t rq_inact_scratch_size(const parameters* P, int n_ESIs)
+{
+	arena a = { .p = NULL, .left = 0, .used = 0 };
+	state st;
+	alloc_state(&st, &a, P, n_ESIs);
+	return a.used;
+}
+
+/* Bound on the number u of inactive columns the schedule length
+ * allows for:  The P PI columns, H for the HDPC rows, and U_MARGIN
+ * sqrt(L) inactivations.  With random ESI sets, we have seen at most
+ * 0.86 sqrt(K) inactivations (K from 10 to 56403).
+ */
+#define U_MARGIN	4
+
+static int u_max(const parameters* P)
+{
+	int r = 0;
+	while ((r + 1) * (r + 1) <= P->L)
+		++r;
+	const int u = P->P + P->H + U_MARGIN * r;
+	return (u < P->L) ? u : P->L;
+}
+
+size_t rq_inact_ops_max(const parameters* P, int n_ESIs)
+{
+	/* Loads; three passes over the sparse rows at most; the A21
+	 * part of the HDPC rows, with at most L entries each; the LU
+	 * decomposition of the Schur complement, with u^2 entries and
+	 * scales.
+	 */
+	const sizes s = get_sizes(P, n_ESIs);
+	const size_t u = u_max(P);
+	return P->L + 3 * (size_t)s.nnz_max + (size_t)P->H * P->L
+		+ u * u + u;
+}
+
+/* Construction of the sparse representation */
+
+static void build_sparse(state* st, const parameters* P,
+				int n_ESIs, const uint32_t* ESIs)
+{
+	int n_rows;
+	rq_matrix_get_dim(P, n_ESIs, &n_rows, NULL);
+	const int n_sp = n_rows - P->H;
+	mhyb M = mhyb_make(n_sp, rq_matrix_nnz_max(P, n_ESIs), P->H, P->L,
+				st->row_ptr, st->row_cols, st->hdpc);
+	rq_matrix_generate_hybrid(&M, P, n_ESIs, ESIs);
+	const int nnz = mhyb_nnz(&M);
+
+	/* Columns */
+	memset(st->col_ptr, 0, (P->L + 1) * sizeof(int));
+	for (int j = 0; j < nnz; ++j)
+		++st->col_ptr[st->row_cols[j] + 1];
+	for (int c = 0; c < P->L; ++c)
+		st->col_ptr[c + 1] += st->col_ptr[c];
+	memcpy(st->tmp, st->col_ptr, P->L * sizeof(int));
+	for (int r = 0; r < n_sp; ++r) {
+		for (int j = st->row_ptr[r]; j < st->row_ptr[r + 1]; ++j)
+			st->col_rows[st->tmp[st->row_cols[j]]++] = r;
+	}
+}
+
+/* Row buckets */
+
+static int key_of(const state* st, int row)
+{
+	const int r = st->row_r[row] < R_CAP ? st->row_r[row] : R_CAP;
+	const int d = st->row_deg[row] < DEG_CAP - 1
+			? st->row_deg[row] : DEG_CAP - 1;
+	return r * DEG_CAP + d;
+}
+
+/* Union-find over the V columns, with the rows with r = 2 as edges:
+ * uf[c] is the parent of c, or minus the size of the component if c
+ * is a root.  Edges are only ever added.  Once a column of a
+ * component leaves V, the rows with r = 1 this leaves propagate
+ * through the whole component before another row with r >= 2 is
+ * chosen; so at those times, the components are exact.
+ */
+static int uf_find(int* uf, int c)
+{
+	while (uf[c] >= 0) {
+		if (uf[uf[c]] >= 0)
+			uf[c] = uf[uf[c]];
+		c = uf[c];
+	}
+	return c;
+}
+
+static int uf_union(int* uf, int c1, int c2)
+{
+	int a = uf_find(uf, c1), b = uf_find(uf, c2);
+	if (a == b)
+		return a;
+	if (uf[a] > uf[b]) {
+		const int t = a;
+		a = b;
+		b = t;
+	}
+	uf[a] += uf[b];
+	uf[b] = a;
+	return a;
+}
+
+/* Max-heap of (size, root, row) triples:  each union of components
+ * with a row with r = 2 pushes the merged component with that row.
+ * Entries of components that were merged again or left V since are
+ * dropped when they come to the top.
+ */
+static void comp_heap_push(state* st, int size, int root, int row)
+{
+	int* h = st->comp_heap;
+	int i = st->n_comp_heap++;
+	while (i > 0 && h[3 * ((i - 1) / 2)] < size) {
+		memcpy(h + 3 * i, h + 3 * ((i - 1) / 2), 3 * sizeof(int));
+		i = (i - 1) / 2;
+	}
+	h[3 * i] = size;
+	h[3 * i + 1] = root;
+	h[3 * i + 2] = row;
+}
+
+static void comp_heap_pop(state* st)
+{
+	int* h = st->comp_heap;
+	const int n = --st->n_comp_heap;
+	const int* last = h + 3 * n;
+	int i = 0;
+	for (;;) {
+		int j = 2 * i + 1;
+		if (j >= n)
+			break;
+		if (j + 1 < n && h[3 * (j + 1)] > h[3 * j])
+			++j;
+		if (h[3 * j] <= last[0])
+			break;
+		memcpy(h + 3 * i, h + 3 * j, 3 * sizeof(int));
+		i = j;
+	}
+	memmove(h + 3 * i, last, 3 * sizeof(int));
+}
+
+/* Add the row, which now has r = 2, as an edge to the graph */
+static void r2_add(state* st, int row)
+{
+	int e[2], n = 0;
+	for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+		const int c = st->row_cols[j];
+		if (st->col_pos[c] < 0 && n < 2)
+			e[n++] = c;
+	}
+	assert(n == 2);
+	const int root = uf_union(st->tmp, e[0], e[1]);
+	if (st->tmp[root] < -2)
+		comp_heap_push(st, -st->tmp[root], root, row);
+}
+
+static void bucket_insert(state* st, int row)
+{
+	const int k = key_of(st, row);
+	if (st->row_r[row] == 2)
+		r2_add(st, row);
+	st->row_prev[row] = -1;
+	st->row_next[row] = st->head[k];
+	if (st->head[k] >= 0)
+		st->row_prev[st->head[k]] = row;
+	st->head[k] = row;
+}
+
+static void bucket_remove(state* st, int row)
+{
+	const int k = key_of(st, row);
+	if (st->row_prev[row] >= 0)
+		st->row_next[st->row_prev[row]] = st->row_next[row];
+	else
+		st->head[k] = st->row_next[row];
+	if (st->row_next[row] >= 0)
+		st->row_prev[st->row_next[row]] = st->row_prev[row];
+}
+
+/* Remove column c from V.  Returns the smallest key of a row that
+ * changed bucket, or N_KEYS.
+ */
+static int remove_from_V(state* st, int c)
+{
+	int min_key = N_KEYS;
+	for (int j = st->col_ptr[c]; j < st->col_ptr[c + 1]; ++j) {
+		const int row = st->col_rows[j];
+		if (st->row_pos[row] >= 0)
+			continue;
+		bucket_remove(st, row);
+		if (--st->row_r[row] > 0) {
+			bucket_insert(st, row);
+			const int k = key_of(st, row);
+			if (k < min_key)
+				min_key = k;
+		}
+	}
+	return min_key;
+}
+
+/* Choose among the rows with r = 2 one in a largest component of the
+ * graph with the V columns as nodes and these rows as edges (RFC 6330
+ * Sect 5.4.2.2).  Choosing it and its pivot leaves the rest of the
+ * component with r = 1 rows, which are pivots without inactivations.
+ */
+static int choose_r2_row(state* st, int min_key)
+{
+	const int* uf = st->tmp;
+	while (st->n_comp_heap > 0) {
+		const int* h = st->comp_heap;
+		if (uf[h[1]] == -h[0] && st->col_pos[h[1]] < 0) {
+			assert(st->row_r[h[2]] == 2);
+			return h[2];
+		}
+		comp_heap_pop(st);
+	}
+
+	/* With single edges only, keep the bucket order */
+	return st->head[min_key];
+}
+
+/* Phase 1.  Computes row_pos and col_pos and returns the number of
+ * pivots found.
+ */
+static int phase1(state* st, const parameters* P, int n_sp, int n_rows)
+{
+	const int L = P->L;
+
+	/* Initially, the PI columns are inactive */
+	for (int c = 0; c < P->W; ++c)
+		st->col_pos[c] = -1;
+	for (int c = P->W; c < L; ++c)
+		st->col_pos[c] = c;
+	int inact_pos = P->W;
+	for (int c = 0; c < L; ++c)
+		st->col_cnt[c] = st->col_ptr[c + 1] - st->col_ptr[c];
+
+	for (int k = 0; k < N_KEYS; ++k)
+		st->head[k] = -1;
+	st->n_comp_heap = 0;
+	for (int c = 0; c < L; ++c)
+		st->tmp[c] = -1;
+	for (int row = 0; row < n_rows; ++row)
+		st->row_pos[row] = -1;
+	for (int row = 0; row < n_sp; ++row) {
+		int r = 0;
+		for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j)
+			r += (st->col_pos[st->row_cols[j]] < 0);
+		st->row_r[row] = r;
+		st->row_deg[row] = r;
+		if (r > 0)
+			bucket_insert(st, row);
+	}
+
+	int i = 0;
+	int min_key = 0;
+	while (i < inact_pos) {
+		/* Choose the row */
+		while (min_key < N_KEYS && st->head[min_key] < 0)
+			++min_key;
+		if (min_key == N_KEYS)
+			break;
+		const int row = (min_key / DEG_CAP == 2)
+				? choose_r2_row(st, min_key) : st->head[min_key];
+		bucket_remove(st, row);
+		st->row_pos[row] = i;
+
+		/* Choose the V column with the fewest nonzeros in the
+		 * other remaining rows as pivot, and inactivate the others
+		 */
+		int pivot = -1;
+		for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+			const int c = st->row_cols[j];
+			--st->col_cnt[c];
+			if (st->col_pos[c] < 0 && (pivot < 0
+			  || st->col_cnt[c] < st->col_cnt[pivot]))
+				pivot = c;
+		}
+		assert(pivot >= 0);
+		for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+			const int c = st->row_cols[j];
+			if (st->col_pos[c] >= 0)
+				continue;
+			st->col_pos[c] = (c == pivot) ? i : --inact_pos;
+			const int k = remove_from_V(st, c);
+			if (k < min_key)
+				min_key = k;
+		}
+		++i;
+	}
+
+	/* Columns remaining in V (if we ran out of rows) are inactive */
+	for (int c = 0; c < L; ++c) {
+		if (st->col_pos[c] < 0)
+			st->col_pos[c] = --inact_pos;
+	}
+	assert(inact_pos == i);
+
+	/* Remaining rows follow the pivot rows in their original order */
+	int pos = i;
+	for (int row = 0; row < n_rows; ++row) {
+		if (st->row_pos[row] < 0)
+			st->row_pos[row] = pos++;
+	}
+	assert(pos == n_rows);
+
+	return i;
+}
+
+/* Scatter the inactive columns of a sparse row into row p of B */
+static void scatter_row(const state* st, m2v* B, int n_piv, int row, int p)
+{
+	m2v_clear_row(B, p);
+	for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+		const int q = st->col_pos[st->row_cols[j]];
+		if (q >= n_piv)
+			m2v_set_el(B, p, q - n_piv, 1);
+	}
+}
+
+/* Update the binary row p of B:  If p is a pivot row, compute its row
+ * of U12 = L11^(-1) A12, otherwise its row of A22 - A21 U12.  This
+ * only uses rows < min(p, n_piv), which must be final already.
+ */
+static void schur_row(const state* st, m2v* B, int n_piv, int p)
+{
+	int rows[BATCH];
+	int ones[BATCH];
+	const int row = st->rowperm[p];
+	const int lim = p < n_piv ? p : n_piv;
+	int k = 0;
+	for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+		const int q = st->col_pos[st->row_cols[j]];
+		if (q >= lim)
+			continue;
+		rows[k] = q;
+		ones[k] = 1;
+		if (++k == BATCH) {
+			m2v_multadd_rows(B, rows, ones, k, B, p);
+			k = 0;
+		}
+	}
+	if (k > 0)
+		m2v_multadd_rows(B, rows, ones, k, B, p);
+}
+
+/* Row rt of T := row r of B, as bytes 0 and 1 */
+static void expand_row(const m2v* B, int r, m256v* T, int rt)
+{
+	const int bpb = m2v__Bits_per_base;
+	const m2v_base* w = B->e + (size_t)r * B->row_stride;
+	uint8_t* t = T->e + m256v_get_el_offs(T, rt, 0);
+	int c = 0;
+
+	/* Four bits at a time:  the multiplication puts bit i into
+	 * bit 8i, without carries.
+	 */
+	for (; c + 4 <= B->n_col; c += 4) {
+		const uint32_t nib = (w[c / bpb] >> (c % bpb)) & 0xf;
+		const uint32_t x = (nib * 0x204081u) & 0x01010101u;
+		t[c] = x;
+		t[c + 1] = x >> 8;
+		t[c + 2] = x >> 16;
+		t[c + 3] = x >> 24;
+	}
+	for (; c < B->n_col; ++c)
+		t[c] = m2v_get_el(B, r, c);
+}
+
+/* The HDPC rows of A22 - A21 U12, in the first H rows of Dh.  The
+ * rows of U12 are expanded to bytes in batches, so that the products
+ * with the HDPC coefficients run on m256v_multadd_rows.
+ */
+static void schur_hdpc(state* st, const m2v* B, m256v* Dh,
+			const m256v* Hm, int n_sp, int n_piv)
+{
+	const int u = Dh->n_col;
+	m256v T = m256v_make(BATCH, u, st->expand);
+	int rows[BATCH];
+	uint8_t alphas[BATCH];
+	for (int i = 0; i < BATCH; ++i)
+		rows[i] = i;
+
+	for (int h = 0; h < Hm->n_row; ++h) {
+		st->dpos[h] = st->row_pos[n_sp + h] - n_piv;
+		for (int q = n_piv; q < n_piv + u; ++q)
+			m256v_set_el(Dh, h, q - n_piv,
+				m256v_get_el(Hm, h, st->colperm[q]));
+	}
+	for (int q0 = 0; q0 < n_piv; q0 += BATCH) {
+		const int n = (n_piv - q0 < BATCH) ? n_piv - q0 : BATCH;
+		for (int i = 0; i < n; ++i)
+			expand_row(B, q0 + i, &T, i);
+		for (int h = 0; h < Hm->n_row; ++h) {
+			for (int i = 0; i < n; ++i) {
+				alphas[i] = m256v_get_el(Hm, h,
+						st->colperm[q0 + i]);
+			}
+			m256v_multadd_rows(&T, rows, alphas, n, Dh, h);
+		}
+	}
+}
+
+/* Eliminate the dense rows [d0, d1) of Dh with the r_b binary pivot
+ * rows of Sb.  The columns are first brought into the order cp2 of
+ * the binary decomposition; the multipliers are left in the columns
+ * < r_b, which makes them the rows' part of L.
+ */
+static void eliminate_dense(state* st, const m2v* Sb, int r_b, m256v* Dh,
+				int d0, int d1)
+{
+	const int u = Dh->n_col;
+	uint8_t tmp[u];
+	for (int d = d0; d < d1; ++d) {
+		for (int c = 0; c < u; ++c)
+			tmp[c] = m256v_get_el(Dh, d, st->cp2[c]);
+		for (int c = 0; c < u; ++c)
+			m256v_set_el(Dh, d, c, tmp[c]);
+	}
+
+	m256v T = m256v_make(BATCH, u, st->expand);
+	for (int j0 = 0; j0 < r_b; j0 += BATCH) {
+		const int n = (r_b - j0 < BATCH) ? r_b - j0 : BATCH;
+		for (int i = 0; i < n; ++i)
+			expand_row(Sb, j0 + i, &T, i);
+		for (int d = d0; d < d1; ++d) {
+			for (int i = 0; i < n; ++i) {
+				const int j = j0 + i;
+				const uint8_t a = m256v_get_el(Dh, d, j);
+				if (a != 0 && j + 1 < u) {
+					m256v_multadd_row_from(&T, i, j + 1,
+							a, Dh, d);
+				}
+			}
+		}
+	}
+}
+
+/* Numerical phase:  Compute the Schur complement, its binary rows in
+ * B and its HDPC rows in Dh, and LU decompose it.  The ranks are
+ * recorded in st->rs; returns the rank of the Schur complement.
+ */
+static int factor_numeric(state* st, m2v* B, m256v* Dh, const parameters* P,
+				int n_sp, int n_rows, int n_piv)
+{
+	const int u = B->n_col;
+
+	/* U12 := L11^(-1) A12, and A22 -= A21 U12 for the binary rows,
+	 * in the order of the positions, so that the rows used are
+	 * final.  The positions of the HDPC rows stay zero.
+	 */
+	for (int p = 0; p < n_rows; ++p) {
+		const int row = st->rowperm[p];
+		if (row < n_sp) {
+			scatter_row(st, B, n_piv, row, p);
+			schur_row(st, B, n_piv, p);
+		} else {
+			m2v_clear_row(B, p);
+		}
+	}
+	m256v Hm = m256v_make(P->H, P->L, st->hdpc);
+	schur_hdpc(st, B, Dh, &Hm, n_sp, n_piv);
+
+	/* Phase 2:  LU decompose the binary rows, eliminate the HDPC
+	 * rows with them, and LU decompose the rest of the HDPC rows.
+	 */
+	m2v Sb = m2v_get_subview(B, n_piv, 0, n_rows - n_piv, u);
+	const int r_b = m2v_LU_decomp_inplace(&Sb, st->rp2, st->cp2);
+	eliminate_dense(st, &Sb, r_b, Dh, 0, P->H);
+	m256v Dd = m256v_get_subview(Dh, 0, r_b, P->H, u - r_b);
+	const int r_d = m256v_LU_decomp_inplace(&Dd, st->rp3, st->cp3);
+
+	st->rs->rank_b = r_b;
+	st->rs->n_dense = P->H;
+	st->rs->rank_d = r_d;
+	return r_b + r_d;
+}
+
+/* Reduce the binary row p of B, a row added by rq_inact_resume, with
+ * the r_b binary pivot rows of Sb.  If something remains right of the
+ * pivots, the row is stored in row d of Dh, with its multipliers in
+ * the columns < r_b, and 1 is returned.
+ */
+static int reduce_binary(const state* st, const m2v* B, const m2v* Sb,
+				int r_b, int p, m256v* Dh, int d)
+{
+	const int u = B->n_col;
+	m2v_Def(R, R_mem, 1, u)
+	for (int c = 0; c < u; ++c)
+		m2v_set_el(&R, 0, c, m2v_get_el(B, p, st->cp2[c]));
+	for (int j = 0; j < r_b; ++j) {
+		if (j + 1 < u && m2v_get_el(&R, 0, j))
+			m2v_multadd_row_from(Sb, j, j + 1, 1, &R, 0);
+	}
+
+	int c = r_b;
+	while (c < u && !m2v_get_el(&R, 0, c))
+		++c;
+	if (c == u)
+		return 0;
+	assert(d < Dh->n_row);
+	for (c = 0; c < u; ++c)
+		m256v_set_el(Dh, d, c, m2v_get_el(&R, 0, c));
+	return 1;
+}
+
+/* The LU decomposition of the Schur complement:  The first r_b rows
+ * are the binary pivot rows of Sb.  Then follow the dense rows, with
+ * their multipliers for the binary pivots in the columns < r_b of
+ * Dh, and the LU decomposition of the rest in the columns from r_b
+ * on, with the permutations rp3 and cp3.
+ */
+typedef struct {
+	const m2v* Sb;
+	const m256v* Dh;
+	const int* rp3;
+	const int* cp3;
+	int r_b;
+} schur_lu;
+
+static uint8_t lu_get(const schur_lu* F, int t, int s)
+{
+	const int r_b = F->r_b;
+	if (t < r_b) {
+		return m2v_get_el(F->Sb, t,
+				s < r_b ? s : r_b + F->cp3[s - r_b]);
+	}
+	if (s < r_b)
+		return m256v_get_el(F->Dh, F->rp3[t - r_b], s);
+	return m256v_get_el(F->Dh, t - r_b, s);
+}
+
+static void emit_entry(rq_ops_buf* b, int dst, int src, uint8_t v)
+{
+	if (v == 1)
+		rq_ops_emit(b, RQ_OP_XOR, dst, src, 1);
+	else if (v != 0)
+		rq_ops_emit(b, RQ_OP_MULADD, dst, src, v);
+}
+
+/* Emit z := L11^(-1) z for the pivot rows */
+static void emit_L11_inv(state* st, rq_ops_buf* b, int n_piv)
+{
+	const int* slot = st->colperm;
+	for (int p = 0; p < n_piv; ++p) {
+		const int row = st->rowperm[p];
+		for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+			const int q = st->col_pos[st->row_cols[j]];
+			if (q < p)
+				rq_ops_emit(b, RQ_OP_XOR, slot[p], slot[q], 1);
+		}
+	}
+}
+
+/* Emit the schedule.  The solution for position p is computed in row
+ * colperm[p] of the intermediate block, which is where it belongs.
+ */
+static void emit_schedule(state* st, rq_ops_buf* b, const schur_lu* S,
+				const parameters* P, int n_sp, int n_piv,
+				int n_ESIs)
+{
+	const int* slot = st->colperm;
+	const int u = S->Sb->n_col;
+	m256v Hm = m256v_make(P->H, P->L, st->hdpc);
+
+	/* Right hand side; the rows of the Schur complement are those
+	 * chosen by its LU decomposition.
+	 */
+	for (int p = 0; p < n_piv + u; ++p) {
+		const int row = (p < n_piv) ? st->rowperm[p]
+				: st->rowperm[n_piv + st->rp2[p - n_piv]];
+		if (row < n_ESIs)
+			rq_ops_emit(b, RQ_OP_LOAD, slot[p], row, 0);
+		else
+			rq_ops_emit(b, RQ_OP_ZERO, slot[p], 0, 0);
+	}
+
+	/* z1 = L11^(-1) b1 */
+	emit_L11_inv(st, b, n_piv);
+
+	/* b2' = b2 - A21 z1 */
+	for (int t = 0; t < u; ++t) {
+		const int row = st->rowperm[n_piv + st->rp2[t]];
+		const int dst = slot[n_piv + t];
+		if (row < n_sp) {
+			for (int j = st->row_ptr[row];
+					j < st->row_ptr[row + 1]; ++j) {
+				const int q = st->col_pos[st->row_cols[j]];
+				if (q < n_piv)
+					rq_ops_emit(b, RQ_OP_XOR, dst,
+							slot[q], 1);
+			}
+		} else {
+			for (int q = 0; q < n_piv; ++q) {
+				emit_entry(b, dst, slot[q],
+					m256v_get_el(&Hm, row - n_sp, slot[q]));
+			}
+		}
+	}
+
+	/* x2 = S^(-1) b2' */
+	for (int t = 1; t < u; ++t) {
+		for (int s = 0; s < t; ++s) {
+			emit_entry(b, slot[n_piv + t], slot[n_piv + s],
+					lu_get(S, t, s));
+		}
+	}
+	for (int t = u - 1; t >= 0; --t) {
+		for (int s = t + 1; s < u; ++s) {
+			emit_entry(b, slot[n_piv + t], slot[n_piv + s],
+					lu_get(S, t, s));
+		}
+		const uint8_t d = lu_get(S, t, t);
+		if (d != 1) {
+			rq_ops_emit(b, RQ_OP_SCALE, slot[n_piv + t], 0,
+					gf256_inv(d));
+		}
+	}
+
+	/* x1 = L11^(-1) (L11 z1 - A12 x2).  Going through the rows in
+	 * reverse order, the z1 entries used are not yet overwritten.
+	 */
+	for (int p = n_piv - 1; p >= 0; --p) {
+		const int row = st->rowperm[p];
+		for (int j = st->row_ptr[row]; j < st->row_ptr[row + 1]; ++j) {
+			const int q = st->col_pos[st->row_cols[j]];
+			if (q != p)
+				rq_ops_emit(b, RQ_OP_XOR, slot[p], slot[q], 1);
+		}
+	}
+	emit_L11_inv(st, b, n_piv);
+}
+
+/* Combine the permutations of the two parts of the Schur complement's
+ * LU decomposition, fold the column permutation into colperm and
+ * col_pos, and emit the schedule.
+ */
+static void finish(state* st, rq_ops_buf* b, m2v* B, const m256v* Dh,
+			const parameters* P, int n_sp, int n_piv, int n_ESIs)
+{
+	const int u = B->n_col;
+	const int r_b = st->rs->rank_b;
+	for (int k = 0; k < u - r_b; ++k) {
+		st->tmp[k] = st->cp2[r_b + st->cp3[k]];
+		st->rp2[r_b + k] = st->dpos[st->rp3[k]];
+	}
+	memcpy(st->cp2 + r_b, st->tmp, (u - r_b) * sizeof(int));
+
+	for (int t = 0; t < u; ++t)
+		st->tmp[t] = st->colperm[n_piv + st->cp2[t]];
+	for (int t = 0; t < u; ++t) {
+		st->colperm[n_piv + t] = st->tmp[t];
+		st->col_pos[st->tmp[t]] = n_piv + t;
+	}
+
+	const m2v Sb = m2v_get_subview(B, n_piv, 0, u, u);
+	const schur_lu S = {
+		.Sb = &Sb,
+		.Dh = Dh,
+		.rp3 = st->rp3,
+		.cp3 = st->cp3,
+		.r_b = r_b,
+	};
+	emit_schedule(st, b, &S, P, n_sp, n_piv, n_ESIs);
+	st->rs->valid = 0;
+}
+
+/* Keep the state of a compilation that ended with a Schur complement
+ * of rank less than u, for rq_inact_resume.  The ranks are in st->rs
+ * already.
+ */
+static void keep(state* st, int n_ESIs, int n_piv, int u)
+{
+	resume_info* rs = st->rs;
+	rs->valid = 1;
+	rs->n_ESIs = n_ESIs;
+	rs->n_piv = n_piv;
+	rs->deficit = u - rs->rank_b - rs->rank_d;
+}
+
+int rq_inact_compile(rq_ops_buf* b,
+			const parameters* P,
+			int n_ESIs,
+			const uint32_t* ESIs,
+			int n_ESIs_max,
+			void* scratch,
+			size_t scratch_size)
+{
+	int n_rows, n_cols;
+	rq_matrix_get_dim(P, n_ESIs, &n_rows, &n_cols);
+	const int n_sp = n_rows - P->H;
+
+	arena a = { .p = scratch, .left = scratch_size, .used = 0 };
+	state st;
+	alloc_state(&st, &a, P, n_ESIs_max);
+	if (a.used > scratch_size || n_ESIs > n_ESIs_max)
+		return RQ_INACT_NOMEM;
+	st.rs->valid = 0;
+	if (n_rows < n_cols) {
+		st.rs->deficit = n_cols - n_rows;
+		return RQ_INACT_SINGULAR;
+	}
+
+	build_sparse(&st, P, n_ESIs, ESIs);
+	const int n_piv = phase1(&st, P, n_sp, n_rows);
+	const int u = n_cols - n_piv;
+
+	/* Permutations in "from" format */
+	for (int row = 0; row < n_rows; ++row)
+		st.rowperm[st.row_pos[row]] = row;
+	for (int c = 0; c < n_cols; ++c)
+		st.colperm[st.col_pos[c]] = c;
+
+	m2v B = m2v_make(n_rows, u, st.bin);
+	m256v Dh = m256v_make(dense_rows_max(P, n_ESIs_max), u, st.dense);
+	const int rank2 = factor_numeric(&st, &B, &Dh, P, n_sp, n_rows, n_piv);
+	if (rank2 < u) {
+		keep(&st, n_ESIs, n_piv, u);
+		return RQ_INACT_SINGULAR;
+	}
+
+	finish(&st, b, &B, &Dh, P, n_sp, n_piv, n_ESIs);
+	return RQ_INACT_OK;
+}
+
+int rq_inact_resume(rq_ops_buf* b,
+			const parameters* P,
+			int n_ESIs,
+			const uint32_t* ESIs,
+			int n_ESIs_max,
+			void* scratch,
+			size_t scratch_size)
+{
+	arena a = { .p = scratch, .left = scratch_size, .used = 0 };
+	state st;
+	alloc_state(&st, &a, P, n_ESIs_max);
+	if (a.used > scratch_size || n_ESIs > n_ESIs_max)
+		return RQ_INACT_NOMEM;
+	const resume_info rs = *st.rs;
+	if (!rs.valid || n_ESIs < rs.n_ESIs) {
+		return rq_inact_compile(b, P, n_ESIs, ESIs, n_ESIs_max,
+				scratch, scratch_size);
+	}
+
+	int n_old, n_rows, n_cols;
+	rq_matrix_get_dim(P, rs.n_ESIs, &n_old, NULL);
+	rq_matrix_get_dim(P, n_ESIs, &n_rows, &n_cols);
+	const int n_sp = n_rows - P->H;
+	const int n_new = n_ESIs - rs.n_ESIs;
+	const int n_piv = rs.n_piv;
+	const int u = n_cols - n_piv;
+
+	/* The rows of the new ESIs are inserted after the old ESIs, and
+	 * placed after all the old rows.  The positions of the old rows,
+	 * and everything computed for them, stay the same.
+	 */
+	for (int row = n_old - 1; row >= rs.n_ESIs; --row)
+		st.row_pos[row + n_new] = st.row_pos[row];
+	for (int i = 0; i < n_new; ++i)
+		st.row_pos[rs.n_ESIs + i] = n_old + i;
+	for (int row = 0; row < n_rows; ++row)
+		st.rowperm[st.row_pos[row]] = row;
+	build_sparse(&st, P, n_ESIs, ESIs);
+
+	/* Their rows of the Schur complement, reduced with the binary
+	 * pivots.  What remains of them becomes a dense row.
+	 */
+	m2v B = m2v_make(n_rows, u, st.bin);
+	m256v Dh = m256v_make(dense_rows_max(P, n_ESIs_max), u, st.dense);
+	m2v Sb = m2v_get_subview(&B, n_piv, 0, n_old - n_piv, u);
+	const int r_b = rs.rank_b;
+	int n_dense = rs.n_dense;
+	for (int p = n_old; p < n_rows; ++p) {
+		scatter_row(&st, &B, n_piv, st.rowperm[p], p);
+		schur_row(&st, &B, n_piv, p);
+		if (reduce_binary(&st, &B, &Sb, r_b, p, &Dh, n_dense))
+			st.dpos[n_dense++] = p - n_piv;
+	}
+
+	/* Continue the LU decomposition of the dense part with them */
+	m256v Dd = m256v_get_subview(&Dh, 0, r_b, n_dense, u - r_b);
+	st.rs->n_dense = n_dense;
+	st.rs->rank_d = m256v_LU_decomp_append(&Dd, rs.n_dense, rs.rank_d,
+						st.rp3, st.cp3);
+	if (r_b + st.rs->rank_d < u) {
+		keep(&st, n_ESIs, n_piv, u);
+		return RQ_INACT_SINGULAR;
+	}
+
+	finish(&st, b, &B, &Dh, P, n_sp, n_piv, n_ESIs);
+	return RQ_INACT_OK;
+}
+
+int rq_inact_deficit(const void* scratch)
+{
+	return ((const resume_info*)scratch)->deficit;
+}
@@ -0,0 +1,106 @@
+#ifndef RQ_INACT_H
+#define RQ_INACT_H
+
+/**	@file rq_inact.h
+ *
+ *	Solution of the RQ system by inactivation decoding.
+ *
+ *	This follows the approach of RFC 6330 Sect 5.4.2:  The sparse LT
+ *	and LDPC rows are eliminated first on a sparse representation,
+ *	declaring columns "inactive" as needed.  Only the matrix formed
+ *	by the inactive columns and the remaining rows (including the
+ *	HDPC rows) is factored densely:  its binary rows bit-packed over
+ *	GF(2), and the HDPC rows over GF(256).
+ *
+ *	The result is a schedule of row operations (see rq_ops.h) that
+ *	computes the intermediate block from the received symbols.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "parameters.h"
+#include "rq_ops.h"
+
+/* Return values of rq_inact_compile */
+#define RQ_INACT_OK		0
+#define RQ_INACT_SINGULAR	(-1)	/**< Matrix rank is less than L */
+#define RQ_INACT_NOMEM		(-2)	/**< Scratch memory too small */
+
+/**	Size of the scratch memory needed by rq_inact_compile.
+ *
+ *	It allows for all L columns to be inactive:  With random ESIs,
+ *	far fewer are, but with e.g. only repair symbols of high LT
+ *	degree, u can be a sizable fraction of L.
+ *
+ *	@param	n_ESIs
+ *		The maximum number of ESIs the compilation is run
+ *		with, including the ones added for rq_inact_resume.
+ */
+size_t rq_inact_scratch_size(const parameters* P, int n_ESIs);
+
+/**	Bound on the length of the schedule.
+ *
+ *	Unlike the scratch memory, this only allows for the number of
+ *	inactive columns seen with random ESIs, with a wide margin;
+ *	the schedules for ESI sets leaving more columns inactive may
+ *	be longer.  rq_ops_emit counts the operations that do not fit.
+ */
+size_t rq_inact_ops_max(const parameters* P, int n_ESIs);
+
+/**	Compile the schedule solving the RQ system.
+ *
+ *	The schedule computes the L intermediate symbols in X from the
+ *	symbols with the given ESIs in Y (in that order).
+ *
+ *	If the matrix does not have full rank, the state of the
+ *	elimination is kept in the scratch memory, for rq_inact_resume.
+ *
+ *	@param	b
+ *		Buffer receiving the schedule.  Overflows are reported
+ *		by rq_ops_overflow().
+ *
+ *	@param	n_ESIs_max
+ *		The number of ESIs the scratch memory is sized for.
+ *
+ *	@param	scratch
+ *		Scratch memory of at least rq_inact_scratch_size()
+ *		bytes for n_ESIs_max ESIs, 16 byte aligned.
+ *
+ *	@return	RQ_INACT_OK on success, or one of the other RQ_INACT_*
+ *		codes.
+ */
+int rq_inact_compile(rq_ops_buf* b,
+			const parameters* P,
+			int n_ESIs,
+			const uint32_t* ESIs,
+			int n_ESIs_max,
+			void* scratch,
+			size_t scratch_size);
+
+/**	Continue a compilation that returned RQ_INACT_SINGULAR.
+ *
+ *	ESIs must be the ESIs of the failed compilation, followed by
+ *	new ones, and the scratch memory must be unchanged since.  The
+ *	rows of the new ESIs are eliminated against the existing
+ *	factorization, and its LU decomposition is continued; nothing
+ *	is redone.  If there is no state to continue from (the matrix
+ *	had fewer rows than columns), this is rq_inact_compile.
+ *
+ *	Parameters and return values are as for rq_inact_compile.
+ */
+int rq_inact_resume(rq_ops_buf* b,
+			const parameters* P,
+			int n_ESIs,
+			const uint32_t* ESIs,
+			int n_ESIs_max,
+			void* scratch,
+			size_t scratch_size);
+
+/**	After RQ_INACT_SINGULAR, the number of additional linearly
+ *	independent rows needed, L minus the rank of the matrix.  If the
+ *	matrix had fewer rows than columns, this is only a lower bound.
+ */
+int rq_inact_deficit(const void* scratch);
+
+#endif /* RQ_INACT_H */
@@ -62,3 +62,40 @@ void rq_matrix_generate(m256v* M,
 
 	assert(rowoffs == n_rows);
 }
+
+int rq_matrix_nnz_max(const parameters* P, int n_ESIs)
+{
+	/* LDPC:  Up to 3 per column of G_LDPC,1, the identity, and 2
+	 * per row of G_LDPC,2.
+	 */
+	const int n_pad = P->Kprime - P->K;
+	return (n_ESIs + n_pad) * LT_MAX_ROW_WEIGHT + 3 * P->B + 3 * P->S;
+}
+
+void rq_matrix_generate_hybrid(mhyb* M,
+			const parameters* P,
+			int n_ESIs,
+			const uint32_t* ESIs)
+{
+	const int n_pad = P->Kprime - P->K;
+	assert(M->n_sp == 0);
+	assert(M->n_sp_max >= n_ESIs + n_pad + P->S);
+	assert(M->nnz_max >= rq_matrix_nnz_max(P, n_ESIs));
+	assert(M->D.n_row == P->H);
+
+	/* LT rows, of the ISIs of the ESIs, and of the padding symbols */
+	uint32_t ISIs[LT_BATCH];
+	for (int i0 = 0; i0 < n_ESIs + n_pad; i0 += LT_BATCH) {
+		int m = 0;
+		for (int i = i0; i < n_ESIs + n_pad && m < LT_BATCH; ++i) {
+			if (i < n_ESIs)
+				ISIs[m++] = ESIs[i] + (ESIs[i] >= P->K ? n_pad : 0);
+			else
+				ISIs[m++] = P->K + (i - n_ESIs);
+		}
+		lt_generate_sparse(M, P, m, ISIs);
+	}
+
+	ldpc_generate_sparse(M, P);
+	hdpc_generate_mat(&M->D, P);
+}
@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "m256v.h"
+#include "mhyb.h"
 #include "parameters.h"
 
 void rq_matrix_get_dim(const parameters* P,
@@ -23,4 +24,23 @@ void rq_matrix_generate(m256v* M,
 			int n_ESIs,
 			const uint32_t* ESIs);
 
+/**	Upper bound on the number of nonzeros of the LT and LDPC rows. */
+int rq_matrix_nnz_max(const parameters* P, int n_ESIs);
+
+/**	Create the RQ matrix as a hybrid matrix.
+ *
+ *	The LT and LDPC rows are appended to the sparse rows of M,
+ *	which needs to be empty, and the HDPC rows are the dense rows.
+ *	This takes time and memory proportional to the number of
+ *	nonzeros, apart from the H dense rows.
+ *
+ *	@param	M
+ *		Hybrid matrix with capacity for the sparse rows and
+ *		rq_matrix_nnz_max nonzeros, with H dense rows.
+ */
+void rq_matrix_generate_hybrid(mhyb* M,
+			const parameters* P,
+			int n_ESIs,
+			const uint32_t* ESIs);
+
 #endif /* RQ_MATRIX_H */
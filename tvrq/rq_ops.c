@@ -0,0 +1,361 @@
+#include <assert.h>
+#include <string.h>
+
+#include "gf256.h"
+#include "rq_ops.h"
+
+void rq_ops_emit(rq_ops_buf* b, int op, int dst, uint32_t src, uint8_t alpha)
+{
+	assert(dst >= 0 && dst < RQ_OPS_MAX_ROWS);
+	if (b->n < b->n_max) {
+		rq_op* o = &b->ops[b->n];
+		o->src = src;
+		o->dst = (uint16_t)dst;
+		o->op = (uint8_t)op;
+		o->alpha = alpha;
+	}
+	++b->n;
+}
+
+int rq_ops_overflow(const rq_ops_buf* b)
+{
+	return b->n > b->n_max;
+}
+
+size_t rq_ops_from_lu_max(int n)
+{
+	/* One load and one scale per row, and one operation per entry
+	 * outside of the diagonal.
+	 */
+	return (size_t)n * n + n;
+}
+
+void rq_ops_from_lu(rq_ops_buf* b, const m256v* LU, const int* rowperm,
+			int n_Y)
+{
+	const int n = LU->n_col;
+	assert(LU->n_row >= n);
+
+	/* Row permutation */
+	for (int i = 0; i < n; ++i) {
+		if (rowperm[i] < n_Y)
+			rq_ops_emit(b, RQ_OP_LOAD, i, rowperm[i], 0);
+		else
+			rq_ops_emit(b, RQ_OP_ZERO, i, 0, 0);
+	}
+
+	/* L^(-1) */
+	for (int i = 1; i < n; ++i) {
+		for (int j = 0; j < i; ++j) {
+			const uint8_t v = m256v_get_el(LU, i, j);
+			if (v == 1)
+				rq_ops_emit(b, RQ_OP_XOR, i, j, 1);
+			else if (v != 0)
+				rq_ops_emit(b, RQ_OP_MULADD, i, j, v);
+		}
+	}
+
+	/* U^(-1) */
+	for (int i = n - 1; i >= 0; --i) {
+		for (int j = i + 1; j < n; ++j) {
+			const uint8_t v = m256v_get_el(LU, i, j);
+			if (v == 1)
+				rq_ops_emit(b, RQ_OP_XOR, i, j, 1);
+			else if (v != 0)
+				rq_ops_emit(b, RQ_OP_MULADD, i, j, v);
+		}
+		const uint8_t d = m256v_get_el(LU, i, i);
+		assert(d != 0);
+		if (d != 1)
+			rq_ops_emit(b, RQ_OP_SCALE, i, 0, gf256_inv(d));
+	}
+}
+
+static int is_acc(int op)
+{
+	return op == RQ_OP_XOR || op == RQ_OP_MULADD || op == RQ_OP_MULTI;
+}
+
+void rq_ops_prune(rq_ops_buf* b, uint8_t* live)
+{
+	/* Backwards, a row is live if its value is used later on;
+	 * loads and clears end its live range.  The kept operations
+	 * are collected at the end of the buffer.
+	 */
+	size_t w = b->n;
+	for (size_t i = b->n; i-- > 0; ) {
+		const rq_op o = b->ops[i];
+		assert(o.op != RQ_OP_MULTI && o.op != RQ_OP_ARG);
+		if (!live[o.dst])
+			continue;
+		if (o.op == RQ_OP_LOAD || o.op == RQ_OP_ZERO)
+			live[o.dst] = 0;
+		else if (o.op != RQ_OP_SCALE)
+			live[o.src] = 1;
+		b->ops[--w] = o;
+	}
+	memmove(b->ops, b->ops + w, (b->n - w) * sizeof(rq_op));
+	b->n -= w;
+}
+
+size_t rq_ops_optimize(rq_ops_buf* b, int n_rows)
+{
+	assert(!rq_ops_overflow(b));
+	rq_op* ops = b->ops;
+	const size_t n_in = b->n;
+
+	/* Sink the loads and clears.  Ops are only ever written to
+	 * positions that have already been read, so this can be done in
+	 * place.
+	 */
+	enum { NONE, LOAD, ZERO };
+	uint8_t pend[n_rows];
+	uint32_t pend_src[n_rows];
+	memset(pend, NONE, sizeof(pend));
+	size_t w = 0;
+#define RELEASE(r) \
+	do { \
+		const int RELEASE_r = (r); \
+		if (pend[RELEASE_r] == LOAD) { \
+			ops[w++] = (rq_op){ .src = pend_src[RELEASE_r], \
+				.dst = RELEASE_r, .op = RQ_OP_LOAD }; \
+		} else if (pend[RELEASE_r] == ZERO) { \
+			ops[w++] = (rq_op){ .dst = RELEASE_r, \
+				.op = RQ_OP_ZERO }; \
+		} \
+		pend[RELEASE_r] = NONE; \
+	} while (0)
+	for (size_t i = 0; i < n_in; ++i) {
+		const rq_op o = ops[i];
+		assert(o.op <= RQ_OP_SCALE);
+		if (o.op == RQ_OP_LOAD || o.op == RQ_OP_ZERO) {
+			pend[o.dst] = (o.op == RQ_OP_LOAD) ? LOAD : ZERO;
+			pend_src[o.dst] = o.src;
+			continue;
+		}
+		if (o.op != RQ_OP_SCALE)
+			RELEASE(o.src);
+		RELEASE(o.dst);
+		ops[w++] = o;
+	}
+	for (int r = 0; r < n_rows; ++r)
+		RELEASE(r);
+#undef RELEASE
+	assert(w <= n_in);
+
+	/* Fuse runs of accumulations, and move scalings in front */
+	const size_t n = w;
+	w = 0;
+	for (size_t i = 0; i < n; ) {
+		if (!is_acc(ops[i].op)) {
+			ops[w++] = ops[i++];
+			continue;
+		}
+		const int dst = ops[i].dst;
+		size_t e = i + 1;
+		while (e < n && is_acc(ops[e].op) && ops[e].dst == dst)
+			++e;
+		const size_t len = e - i;
+
+		uint8_t scale = 1;
+		if (e < n && ops[e].op == RQ_OP_SCALE && ops[e].dst == dst) {
+			scale = ops[e].alpha;
+			memmove(ops + w + 1, ops + i, len * sizeof(rq_op));
+			ops[w++] = (rq_op){ .dst = dst, .op = RQ_OP_SCALE,
+						.alpha = scale };
+			++e;
+		} else {
+			memmove(ops + w, ops + i, len * sizeof(rq_op));
+		}
+		for (size_t j = 0; j < len; ++j) {
+			rq_op* o = &ops[w + j];
+			assert(o->src != (uint32_t)dst);
+			o->alpha = gf256_mul(o->alpha, scale);
+			if (len > 1)
+				o->op = (j == 0) ? RQ_OP_MULTI : RQ_OP_ARG;
+			else
+				o->op = (o->alpha == 1) ? RQ_OP_XOR : RQ_OP_MULADD;
+		}
+		w += len;
+		i = e;
+	}
+	b->n = w;
+
+	return rq_ops_count_units(ops, w);
+}
+
+/* Length of the unit starting at ops[i] */
+static size_t unit_len(const rq_op* ops, size_t i, size_t n)
+{
+	size_t e = i;
+	const int op = ops[e].op;
+	if ((op == RQ_OP_LOAD || op == RQ_OP_ZERO || op == RQ_OP_SCALE)
+	  && e + 1 < n && is_acc(ops[e + 1].op)
+	  && ops[e + 1].dst == ops[e].dst)
+		++e;
+	if (ops[e].op == RQ_OP_MULTI) {
+		++e;
+		while (e < n && ops[e].op == RQ_OP_ARG)
+			++e;
+		return e - i;
+	}
+	return e + 1 - i;
+}
+
+size_t rq_ops_count_units(const rq_op* ops, size_t n_ops)
+{
+	size_t n_units = 0;
+	for (size_t i = 0; i < n_ops; i += unit_len(ops, i, n_ops))
+		++n_units;
+	return n_units;
+}
+
+int rq_ops_working_rows(const rq_op* ops, size_t n_ops, int n_max)
+{
+	/* Number of units by rows touched, up to s_max */
+	const int s_max = (n_max + 1) / 2;
+	size_t cnt[s_max + 1];
+	memset(cnt, 0, sizeof(cnt));
+	for (size_t i = 0; i < n_ops; ) {
+		const size_t n = unit_len(ops, i, n_ops);
+		++cnt[(n + 1 < (size_t)s_max) ? n + 1 : (size_t)s_max];
+		i += n;
+	}
+
+	size_t n_units = 0;
+	for (int s = s_max; s > 0; --s) {
+		n_units += cnt[s];
+		if (n_units >= (size_t)s)
+			return (2 * s < n_max) ? 2 * s : n_max;
+	}
+	return 0;
+}
+
+int rq_ops_validate(const rq_op* ops, size_t n_ops, int n_rows_Y, int n_rows_X)
+{
+	int multi_dst = -1;	// Target of the current MULTI op, if any
+	for (size_t i = 0; i < n_ops; ++i) {
+		const rq_op o = ops[i];
+		if (o.op == RQ_OP_ARG) {
+			if (multi_dst < 0 || o.src >= (uint32_t)n_rows_X
+			  || o.src == (uint32_t)multi_dst)
+				return -1;
+			continue;
+		}
+		multi_dst = -1;
+		if (o.dst >= n_rows_X)
+			return -1;
+		switch (o.op) {
+		case RQ_OP_LOAD:
+			if (o.src >= (uint32_t)n_rows_Y)
+				return -1;
+			break;
+		case RQ_OP_ZERO:
+		case RQ_OP_SCALE:
+			break;
+		case RQ_OP_MULTI:
+			multi_dst = o.dst;
+			/* Fall through */
+		case RQ_OP_XOR:
+		case RQ_OP_MULADD:
+			if (o.src >= (uint32_t)n_rows_X || o.src == o.dst)
+				return -1;
+			break;
+		default:
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* Prefetch the first lines of the rows a unit reads */
+static void prefetch_unit(const rq_op* u, size_t len,
+				const m256v* Y, const m256v* X)
+{
+	const size_t max_terms = 8;
+	for (size_t j = 0; j < len && j < max_terms; ++j) {
+		const uint8_t* p;
+		if (u[j].op == RQ_OP_LOAD)
+			p = Y->e + (size_t)u[j].src * Y->rstride;
+		else if (u[j].op == RQ_OP_ZERO || u[j].op == RQ_OP_SCALE)
+			p = X->e + (size_t)u[j].dst * X->rstride;
+		else
+			p = X->e + (size_t)u[j].src * X->rstride;
+		__builtin_prefetch(p);
+		__builtin_prefetch(p + 64);
+	}
+	if (is_acc(u[len - 1].op) || u[len - 1].op == RQ_OP_ARG) {
+		const uint8_t* t = X->e + (size_t)u[0].dst * X->rstride;
+		__builtin_prefetch(t, 1);
+		__builtin_prefetch(t + 64, 1);
+	}
+}
+
+static void exec_unit(const rq_op* u, size_t len, const m256v* Y, m256v* X)
+{
+	const int dst = u[0].dst;
+	size_t j = 1;
+	switch (u[0].op) {
+	case RQ_OP_LOAD:
+		m256v_copy_row(Y, u[0].src, X, dst);
+		break;
+	case RQ_OP_ZERO:
+		m256v_clear_row(X, dst);
+		break;
+	case RQ_OP_SCALE:
+		m256v_mult_row(X, dst, u[0].alpha);
+		break;
+	default:
+		j = 0;
+		break;
+	}
+
+	/* Accumulation; the terms are all in u[j..len) */
+	enum { batch = 64 };
+	int rows[batch];
+	uint8_t alphas[batch];
+	int k = 0;
+	for (; j < len; ++j) {
+		assert(is_acc(u[j].op) || u[j].op == RQ_OP_ARG);
+		rows[k] = u[j].src;
+		alphas[k] = u[j].alpha;
+		if (++k == batch) {
+			m256v_multadd_rows(X, rows, alphas, k, X, dst);
+			k = 0;
+		}
+	}
+	if (k > 0)
+		m256v_multadd_rows(X, rows, alphas, k, X, dst);
+}
+
+void rq_ops_execute(const rq_op* ops, size_t n_ops, const m256v* Y, m256v* X)
+{
+	size_t len = (n_ops > 0) ? unit_len(ops, 0, n_ops) : 0;
+	for (size_t i = 0; i < n_ops; ) {
+		const size_t i_next = i + len;
+		size_t len_next = 0;
+		if (i_next < n_ops) {
+			len_next = unit_len(ops, i_next, n_ops);
+			prefetch_unit(ops + i_next, len_next, Y, X);
+		}
+		exec_unit(ops + i, len, Y, X);
+		i = i_next;
+		len = len_next;
+	}
+}
+
+void rq_ops_execute_strips(const rq_op* ops, size_t n_ops,
+				const m256v* Y, m256v* X, int strip)
+{
+	assert(Y->n_col == X->n_col);
+	if (strip <= 0 || strip >= X->n_col) {
+		rq_ops_execute(ops, n_ops, Y, X);
+		return;
+	}
+	for (int c0 = 0; c0 < X->n_col; c0 += strip) {
+		const int w = (X->n_col - c0 < strip) ? X->n_col - c0 : strip;
+		const m256v Ys = m256v_get_subview(Y, 0, c0, Y->n_row, w);
+		m256v Xs = m256v_get_subview(X, 0, c0, X->n_row, w);
+		rq_ops_execute(ops, n_ops, &Ys, &Xs);
+	}
+}
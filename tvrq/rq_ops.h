@@ -0,0 +1,164 @@
+#ifndef RQ_OPS_H
+#define RQ_OPS_H
+
+/**	@file rq_ops.h
+ *
+ *	Row operation schedules.
+ *
+ *	A schedule is a list of operations on the rows of a symbol matrix
+ *	X, which may read rows from an input matrix Y.  The decoders
+ *	compile the solution of the RQ system into such a schedule; the
+ *	schedule only contains the operations with nonzero multipliers,
+ *	and its row indices already include all the row and column
+ *	permutations.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "m256v.h"
+
+/* Operation codes */
+#define RQ_OP_LOAD	0	/**< X[dst] = Y[src] */
+#define RQ_OP_ZERO	1	/**< X[dst] = 0 */
+#define RQ_OP_XOR	2	/**< X[dst] += X[src]; alpha is 1 */
+#define RQ_OP_MULADD	3	/**< X[dst] += alpha * X[src] */
+#define RQ_OP_SCALE	4	/**< X[dst] = alpha * X[dst] */
+#define RQ_OP_MULTI	5	/**< X[dst] += alpha * X[src], and the
+				     terms of the following ARG ops */
+#define RQ_OP_ARG	6	/**< Term of a MULTI op; dst is unused */
+
+/**	Largest number of rows X can have. */
+#define RQ_OPS_MAX_ROWS	65536
+
+typedef struct {
+	uint32_t src;
+	uint16_t dst;
+	uint8_t op;
+	uint8_t alpha;
+} rq_op;
+
+/**	Buffer collecting a schedule. */
+typedef struct {
+	rq_op* ops;
+	size_t n;		/* Operations emitted so far */
+	size_t n_max;		/* Capacity of ops */
+} rq_ops_buf;
+
+/**	Append an operation.
+ *
+ *	If the buffer is full, the operation is only counted;
+ *	rq_ops_overflow tells whether that happened.
+ */
+void rq_ops_emit(rq_ops_buf* b, int op, int dst, uint32_t src, uint8_t alpha);
+
+/**	Check if more operations were emitted than fit the buffer. */
+int rq_ops_overflow(const rq_ops_buf* b);
+
+/**	Upper bound on the schedule length of rq_ops_from_lu. */
+size_t rq_ops_from_lu_max(int n);
+
+/**	Emit the schedule that solves a system given by an LU factorization.
+ *
+ *	The factorization is one computed by m256v_LU_decomp_inplace,
+ *	with full column rank and without column permutation; only the
+ *	first n_col rows of LU are used.  The schedule computes the
+ *	solution X of A X = Y, where the rows r >= n_Y of Y are zero
+ *	and not stored.
+ *
+ *	@param	rowperm
+ *		The row permutation of the factorization.
+ */
+void rq_ops_from_lu(rq_ops_buf* b, const m256v* LU, const int* rowperm,
+			int n_Y);
+
+/**	Remove the operations not needed for some rows of X.
+ *
+ *	Drops the operations that do not contribute to the final value
+ *	of the rows marked in live.  The other rows of X are left
+ *	undefined by the pruned schedule.  The schedule must not be
+ *	optimized yet.
+ *
+ *	@param	live
+ *		One flag per row of X, nonzero for the rows needed.
+ *		Used as scratch memory.
+ */
+void rq_ops_prune(rq_ops_buf* b, uint8_t* live);
+
+/**	Optimize a schedule for execution.
+ *
+ *	The optimized schedule computes the same result with fewer,
+ *	larger operations:
+ *
+ *	- Loads and clears are moved down to right before the first
+ *	  operation using the row, so that the row is still in cache
+ *	  when it is worked on.
+ *	- Runs of accumulations into the same row are fused into MULTI
+ *	  operations, which are executed in one pass over the target
+ *	  row.
+ *	- A scaling following an accumulation is moved in front of it,
+ *	  with the multipliers of the accumulation adjusted; the
+ *	  executor performs a scaling followed by an accumulation into
+ *	  the same row as a single unit.
+ *
+ *	@param	n_rows
+ *		Number of rows of X.
+ *
+ *	@return	The number of units the executor dispatches for the
+ *		optimized schedule (see rq_ops_count_units).
+ */
+size_t rq_ops_optimize(rq_ops_buf* b, int n_rows);
+
+/**	Count the units the executor dispatches for a schedule.
+ *
+ *	A unit is an accumulation (single or MULTI), optionally preceded
+ *	by a load, clear or scale of its target row, or any other single
+ *	operation.
+ */
+size_t rq_ops_count_units(const rq_op* ops, size_t n_ops);
+
+/**	Estimate the number of rows the units of a schedule work on
+ *	together.
+ *
+ *	This is twice the largest s such that at least s units touch
+ *	at least s rows each.  Triangular solves on u rows have units
+ *	touching 1 to u rows, which gives about u; the few long units
+ *	of dense rows that stream most rows once hardly count.
+ *
+ *	@param	n_max
+ *		The result is capped at this.
+ */
+int rq_ops_working_rows(const rq_op* ops, size_t n_ops, int n_max);
+
+/**	Check that a schedule is well formed.
+ *
+ *	Checks the operation codes, that the row indices are within
+ *	the given numbers of rows of Y and X, and that ARG operations
+ *	only follow MULTI or ARG operations and do not refer to their
+ *	target row.  A schedule passing this can be run without
+ *	accessing memory outside of Y and X.
+ *
+ *	@return	0 if the schedule is well formed, -1 otherwise.
+ */
+int rq_ops_validate(const rq_op* ops, size_t n_ops, int n_rows_Y, int n_rows_X);
+
+/**	Run a schedule. */
+void rq_ops_execute(const rq_op* ops, size_t n_ops, const m256v* Y, m256v* X);
+
+/**	Run a schedule strip by strip.
+ *
+ *	The columns of Y and X are split into strips of the given width,
+ *	and the whole schedule is run on one strip after the other.  The
+ *	row operations act on each column independently, so the result
+ *	is the same as with rq_ops_execute; narrow strips keep the rows
+ *	touched by the schedule in cache, at the cost of one dispatch of
+ *	each operation per strip.
+ *
+ *	@param	strip
+ *		Strip width in bytes; if <= 0 or at least the number of
+ *		columns, the schedule is run in one pass.
+ */
+void rq_ops_execute_strips(const rq_op* ops, size_t n_ops,
+				const m256v* Y, m256v* X, int strip);
+
+#endif /* RQ_OPS_H */
@@ -0,0 +1,202 @@
+#include <stdlib.h>
+
+#include "rq_ops_pack.h"
+
+/* Packed format
+ *
+ * Each operation other than ARG starts with a tag byte holding the
+ * operation code in bits 0-2, and in bit 3 a flag telling that the
+ * multiplier is 1 (and not stored).  It is followed by:
+ *
+ *	- the target row, as difference to the previous target row;
+ *	- for LOAD, the row of Y, as difference to the previous LOAD;
+ *	- for XOR, MULADD and MULTI, the source row, as difference to
+ *	  the previous source row of X;
+ *	- for MULADD, SCALE and MULTI, the multiplier unless it is 1;
+ *	- for MULTI, the number of ARG operations following it, and
+ *	  for each of them the source row difference shifted left by
+ *	  one, with the multiplier-is-1 flag in bit 0, and the
+ *	  multiplier unless it is 1.  The terms are sorted by source
+ *	  row, which makes the differences small.
+ *
+ * The differences are zigzag coded, and all integers are stored as
+ * little-endian base 128 varints.
+ */
+
+#define FLAG_ALPHA1	0x08
+
+/* Longest varint of a 64 bit value */
+#define VARINT_MAX	10
+
+static uint8_t* put_varint(uint8_t* p, uint64_t v)
+{
+	while (v >= 0x80) {
+		*p++ = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t)v;
+	return p;
+}
+
+static uint64_t zigzag(int64_t d)
+{
+	return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static int has_alpha(int op)
+{
+	return op == RQ_OP_MULADD || op == RQ_OP_SCALE || op == RQ_OP_MULTI;
+}
+
+static int cmp_src(const void* a, const void* b)
+{
+	const uint32_t sa = ((const rq_op*)a)->src;
+	const uint32_t sb = ((const rq_op*)b)->src;
+	return (sa > sb) - (sa < sb);
+}
+
+size_t rq_ops_pack_bound(size_t n_ops)
+{
+	/* Tag, three varints and the multiplier per operation */
+	return n_ops * (2 + 3 * VARINT_MAX);
+}
+
+size_t rq_ops_pack(rq_op* ops, size_t n_ops, uint8_t* out)
+{
+	uint8_t* p = out;
+	int64_t prev_dst = 0, prev_src = 0, prev_load = 0;
+	size_t i = 0;
+	while (i < n_ops) {
+		const rq_op o = ops[i++];
+		const int alpha1 = (o.alpha == 1);
+		*p++ = (uint8_t)(o.op | (alpha1 ? FLAG_ALPHA1 : 0));
+		p = put_varint(p, zigzag(o.dst - prev_dst));
+		prev_dst = o.dst;
+		if (o.op == RQ_OP_LOAD) {
+			p = put_varint(p, zigzag(o.src - prev_load));
+			prev_load = o.src;
+		} else if (o.op != RQ_OP_ZERO && o.op != RQ_OP_SCALE) {
+			p = put_varint(p, zigzag(o.src - prev_src));
+			prev_src = o.src;
+		}
+		if (has_alpha(o.op) && !alpha1)
+			*p++ = o.alpha;
+		if (o.op != RQ_OP_MULTI)
+			continue;
+
+		size_t n_args = 0;
+		while (i + n_args < n_ops && ops[i + n_args].op == RQ_OP_ARG)
+			++n_args;
+		qsort(&ops[i], n_args, sizeof(rq_op), cmp_src);
+		p = put_varint(p, n_args);
+		for (; n_args > 0; --n_args) {
+			const rq_op a = ops[i++];
+			const int a1 = (a.alpha == 1);
+			p = put_varint(p, zigzag(a.src - prev_src) << 1 | a1);
+			prev_src = a.src;
+			if (!a1)
+				*p++ = a.alpha;
+		}
+	}
+	return p - out;
+}
+
+/* Read a varint; returns 0 if the data ends prematurely */
+static int get_varint(const uint8_t** pp, const uint8_t* end, uint64_t* v)
+{
+	const uint8_t* p = *pp;
+	uint64_t r = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (p == end)
+			return 0;
+		const uint8_t b = *p++;
+		r |= (uint64_t)(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			*pp = p;
+			*v = r;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Apply a zigzag coded difference to a row index; returns 0 if the
+ * result does not fit into max_bits bits.
+ */
+static int get_row(const uint8_t** pp, const uint8_t* end, int64_t* prev,
+			int max_bits)
+{
+	uint64_t v;
+	if (!get_varint(pp, end, &v))
+		return 0;
+	const int64_t r = *prev + unzigzag(v);
+	if (r < 0 || r >= ((int64_t)1 << max_bits))
+		return 0;
+	*prev = r;
+	return 1;
+}
+
+int rq_ops_unpack(const uint8_t* in, size_t in_size, rq_op* ops, size_t n_ops)
+{
+	const uint8_t* p = in;
+	const uint8_t* end = in + in_size;
+	int64_t prev_dst = 0, prev_src = 0, prev_load = 0;
+	size_t i = 0;
+	while (i < n_ops) {
+		if (p == end)
+			return -1;
+		const uint8_t tag = *p++;
+		rq_op o = { .op = tag & 0x07, .alpha = 1 };
+		if ((tag & ~(0x07 | FLAG_ALPHA1)) != 0 || o.op > RQ_OP_MULTI)
+			return -1;
+		if (!get_row(&p, end, &prev_dst, 16))
+			return -1;
+		o.dst = (uint16_t)prev_dst;
+		if (o.op == RQ_OP_LOAD) {
+			if (!get_row(&p, end, &prev_load, 32))
+				return -1;
+			o.src = (uint32_t)prev_load;
+		} else if (o.op != RQ_OP_ZERO && o.op != RQ_OP_SCALE) {
+			if (!get_row(&p, end, &prev_src, 32))
+				return -1;
+			o.src = (uint32_t)prev_src;
+		}
+		if (o.op == RQ_OP_LOAD || o.op == RQ_OP_ZERO)
+			o.alpha = 0;
+		if (has_alpha(o.op) && !(tag & FLAG_ALPHA1)) {
+			if (p == end)
+				return -1;
+			o.alpha = *p++;
+		}
+		ops[i++] = o;
+		if (o.op != RQ_OP_MULTI)
+			continue;
+
+		uint64_t n_args;
+		if (!get_varint(&p, end, &n_args) || n_args > n_ops - i)
+			return -1;
+		for (; n_args > 0; --n_args) {
+			uint64_t v;
+			if (!get_varint(&p, end, &v))
+				return -1;
+			const int64_t r = prev_src + unzigzag(v >> 1);
+			if (r < 0 || r > UINT32_MAX)
+				return -1;
+			prev_src = r;
+			rq_op a = { .src = (uint32_t)r, .dst = o.dst,
+					.op = RQ_OP_ARG, .alpha = 1 };
+			if (!(v & 1)) {
+				if (p == end)
+					return -1;
+				a.alpha = *p++;
+			}
+			ops[i++] = a;
+		}
+	}
+	return (p == end) ? 0 : -1;
+}
@@ -0,0 +1,49 @@
+#ifndef RQ_OPS_PACK_H
+#define RQ_OPS_PACK_H
+
+/**	@file rq_ops_pack.h
+ *
+ *	Compact encoding of row operation schedules.
+ *
+ *	Consecutive operations mostly refer to nearby rows, and most
+ *	multipliers are 1, so the schedule is stored as a byte stream
+ *	in which the row indices are delta coded as variable length
+ *	integers, multipliers of 1 are a flag bit, and the terms of a
+ *	MULTI operation are stored as a counted list without operation
+ *	codes.  This typically takes less than a third of the size of
+ *	the plain schedule.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rq_ops.h"
+
+/**	Upper bound on the packed size of a schedule of n_ops operations. */
+size_t rq_ops_pack_bound(size_t n_ops);
+
+/**	Pack a schedule.
+ *
+ *	The schedule must be well formed (see rq_ops_validate).  The
+ *	terms of each MULTI operation are sorted by source row in place;
+ *	this does not change what the schedule computes.
+ *
+ *	@param	out
+ *		Buffer of at least rq_ops_pack_bound(n_ops) bytes.
+ *
+ *	@return	The number of bytes written.
+ */
+size_t rq_ops_pack(rq_op* ops, size_t n_ops, uint8_t* out);
+
+/**	Unpack a schedule of exactly n_ops operations.
+ *
+ *	The packed data is checked to be complete and consistent, but
+ *	the resulting schedule is not validated; use rq_ops_validate for
+ *	that.  The unused dst of ARG operations is set to the dst of the
+ *	MULTI operation.
+ *
+ *	@return	0 on success, or -1 if the data is corrupt.
+ */
+int rq_ops_unpack(const uint8_t* in, size_t in_size, rq_op* ops, size_t n_ops);
+
+#endif /* RQ_OPS_PACK_H */
@@ -0,0 +1,182 @@
+#include <assert.h>
+#include <string.h>
+
+#include "gf256.h"
+#include "hdpc.h"
+#include "ldpc.h"
+#include "lt.h"
+#include "rq_stream.h"
+
+size_t rq_stream_mem_size(const parameters* P, size_t sym_size)
+{
+	return sizeof(int) * P->L + (size_t)P->L * (P->L + sym_size);
+}
+
+/* Number of pivot rows subtracted from a new row at once; at least
+ * LT_MAX_ROW_WEIGHT.
+ */
+#define ELIM_BATCH	64
+
+/* First column c >= c0 and < end in which row r is nonzero, or end */
+static int next_nonzero(const m256v* A, int r, int c0, int end)
+{
+	const uint8_t* row = A->e + m256v_get_el_offs(A, r, 0);
+	int c = c0;
+	for (; c < end && (c & 7) != 0; ++c) {
+		if (row[c] != 0)
+			return c;
+	}
+
+	/* Skip the zeros a word at a time */
+	for (; c + 8 <= end; c += 8) {
+		uint64_t w;
+		memcpy(&w, row + c, sizeof(w));
+		if (w != 0)
+			break;
+	}
+	for (; c < end; ++c) {
+		if (row[c] != 0)
+			return c;
+	}
+	return end;
+}
+
+/* Eliminate the row in the first free slot (row s->rank) against the
+ * pivot rows.  If it is independent, make it the pivot row of its
+ * first nonzero column, and eliminate that column from the others.
+ *
+ * If cols is not NULL, the row is an LT row, whose nonzeros, all 1,
+ * are in the n_cols columns listed; otherwise, the row is scanned.
+ *
+ * The pivot rows are zero in the other pivot columns, so subtracting
+ * them does not change the entries of the row in the pivot columns,
+ * and they can be subtracted in one go.  They are also zero left of
+ * their pivot, so the row stays zero left of its first nonzero, and
+ * its pivot column can be eliminated from the others starting there.
+ */
+static int eliminate(rq_stream* s, const int* cols, int n_cols)
+{
+	m256v* A = &s->A;
+	const int L = s->P.L;
+	const int r = s->rank;
+	int rows[ELIM_BATCH];
+	uint8_t alphas[ELIM_BATCH];
+	int n = 0;
+	int c_min = 0;
+	if (cols != NULL) {
+		c_min = L;
+		for (int i = 0; i < n_cols; ++i) {
+			if (cols[i] < c_min)
+				c_min = cols[i];
+			const int p = s->piv_row[cols[i]];
+			if (p >= 0) {
+				rows[n] = p;
+				alphas[n++] = 1;
+			}
+		}
+	} else {
+		for (int c = 0; (c = next_nonzero(A, r, c, L)) < L; ++c) {
+			const int p = s->piv_row[c];
+			if (p < 0)
+				continue;
+			rows[n] = p;
+			alphas[n] = m256v_get_el(A, r, c);
+			if (++n == ELIM_BATCH) {
+				m256v_multadd_rows(A, rows, alphas, n, A, r);
+				n = 0;
+			}
+		}
+	}
+	if (n > 0)
+		m256v_multadd_rows(A, rows, alphas, n, A, r);
+
+	/* The pivot columns are zero now */
+	const int c_new = next_nonzero(A, r, c_min, L);
+	if (c_new == L)
+		return 0;
+
+	m256v_mult_row(A, r, gf256_inv(m256v_get_el(A, r, c_new)));
+	for (int p = 0; p < r; ++p) {
+		const uint8_t a = m256v_get_el(A, p, c_new);
+		if (a != 0)
+			m256v_multadd_row_from(A, r, c_new, a, A, p);
+	}
+	s->piv_row[c_new] = r;
+	++s->rank;
+	return 1;
+}
+
+/* Write the LT row of an ISI into the first free slot, followed by
+ * the symbol; a NULL symbol is zero.  Then eliminate it.
+ */
+static int add_lt_row(rq_stream* s, uint32_t ISI, const uint8_t* sym)
+{
+	m256v* A = &s->A;
+	const int L = s->P.L;
+	int cols[LT_MAX_ROW_WEIGHT];
+	const int n = lt_get_row(&s->P, ISI, cols);
+
+	m256v_clear_row(A, s->rank);
+	for (int i = 0; i < n; ++i)
+		m256v_set_el(A, s->rank, cols[i], 1);
+	if (sym != NULL) {
+		memcpy(A->e + m256v_get_el_offs(A, s->rank, L), sym,
+			A->n_col - L);
+	}
+	return eliminate(s, cols, n);
+}
+
+void rq_stream_init(rq_stream* s, const parameters* P, size_t sym_size,
+			void* mem)
+{
+	const int L = P->L;
+	s->P = *P;
+	s->rank = 0;
+	s->piv_row = mem;
+	for (int c = 0; c < L; ++c)
+		s->piv_row[c] = -1;
+	s->A = m256v_make(L, L + sym_size, (uint8_t*)(s->piv_row + L));
+
+	/* The LDPC and HDPC rows are generated into the last rows, and
+	 * moved to the first free slot one by one.  The slots never
+	 * catch up with them, as every row fills at most one.
+	 */
+	const int n_c = P->S + P->H;
+	m256v C = m256v_get_subview(&s->A, L - n_c, 0, n_c, s->A.n_col);
+	m256v_clear(&C);
+	m256v LDPC = m256v_get_subview(&s->A, L - n_c, 0, P->S, L);
+	ldpc_generate_mat(&LDPC, P);
+	m256v HDPC = m256v_get_subview(&s->A, L - P->H, 0, P->H, L);
+	hdpc_generate_mat(&HDPC, P);
+	for (int i = 0; i < n_c; ++i) {
+		assert(s->rank <= L - n_c + i);
+		if (s->rank != L - n_c + i)
+			m256v_copy_row(&s->A, L - n_c + i, &s->A, s->rank);
+		eliminate(s, NULL, 0);
+	}
+
+	/* The padding symbols are zero */
+	for (int ISI = P->K; ISI < P->Kprime; ++ISI)
+		add_lt_row(s, ISI, NULL);
+}
+
+int rq_stream_add(rq_stream* s, uint32_t ESI, const uint8_t* sym)
+{
+	if (s->rank == s->P.L)
+		return 0;
+	const uint32_t ISI = ESI + (ESI >= (uint32_t)s->P.K
+					? s->P.Kprime - s->P.K : 0);
+	return add_lt_row(s, ISI, sym);
+}
+
+void rq_stream_get_inter(const rq_stream* s, uint8_t* inter)
+{
+	const m256v* A = &s->A;
+	const int L = s->P.L;
+	const size_t T = A->n_col - L;
+	assert(s->rank == L);
+	for (int c = 0; c < L; ++c) {
+		memcpy(inter + c * T,
+			A->e + m256v_get_el_offs(A, s->piv_row[c], L), T);
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef RQ_STREAM_H
+#define RQ_STREAM_H
+
+/**	@file rq_stream.h
+ *
+ *	Incremental solution of the RQ system as symbols arrive.
+ *
+ *	Every received symbol, together with its row of the RQ matrix,
+ *	is eliminated against the symbols kept so far right away, so
+ *	that the matrix stays in reduced row echelon form.  Symbols that
+ *	turn out linearly dependent are dropped, so that at most L rows
+ *	are ever stored, and once the rank reaches L, the symbol part of
+ *	the rows is the intermediate block.
+ *
+ *	The LDPC, HDPC and padding rows, which are known in advance,
+ *	are eliminated at initialization.
+ *
+ *	The rows are dense:  The state takes L * (L + T) bytes, and the
+ *	total work is O(L^2 (L + T)), so this suits moderate K.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "m256v.h"
+#include "parameters.h"
+
+typedef struct {
+	parameters P;
+	int rank;
+	int* piv_row;		/**< Row with the pivot in a column, or -1 */
+	m256v A;		/**< L rows [ coefficients | symbol ] */
+} rq_stream;
+
+/**	Size of the memory needed by rq_stream_init. */
+size_t rq_stream_mem_size(const parameters* P, size_t sym_size);
+
+/**	Initialize the state in mem, and eliminate the rows known in
+ *	advance.
+ *
+ *	@param	mem
+ *		Memory of at least rq_stream_mem_size() bytes, which
+ *		must remain available while the state is in use.
+ */
+void rq_stream_init(rq_stream* s, const parameters* P, size_t sym_size,
+			void* mem);
+
+/**	Add the symbol with the given ESI.
+ *
+ *	@return	1 if the symbol increased the rank, 0 if it was linearly
+ *		dependent on the symbols added before (or the rank was
+ *		L already).
+ */
+int rq_stream_add(rq_stream* s, uint32_t ESI, const uint8_t* sym);
+
+/**	Copy the intermediate block out.
+ *
+ *	Requires the rank to be L.
+ */
+void rq_stream_get_inter(const rq_stream* s, uint8_t* inter);
+
+#endif /* RQ_STREAM_H */